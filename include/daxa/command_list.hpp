@@ -39,6 +39,20 @@ namespace daxa
         usize size = {};
     };
 
+    struct BufferCopyRegion
+    {
+        usize src_offset = {};
+        usize dst_offset = {};
+        usize size = {};
+    };
+
+    struct BufferRegionsCopyInfo
+    {
+        BufferId src_buffer = {};
+        BufferId dst_buffer = {};
+        std::span<BufferCopyRegion const> regions = {};
+    };
+
     struct BufferImageCopyInfo
     {
         BufferId buffer = {};
@@ -193,6 +207,28 @@ namespace daxa
         u32 count = {};
     };
 
+    struct BeginQueryInfo
+    {
+        QueryPool & query_pool;
+        u32 query_index = {};
+        // Occlusion queries only, returns exact sample counts instead of possibly only zero or non zero.
+        // Requires Device::precise_occlusion_queries_enabled.
+        bool precise = {};
+    };
+
+    struct EndQueryInfo
+    {
+        QueryPool & query_pool;
+        u32 query_index = {};
+    };
+
+    struct ResetQueriesInfo
+    {
+        QueryPool & query_pool;
+        u32 start_index = {};
+        u32 count = {};
+    };
+
     struct CommandLabelInfo
     {
         std::string label_name = {};
@@ -226,6 +262,9 @@ namespace daxa
         CommandList() = default;
 
         void copy_buffer_to_buffer(BufferCopyInfo const & info);
+        /// @brief  Copies all regions with a single copy command.
+        ///         The destination regions must not overlap each other.
+        void copy_buffer_to_buffer_regions(BufferRegionsCopyInfo const & info);
         void copy_buffer_to_image(BufferImageCopyInfo const & info);
         void copy_image_to_buffer(ImageBufferCopyInfo const & info);
         void copy_image_to_image(ImageCopyInfo const & info);
@@ -295,6 +334,23 @@ namespace daxa
         void set_viewport(ViewportInfo const & info);
         void set_scissor(Rect2D const & info);
         void set_depth_bias(DepthBiasInfo const & info);
+        /// @brief  Setters for the RasterDynamicStateFlagBits of the bound raster pipeline.
+        ///         Must be called after set_pipeline, binding a pipeline resets its dynamic state.
+        void set_depth_test_enable(bool enable);
+        void set_depth_write_enable(bool enable);
+        void set_depth_compare_op(CompareOp op);
+        void set_cull_mode(FaceCullFlags face_culling);
+        void set_front_face(FrontFaceWinding winding);
+        void set_primitive_topology(PrimitiveTopology topology);
+        void set_primitive_restart_enable(bool enable);
+        void set_depth_bias_enable(bool enable);
+        /// @brief  Requires extended dynamic state 3 or shader objects.
+        void set_polygon_mode(PolygonMode mode);
+        /// @brief  Sets blend enable, blend equation and color write mask of the color attachments starting at first_attachment.
+        ///         Requires extended dynamic state 3 or shader objects.
+        void set_color_blend(u32 first_attachment, std::span<BlendInfo const> blends);
+        /// @brief  Requires extended dynamic state 3 or shader objects.
+        void set_depth_clamp_enable(bool enable);
         void set_index_buffer(BufferId id, usize offset, usize index_type_byte_size = sizeof(u32));
 
         void draw(DrawInfo const & info);
@@ -308,6 +364,11 @@ namespace daxa
         void write_timestamp(WriteTimestampInfo const & info);
         void reset_timestamps(ResetTimestampsInfo const & info);
 
+        /// @brief  Queries must be reset before they are begun again.
+        void begin_query(BeginQueryInfo const & info);
+        void end_query(EndQueryInfo const & info);
+        void reset_queries(ResetQueriesInfo const & info);
+
         void begin_label(CommandLabelInfo const & info);
         void end_label();
 
@@ -10,3 +10,4 @@
 #include <daxa/device.hpp>
 #include <daxa/instance.hpp>
 #include <daxa/timeline_query.hpp>
+#include <daxa/trace.hpp>
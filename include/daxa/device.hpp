@@ -196,13 +196,131 @@ namespace daxa
         bool enable_buffer_device_address_capture_replay = true;
         bool enable_conservative_rasterization = false;
         bool enable_mesh_shader = false;
+        bool enable_sparse_resources = false;
+        // Raster pipelines are created as one VK_EXT_shader_object shader per stage instead of a VkPipeline, when the device supports it.
+        // All raster state is then set dynamically in CommandList::set_pipeline, so creating a raster pipeline does not require a link step.
+        // Falls back to regular pipelines when the extension is not available.
+        bool enable_shader_object = false;
+        // Enables VK_EXT_extended_dynamic_state3 when supported, required for the polygon mode, color blend and depth clamp RasterDynamicStateFlagBits.
+        bool enable_extended_dynamic_state_3 = false;
+        // Raster pipelines are fast linked from VK_EXT_graphics_pipeline_library parts when supported.
+        // The vertex input, pre rasterization, fragment shader and fragment output parts are cached by the device and shared between pipelines.
+        // An optimized pipeline is linked in the background and replaces the fast linked one once ready.
+        // Shader objects take precedence when both are enabled.
+        bool enable_graphics_pipeline_library = false;
         // Make sure your device actually supports the max numbers, as device creation will fail otherwise.
         u32 max_allowed_images = 10'000;
         u32 max_allowed_buffers = 10'000;
         u32 max_allowed_samplers = 1'000;
+        // When set, the pipeline cache is loaded from this file at device creation and written back when the device is destroyed.
+        // Files written for another driver or device are ignored.
+        std::filesystem::path pipeline_cache_path = {};
+        // Runs the pipeline creations of create_compute_pipeline_async and create_raster_pipeline_async, and the optimized links of graphics pipeline library pipelines.
+        // When empty, the device starts its own worker threads on the first async creation.
+        // The device waits until every job handed to the executor was either run or destroyed before the device itself is destroyed.
+        std::function<void(std::function<void()>)> pipeline_compile_executor = {};
+        // Worker thread count of the device owned pool. Zero uses half the hardware threads.
+        u32 pipeline_compile_thread_count = {};
         std::string name = {};
     };
 
+    struct MemoryHeapStatistics
+    {
+        /// @brief  Estimated amount of memory the process can use from this heap.
+        ///         Only accurate when the driver supports VK_EXT_memory_budget, otherwise 80% of the heap size.
+        usize budget = {};
+        /// @brief  Estimated amount of memory the process currently uses from this heap, including memory not allocated by daxa.
+        usize usage = {};
+        /// @brief  Bytes of all memory blocks daxa allocated from this heap.
+        usize block_bytes = {};
+        /// @brief  Bytes of all allocations daxa placed into memory blocks of this heap.
+        usize allocation_bytes = {};
+        u32 block_count = {};
+        u32 allocation_count = {};
+        bool device_local = {};
+    };
+
+    struct ResourceMemoryStatistics
+    {
+        u32 count = {};
+        usize bytes = {};
+    };
+
+    struct DeviceMemoryStatistics
+    {
+        std::vector<MemoryHeapStatistics> heaps = {};
+        /// @brief  Device local buffers.
+        ResourceMemoryStatistics buffers = {};
+        /// @brief  Buffers that are mapped to host memory, this includes staging memory like TransferMemoryPool.
+        ResourceMemoryStatistics host_accessible_buffers = {};
+        ResourceMemoryStatistics images = {};
+        /// @brief  Memory blocks created with create_memory, this includes transient memory of task graphs.
+        ResourceMemoryStatistics memory_blocks = {};
+        /// @brief  Free ranges between allocations within all memory blocks.
+        u32 unused_range_count = {};
+        usize unused_range_bytes = {};
+        usize largest_unused_range = {};
+        /// @brief  0 when all unused memory is one contiguous range, approaching 1 the more the unused memory is split up.
+        f32 fragmentation = {};
+    };
+
+    struct DefragmentInfo
+    {
+        /// @brief  Budget of a single pass. Only read when a new defragmentation starts.
+        usize max_bytes_per_pass = 64'000'000;
+        u32 max_moves_per_pass = 64;
+    };
+
+    struct DefragmentResult
+    {
+        u32 moved_buffers = {};
+        usize moved_bytes = {};
+        /// @brief  A pass is still in flight on the gpu, the next pass starts once it finished.
+        bool pass_pending = {};
+        /// @brief  Nothing is left to move, the next call starts a new defragmentation.
+        bool complete = {};
+    };
+
+    struct SparseBufferBind
+    {
+        BufferId buffer = {};
+        usize first_page = {};
+        usize page_count = 1;
+        /// @brief  true binds new memory to the pages, false unbinds the pages and frees their memory.
+        bool resident = true;
+    };
+
+    struct SparseImageBind
+    {
+        ImageId image = {};
+        u32 mip_level = {};
+        u32 array_layer = {};
+        /// @brief  In tiles. Ignored for mip levels in the mip tail, the mip tail is always bound as a whole.
+        Offset3D first_tile = {};
+        Extent3D tile_count = {1, 1, 1};
+        bool resident = true;
+    };
+
+    struct SparseBindInfo
+    {
+        std::vector<SparseBufferBind> buffer_binds = {};
+        std::vector<SparseImageBind> image_binds = {};
+        std::vector<std::pair<TimelineSemaphore, u64>> wait_timeline_semaphores = {};
+        std::vector<std::pair<TimelineSemaphore, u64>> signal_timeline_semaphores = {};
+    };
+
+    struct SparseResidency
+    {
+        /// @brief  Bytes of memory backing one page.
+        usize page_size = {};
+        /// @brief  Texels covered by one page of an image.
+        Extent3D tile_extent = {};
+        /// @brief  First mip level of the mip tail of an image.
+        u32 mip_tail_first_lod = {};
+        usize page_count = {};
+        usize resident_page_count = {};
+    };
+
     struct CommandSubmitInfo
     {
         PipelineStageFlags src_stages = {};
@@ -227,6 +345,8 @@ namespace daxa
         auto get_memory_requirements(BufferInfo const & info) -> MemoryRequirements;
         auto get_memory_requirements(ImageInfo const & info) -> MemoryRequirements;
 
+        /// @brief  The storage buffer descriptor of a buffer covers at most DeviceLimits::max_storage_buffer_range bytes.
+        ///         Larger buffers are accessed completely through their device address.
         auto create_buffer(BufferInfo const & info) -> BufferId;
         auto create_image(ImageInfo const & info) -> ImageId;
         auto create_image_view(ImageViewInfo const & info) -> ImageViewId;
@@ -257,6 +377,12 @@ namespace daxa
 
         auto create_raster_pipeline(RasterPipelineInfo const & info) -> RasterPipeline;
         auto create_compute_pipeline(ComputePipelineInfo const & info) -> ComputePipeline;
+        /// @brief  Creates the pipeline on a worker thread, or the executor given in the DeviceInfo, and returns immediately.
+        ///         The shader byte code is copied, it does not need to outlive the call.
+        ///         The device must not be destroyed while creations are still running. Pending creations are abandoned at destruction.
+        ///         Without DAXA_THREADSAFETY the pipeline is created immediately on the calling thread.
+        auto create_raster_pipeline_async(RasterPipelineInfo const & info) -> AsyncRasterPipeline;
+        auto create_compute_pipeline_async(ComputePipelineInfo const & info) -> AsyncComputePipeline;
 
         auto create_swapchain(SwapchainInfo const & info) -> Swapchain;
         auto create_command_list(CommandListInfo const & info) -> CommandList;
@@ -264,10 +390,54 @@ namespace daxa
         auto create_timeline_semaphore(TimelineSemaphoreInfo const & info) -> TimelineSemaphore;
         auto create_split_barrier(SplitBarrierInfo const & info) -> SplitBarrierState;
         auto create_timeline_query_pool(TimelineQueryPoolInfo const & info) -> TimelineQueryPool;
+        auto create_query_pool(QueryPoolInfo const & info) -> QueryPool;
+
+        /// @brief  Gathers memory budgets, usage and fragmentation of all memory heaps as well as memory usage per resource type.
+        ///         Walks all allocations internally, this is not meant to be called every frame.
+        auto memory_statistics() const -> DeviceMemoryStatistics;
+        /// @brief  Returns a json dump of all memory blocks and allocations, as produced by vmaBuildStatsString.
+        /// @param detailed_map also lists every single allocation and unused range within each memory block.
+        auto memory_statistics_json(bool detailed_map = false) const -> std::string;
+        /// @brief  Runs one incremental defragmentation pass, moving at most the budget given in info.
+        ///         Moved buffers keep their ids. Their descriptors and device addresses are rewritten to the new location.
+        ///         The copies are submitted to the main queue, the old buffers are destroyed when the gpu finished them.
+        ///         Only device local buffers with automatic allocation are moved. Images, memory blocks and host accessible buffers stay in place.
+        ///         A pass that moves buffers waits for all previous submissions to finish before it submits its copies, so call it between frames.
+        ///         Calls that find nothing to move or a pass still in flight return without waiting.
+        ///         Must not be called while any command list is recorded or waiting for submission, on any thread.
+        auto defragment(DefragmentInfo const & info) -> DefragmentResult;
+
+        /// @brief  Binds or unbinds memory pages of sparse buffers and images on the main queue.
+        ///         The binds wait for all previous submissions and all following submissions wait for the binds.
+        ///         Memory of unbound pages is freed once the gpu reached the bind.
+        ///         Binds to the same resource must not be issued from multiple threads at once.
+        void bind_sparse_memory(SparseBindInfo const & info);
+        /// @brief  Merges the pipeline cache with the current content of the cache file and atomically replaces the file.
+        ///         Other processes writing the same file only add to it.
+        /// @return false if no cache path was set or the file could not be written.
+        auto write_pipeline_cache() -> bool;
+        auto sparse_residency(BufferId id) const -> SparseResidency;
+        auto sparse_residency(ImageId id) const -> SparseResidency;
 
         auto info() const -> DeviceInfo const &;
         auto properties() const -> DeviceProperties const &;
         auto mesh_shader_properties() const -> MeshShaderDeviceProperties const &;
+        /// @brief  True when the device supports precise occlusion queries, required for BeginQueryInfo::precise.
+        auto precise_occlusion_queries_enabled() const -> bool;
+        /// @brief  True when the device supports pipeline statistics queries, required for QueryType::PIPELINE_STATISTICS query pools.
+        auto pipeline_statistics_queries_enabled() const -> bool;
+        /// @brief  True when the device supports sparse binding and sparse residency of buffers and 2d images on the main queue,
+        ///         required for DeviceInfo::enable_sparse_resources. Also reported by devices created without it.
+        auto sparse_resources_supported() const -> bool;
+        /// @brief  True when DeviceInfo::enable_shader_object was set and the device supports VK_EXT_shader_object.
+        auto shader_object_enabled() const -> bool;
+        /// @brief  True when DeviceInfo::enable_extended_dynamic_state_3 was set and the device supports all dynamic states daxa uses from it.
+        auto extended_dynamic_state_3_enabled() const -> bool;
+        /// @brief  True when DeviceInfo::enable_graphics_pipeline_library was set and the device supports VK_EXT_graphics_pipeline_library.
+        auto graphics_pipeline_library_enabled() const -> bool;
+        /// @brief  Number of graphics pipeline library parts currently cached by the device.
+        ///         A part is evicted once no pipeline linked from it and no optimized link using it remain.
+        auto pipeline_library_count() -> u32;
         void wait_idle();
 
         void submit_commands(CommandSubmitInfo const & submit_info);
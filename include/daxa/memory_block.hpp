@@ -35,5 +35,11 @@ namespace daxa
         usize offset = {};
     };
 
-    using AllocateInfo = std::variant<AutoAllocInfo, ManualAllocInfo>;
+    /// @brief  Only reserves address space. Memory is bound page by page with Device::bind_sparse_memory.
+    ///         Requires DeviceInfo::enable_sparse_resources.
+    struct SparseAllocInfo
+    {
+    };
+
+    using AllocateInfo = std::variant<AutoAllocInfo, ManualAllocInfo, SparseAllocInfo>;
 } // namespace daxa
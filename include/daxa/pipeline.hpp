@@ -2,14 +2,25 @@
 
 #include <daxa/core.hpp>
 
+#include <future>
+
 namespace daxa
 {
     using ShaderByteCode = std::span<u32 const>;
 
+    /// @brief  Value of a shader constant declared with layout(constant_id = X), applied at pipeline creation.
+    ///         Bools are passed as VkBool32. Only 32 bit constants are supported.
+    struct ShaderSpecializationConstant
+    {
+        u32 constant_id = {};
+        std::variant<u32, i32, f32, bool> value = u32{};
+    };
+
     struct ShaderInfo
     {
         ShaderByteCode byte_code = {};
         std::optional<std::string> entry_point = {};
+        std::vector<ShaderSpecializationConstant> specialization_constants = {};
     };
 
     struct ComputePipelineInfo
@@ -76,6 +87,33 @@ namespace daxa
         TesselationDomainOrigin origin = {};
     };
 
+    struct RasterDynamicStateFlagsProperties
+    {
+        using Data = u32;
+    };
+    using RasterDynamicStateFlags = Flags<RasterDynamicStateFlagsProperties>;
+    /// @brief  Raster state that is not baked into the pipeline but set with the matching CommandList setters after set_pipeline.
+    ///         The state must be set before the first draw after binding the pipeline.
+    struct RasterDynamicStateFlagBits
+    {
+        static inline constexpr RasterDynamicStateFlags NONE = {0x00000000};
+        /// @brief  Depth test enable, depth write enable and the compare op.
+        static inline constexpr RasterDynamicStateFlags DEPTH_TEST = {0x00000001};
+        static inline constexpr RasterDynamicStateFlags CULL_MODE = {0x00000002};
+        static inline constexpr RasterDynamicStateFlags FRONT_FACE = {0x00000004};
+        /// @brief  Without extended dynamic state 3, only topologies of the same class (points, lines, triangles, patches) may be set.
+        static inline constexpr RasterDynamicStateFlags PRIMITIVE_TOPOLOGY = {0x00000008};
+        static inline constexpr RasterDynamicStateFlags PRIMITIVE_RESTART_ENABLE = {0x00000010};
+        static inline constexpr RasterDynamicStateFlags DEPTH_BIAS_ENABLE = {0x00000020};
+        /// @brief  Requires Device::extended_dynamic_state_3_enabled.
+        static inline constexpr RasterDynamicStateFlags POLYGON_MODE = {0x00000040};
+        /// @brief  Blend enable, blend equation and color write mask of all color attachments.
+        ///         Requires Device::extended_dynamic_state_3_enabled.
+        static inline constexpr RasterDynamicStateFlags COLOR_BLEND = {0x00000080};
+        /// @brief  Requires Device::extended_dynamic_state_3_enabled.
+        static inline constexpr RasterDynamicStateFlags DEPTH_CLAMP_ENABLE = {0x00000100};
+    };
+
     struct RasterPipelineInfo
     {
         std::optional<ShaderInfo> mesh_shader_info = {};
@@ -88,6 +126,8 @@ namespace daxa
         DepthTestInfo depth_test = {};
         RasterizerInfo raster = {};
         TesselationInfo tesselation = {};
+        /// @brief  The values in depth_test, raster and color_attachments for this state are only used as defaults by shader object pipelines.
+        RasterDynamicStateFlags dynamic_state = RasterDynamicStateFlagBits::NONE;
         u32 push_constant_size = {};
         std::string name = {};
     };
@@ -103,4 +143,36 @@ namespace daxa
         friend struct CommandList;
         explicit RasterPipeline(ManagedPtr impl);
     };
+
+    /// @brief  Handle to a pipeline that is created on another thread.
+    ///         Copies refer to the same pipeline.
+    template <typename PipelineT>
+    struct AsyncPipeline
+    {
+        AsyncPipeline() = default;
+        explicit AsyncPipeline(std::shared_future<PipelineT> a_future) : future{std::move(a_future)} {}
+
+        /// @brief  Never blocks.
+        auto is_ready() const -> bool
+        {
+            return future.valid() && future.wait_for(std::chrono::seconds{0}) == std::future_status::ready;
+        }
+        /// @brief  Never blocks.
+        /// @return nullptr while the pipeline is not yet created, so that draws or dispatches using it can be skipped or substituted.
+        auto try_get() const -> PipelineT const *
+        {
+            return is_ready() ? &future.get() : nullptr;
+        }
+        /// @brief  Blocks until the pipeline is created.
+        auto get() const -> PipelineT const &
+        {
+            return future.get();
+        }
+
+      private:
+        std::shared_future<PipelineT> future = {};
+    };
+
+    using AsyncComputePipeline = AsyncPipeline<ComputePipeline>;
+    using AsyncRasterPipeline = AsyncPipeline<RasterPipeline>;
 } // namespace daxa
@@ -17,9 +17,76 @@ namespace daxa
         auto info() const -> TimelineQueryPoolInfo const &;
 
         auto get_query_results(u32 start_index, u32 count) -> std::vector<u64>;
+        /// @brief  Non-allocating, non-blocking variant of get_query_results.
+        ///         Writes pairs of (timestamp, availability) for each query into results.
+        /// @param results must hold at least count * 2 values.
+        /// @return true if all queried timestamps were available.
+        auto get_query_results(u32 start_index, u32 count, std::span<u64> results) -> bool;
 
       private:
         friend struct Device;
         explicit TimelineQueryPool(ManagedPtr impl);
     };
+
+    // NOTE: Timestamps are handled by the TimelineQueryPool.
+    enum struct QueryType
+    {
+        OCCLUSION = 0,
+        PIPELINE_STATISTICS = 1,
+        MAX_ENUM = 0x7fffffff,
+    };
+
+    struct PipelineStatisticFlagsProperties
+    {
+        using Data = u32;
+    };
+    using PipelineStatisticFlags = Flags<PipelineStatisticFlagsProperties>;
+    struct PipelineStatisticFlagBits
+    {
+        static inline constexpr PipelineStatisticFlags NONE = {0x00000000};
+        static inline constexpr PipelineStatisticFlags INPUT_ASSEMBLY_VERTICES = {0x00000001};
+        static inline constexpr PipelineStatisticFlags INPUT_ASSEMBLY_PRIMITIVES = {0x00000002};
+        static inline constexpr PipelineStatisticFlags VERTEX_SHADER_INVOCATIONS = {0x00000004};
+        static inline constexpr PipelineStatisticFlags GEOMETRY_SHADER_INVOCATIONS = {0x00000008};
+        static inline constexpr PipelineStatisticFlags GEOMETRY_SHADER_PRIMITIVES = {0x00000010};
+        static inline constexpr PipelineStatisticFlags CLIPPING_INVOCATIONS = {0x00000020};
+        static inline constexpr PipelineStatisticFlags CLIPPING_PRIMITIVES = {0x00000040};
+        static inline constexpr PipelineStatisticFlags FRAGMENT_SHADER_INVOCATIONS = {0x00000080};
+        static inline constexpr PipelineStatisticFlags TESSELLATION_CONTROL_SHADER_PATCHES = {0x00000100};
+        static inline constexpr PipelineStatisticFlags TESSELLATION_EVALUATION_SHADER_INVOCATIONS = {0x00000200};
+        static inline constexpr PipelineStatisticFlags COMPUTE_SHADER_INVOCATIONS = {0x00000400};
+    };
+
+    struct QueryPoolInfo
+    {
+        // PIPELINE_STATISTICS requires Device::pipeline_statistics_queries_enabled.
+        QueryType query_type = QueryType::OCCLUSION;
+        // Only used when query_type is PIPELINE_STATISTICS.
+        PipelineStatisticFlags pipeline_statistics = {};
+        u32 query_count = {};
+        std::string name = {};
+    };
+
+    struct QueryPool : ManagedPtr
+    {
+        QueryPool() = default;
+
+        auto info() const -> QueryPoolInfo const &;
+
+        /// @brief  The number of u64 values written per query by get_query_results.
+        ///         Occlusion queries write one sample count, pipeline statistics queries write one value per enabled statistic.
+        ///         In both cases the values are followed by one availability value.
+        auto result_stride() const -> u32;
+        /// @brief  Reads back query results without blocking the cpu.
+        ///         Results of queries that are not yet available are left unspecified, their availability value is 0.
+        /// @param results must hold at least count * result_stride() values.
+        /// @return true if all queried results were available.
+        auto get_query_results(u32 start_index, u32 count, std::span<u64> results) -> bool;
+        /// @brief  Checks if the result of a single query is available without blocking the cpu.
+        auto is_query_available(u32 index) -> bool;
+
+      private:
+        friend struct Device;
+        explicit QueryPool(ManagedPtr impl);
+    };
 } // namespace daxa
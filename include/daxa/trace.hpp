@@ -0,0 +1,48 @@
+#pragma once
+
+#include <daxa/core.hpp>
+
+#if !defined(DAXA_TRACING)
+#define DAXA_TRACING 0
+#endif
+
+namespace daxa
+{
+    /// @brief  Returns all cpu trace events recorded so far as a chrome trace json string.
+    ///         The result can be opened in chrome://tracing or ui.perfetto.dev.
+    ///         Returns an empty trace when daxa is built without DAXA_TRACING.
+    auto get_chrome_trace() -> std::string;
+    /// @brief  Writes the chrome trace json to the given path.
+    /// @return false if the file could not be written.
+    auto write_chrome_trace(std::filesystem::path const & path) -> bool;
+    /// @brief  Discards all recorded trace events.
+    ///         Must not be called while other threads are recording trace events.
+    void clear_trace();
+
+#if DAXA_TRACING
+    static inline constexpr usize TRACE_EVENT_NAME_SIZE = 64;
+
+    /// @brief  Records the cpu time between its construction and destruction into the trace buffer of the current thread.
+    ///         Recording never locks, each thread writes into its own buffer.
+    ///         The name is copied and truncated to TRACE_EVENT_NAME_SIZE - 1 characters.
+    struct TraceScope
+    {
+        TraceScope(std::string_view a_name);
+        TraceScope(TraceScope const &) = delete;
+        TraceScope & operator=(TraceScope const &) = delete;
+        ~TraceScope();
+
+      private:
+        std::array<char, TRACE_EVENT_NAME_SIZE> name = {};
+        u64 begin_ns = {};
+    };
+#endif
+} // namespace daxa
+
+#if DAXA_TRACING
+#define DAXA_TRACE_CONCAT_IMPL(a, b) a##b
+#define DAXA_TRACE_CONCAT(a, b) DAXA_TRACE_CONCAT_IMPL(a, b)
+#define DAXA_TRACE_SCOPE(NAME) daxa::TraceScope const DAXA_TRACE_CONCAT(daxa_trace_scope_, __LINE__){NAME}
+#else
+#define DAXA_TRACE_SCOPE(NAME)
+#endif
@@ -0,0 +1,132 @@
+#pragma once
+
+#if !DAXA_BUILT_WITH_UTILS_GPU_PROFILER
+#error "[package management error] You must build Daxa with the DAXA_ENABLE_UTILS_GPU_PROFILER CMake option enabled, or request the utils-gpu-profiler feature in vcpkg"
+#endif
+
+#include <daxa/core.hpp>
+#include <daxa/device.hpp>
+
+#include <deque>
+#include <unordered_map>
+
+namespace daxa
+{
+    struct GpuProfilerInfo
+    {
+        Device device = {};
+        // Number of frames that can be recorded before the results of the oldest one must be read back.
+        // Frames recorded while all slots are still waiting on the gpu are not profiled.
+        u32 frames_in_flight = 3;
+        u32 max_scopes_per_frame = 256;
+        // Number of frames the rolling statistics are calculated over.
+        u32 history_length = 128;
+        std::string name = {};
+    };
+
+    struct GpuProfilerScopeStatistics
+    {
+        f64 average_ms = {};
+        f64 min_ms = {};
+        f64 max_ms = {};
+        f64 p50_ms = {};
+        f64 p95_ms = {};
+        f64 p99_ms = {};
+        u32 sample_count = {};
+    };
+
+    struct GpuProfilerScope
+    {
+        std::string name = {};
+        // Names of all parent scopes and this scope, separated by '/'.
+        std::string path = {};
+        // Scopes are stored in pre-order, root scopes have no parent.
+        static inline constexpr u32 NO_PARENT = ~0u;
+        u32 parent_index = NO_PARENT;
+        u32 depth = {};
+        f64 duration_ms = {};
+        GpuProfilerScopeStatistics statistics = {};
+    };
+
+    struct GpuProfilerFrame
+    {
+        u64 frame_index = {};
+        std::vector<GpuProfilerScope> scopes = {};
+    };
+
+    /// @brief  Measures the gpu time of nested label scopes.
+    ///         Each scope begins a label on the command list and writes a timestamp at its begin and end.
+    ///         Results are read back once the profilers timeline semaphore reached the value of the frame, the cpu never waits on the gpu.
+    struct GpuProfiler
+    {
+        GpuProfiler(GpuProfilerInfo a_info);
+        GpuProfiler(GpuProfiler && other);
+        GpuProfiler & operator=(GpuProfiler && other);
+        ~GpuProfiler();
+
+        // Reads back finished frames and starts recording a new frame.
+        void begin_frame(CommandList & cmd_list);
+        void end_frame();
+        void begin_scope(CommandList & cmd_list, std::string_view name);
+        void end_scope(CommandList & cmd_list);
+
+        // Returns current timeline index.
+        auto timeline_value() const -> u64;
+        // Returns timeline semaphore that needs to be signaled with the latest timeline value,
+        // on the last submission of each frame that uses this profiler.
+        auto get_timeline_semaphore() -> TimelineSemaphore;
+        auto get_info() const -> GpuProfilerInfo const &;
+        // Returns the most recent frame that was read back.
+        auto last_frame() const -> GpuProfilerFrame const &;
+        // Returns the rolling statistics of the scope with the given path.
+        auto scope_statistics(std::string_view path) const -> std::optional<GpuProfilerScopeStatistics>;
+        // Returns the number of frames that were not profiled because all query pools were still in use by the gpu.
+        auto dropped_frame_count() const -> u64;
+
+      private:
+        void resolve_finished_frames();
+        void resolve_frame(u32 slot_index);
+
+        struct RecordedScope
+        {
+            std::string name = {};
+            std::string path = {};
+            u32 parent_index = {};
+            u32 depth = {};
+            // Index of the begin timestamp, the end timestamp follows directly after.
+            u32 query_index = {};
+        };
+        struct FrameSlot
+        {
+            TimelineQueryPool query_pool = {};
+            u64 timeline_value = {};
+            u64 frame_index = {};
+            bool pending = {};
+            std::vector<RecordedScope> scopes = {};
+        };
+        struct ScopeHistory
+        {
+            std::deque<f64> durations_ms = {};
+            GpuProfilerScopeStatistics statistics = {};
+        };
+
+        GpuProfilerInfo info = {};
+        TimelineSemaphore gpu_timeline = {};
+        u64 current_timeline_value = {};
+        u64 frame_index = {};
+        u64 dropped_frames = {};
+        f64 timestamp_period_ns = {};
+        std::vector<FrameSlot> frame_slots = {};
+        // Slot that is currently recorded into, or NO_SLOT if the current frame is not profiled.
+        static inline constexpr u32 NO_SLOT = ~0u;
+        u32 recording_slot = NO_SLOT;
+        u32 next_slot = {};
+        // Indices into the recorded scopes of the current frame.
+        std::vector<u32> scope_stack = {};
+        bool frame_open = {};
+        GpuProfilerFrame resolved_frame = {};
+        std::unordered_map<std::string, ScopeHistory> scope_histories = {};
+        std::vector<u64> query_results = {};
+        std::vector<f64> sorted_durations = {};
+    };
+} // namespace daxa
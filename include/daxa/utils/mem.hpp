@@ -8,17 +8,36 @@
 #include <daxa/device.hpp>
 
 #include <deque>
+#include <mutex>
 
 namespace daxa
 {
     struct TransferMemoryPoolInfo
     {
         Device device = {};
-        u32 capacity = 1 << 25;
+        usize capacity = 1 << 25;
         bool use_bar_memory = {};
+        // When the ring is full, a new larger block is created instead of failing the allocation.
+        // Each new block is at least twice the size of the previous one. Old blocks are destroyed once the gpu finished all their allocations.
+        bool allow_growth = {};
+        // Upper limit for the capacity of grown blocks. Zero means no limit.
+        usize max_capacity = {};
         std::string name = {};
     };
 
+    struct TransferMemoryPoolStatistics
+    {
+        // Capacity of the block allocations are currently made from.
+        usize capacity = {};
+        // Bytes currently claimed by unfinished allocations in all blocks, including alignment and wrap around padding.
+        usize claimed_size = {};
+        // Largest claimed_size ever reached. A pool created with this capacity would never have needed to grow.
+        usize high_water_mark = {};
+        // Number of blocks still alive, including the current one.
+        u32 block_count = {};
+        u32 grow_count = {};
+    };
+
     /// @brief Ring buffer based transfer memory allocator for easy and efficient cpu gpu communication.
     struct TransferMemoryPool
     {
@@ -31,28 +50,43 @@ namespace daxa
         {
             daxa::BufferDeviceAddress device_address = {};
             void * host_address = {};
-            u32 buffer_offset = {};
+            // Buffer of the block the allocation was made from.
+            BufferId buffer = {};
+            usize buffer_offset = {};
             usize size = {};
             u64 timeline_index = {};
         };
         // Returns nullopt if the allocation fails.
-        auto allocate(u32 size, u32 alignment_requirement = 1) -> std::optional<Allocation>;
+        // With growth allowed, only fails when the allocation would exceed the max capacity.
+        auto allocate(usize size, usize alignment_requirement = 1) -> std::optional<Allocation>;
         // Returns current timeline index.
         auto timeline_value() const -> usize;
         // Returns timeline semaphore that needs to be signaled with the latest timeline value,
         // on a queue that uses memory from this pool.
         auto get_timeline_semaphore() -> TimelineSemaphore;
         auto get_info() const -> TransferMemoryPoolInfo const &;
+        // Returns the buffer of the current block.
+        // When the pool is allowed to grow, use Allocation::buffer instead, older allocations may live in a different block.
         auto get_buffer() const -> daxa::BufferId;
+        auto statistics() const -> TransferMemoryPoolStatistics;
 
       private:
         // Reclaim expired memory allocations.
         void reclaim_unused_memory();
+        // Retires the current block and replaces it with a new one that can fit the allocation.
+        auto grow(usize allocation_size, usize alignment_requirement) -> bool;
         struct TrackedAllocation
         {
             usize timeline_index = {};
-            u32 offset = {};
-            u32 size = {};
+            usize offset = {};
+            usize size = {};
+        };
+        struct RetiredBlock
+        {
+            BufferId buffer = {};
+            usize claimed_size = {};
+            // The block can be destroyed once the gpu reached the timeline index of its last allocation.
+            u64 last_timeline_index = {};
         };
 
         TransferMemoryPoolInfo info = {};
@@ -61,10 +95,322 @@ namespace daxa
       private:
         u64 current_timeline_value = {};
         std::deque<TrackedAllocation> live_allocations = {};
+        std::deque<RetiredBlock> retired_blocks = {};
+        BufferId buffer = {};
+        daxa::BufferDeviceAddress buffer_device_address = {};
+        void * buffer_host_address = {};
+        usize capacity = {};
+        usize claimed_start = {};
+        usize claimed_size = {};
+        usize retired_claimed_size = {};
+        usize high_water_mark = {};
+        u32 grow_count = {};
+    };
+
+    struct ConcurrentTransferMemoryPoolInfo
+    {
+        Device device = {};
+        usize capacity = 1 << 25;
+        bool use_bar_memory = {};
+        std::string name = {};
+    };
+
+    /// @brief  Ring buffer based transfer memory allocator that many threads can allocate from at the same time.
+    ///         Allocations bump the ring head with a single atomic compare exchange and never lock.
+    ///         Memory is tracked in batches instead of per allocation. All allocations made between two calls to end_batch form one batch,
+    ///         the batch is reclaimed once the gpu timeline semaphore reaches the value returned by end_batch.
+    struct ConcurrentTransferMemoryPool
+    {
+        ConcurrentTransferMemoryPool(ConcurrentTransferMemoryPoolInfo a_info);
+        ConcurrentTransferMemoryPool(ConcurrentTransferMemoryPool && other);
+        ConcurrentTransferMemoryPool & operator=(ConcurrentTransferMemoryPool && other);
+        ~ConcurrentTransferMemoryPool();
+
+        struct Allocation
+        {
+            daxa::BufferDeviceAddress device_address = {};
+            void * host_address = {};
+            usize buffer_offset = {};
+            usize size = {};
+            // Timeline value of the batch the allocation belongs to.
+            u64 timeline_index = {};
+        };
+        // Thread safe and lock free.
+        // Returns nullopt if the allocation fails, even after reclaiming all batches the gpu finished.
+        auto allocate(usize size, usize alignment_requirement = 1) -> std::optional<Allocation>;
+        // Closes the current batch and returns the timeline value it must be signaled with.
+        // The returned value must be signaled on the last submission that uses memory of the batch.
+        // Must NOT be called concurrently with allocate. Typically called by the submitting thread after all recording threads are done.
+        auto end_batch() -> u64;
+        // Returns the timeline value of the current batch.
+        auto timeline_value() const -> u64;
+        // Returns timeline semaphore that needs to be signaled with the value returned by end_batch.
+        auto get_timeline_semaphore() -> TimelineSemaphore;
+        auto get_info() const -> ConcurrentTransferMemoryPoolInfo const &;
+        auto get_buffer() const -> daxa::BufferId;
+
+      private:
+        // Moves the ring tail past all batches the gpu finished.
+        // Only called when the ring is full, so allocations in the common case never lock.
+        void reclaim_unused_memory();
+        struct TrackedBatch
+        {
+            u64 timeline_index = {};
+            // Ring head at the end of the batch, all memory before it is free once the batch is finished.
+            u64 head = {};
+        };
+
+        ConcurrentTransferMemoryPoolInfo info = {};
+        TimelineSemaphore gpu_timeline = {};
+
+      private:
+        // Head and tail are monotonically increasing byte counts, the buffer offset is the count modulo the capacity.
+        std::atomic_uint64_t head = {};
+        std::atomic_uint64_t tail = {};
+        std::atomic_uint64_t current_timeline_value = {1};
+        std::mutex batches_mtx = {};
+        std::deque<TrackedBatch> live_batches = {};
         BufferId buffer = {};
         daxa::BufferDeviceAddress buffer_device_address = {};
         void * buffer_host_address = {};
-        u32 claimed_start = {};
-        u32 claimed_size = {};
+    };
+
+    struct ReadbackMemoryPoolInfo
+    {
+        Device device = {};
+        usize capacity = 1 << 22;
+        std::string name = {};
+    };
+
+    /// @brief Ring buffer based readback memory allocator, the gpu writes into host cached memory that the cpu reads some frames later.
+    struct ReadbackMemoryPool
+    {
+        ReadbackMemoryPool(ReadbackMemoryPoolInfo a_info);
+        ReadbackMemoryPool(ReadbackMemoryPool && other);
+        ReadbackMemoryPool & operator=(ReadbackMemoryPool && other);
+        ~ReadbackMemoryPool();
+
+        // Ticket to an allocation, the gpu writes to the buffer offset or device address.
+        struct Allocation
+        {
+            daxa::BufferDeviceAddress device_address = {};
+            usize buffer_offset = {};
+            usize size = {};
+            u64 timeline_index = {};
+        };
+        // Returns nullopt if the allocation fails.
+        // Reclaims all allocations at the front of the ring that the gpu finished and that were mapped or discarded.
+        auto allocate(usize size, usize alignment_requirement = 1) -> std::optional<Allocation>;
+        // Returns nullptr if the gpu did not yet finish the submission of the allocation, never blocks.
+        // The pointer stays valid until the next call to allocate. Only mapped or discarded allocations are reclaimed.
+        // The gpu must make its writes visible to the host, for example with a barrier to AccessConsts::HOST_READ.
+        auto try_map(Allocation const & allocation) -> void const *;
+        // Marks an allocation that will never be mapped, it is reclaimed once the gpu finished its submission.
+        // Allocations that are neither mapped nor discarded block all later allocations from being reclaimed.
+        void discard(Allocation const & allocation);
+        template <typename T>
+        auto try_map_as(Allocation const & allocation) -> T const *
+        {
+            return static_cast<T const *>(try_map(allocation));
+        }
+        // Returns current timeline index.
+        auto timeline_value() const -> usize;
+        // Returns timeline semaphore that needs to be signaled with the latest timeline value,
+        // on a queue that writes memory from this pool.
+        auto get_timeline_semaphore() -> TimelineSemaphore;
+        auto get_info() const -> ReadbackMemoryPoolInfo const &;
+        auto get_buffer() const -> daxa::BufferId;
+
+      private:
+        // Reclaim allocations that were finished by the gpu and mapped or discarded by the cpu.
+        void reclaim_unused_memory();
+        struct TrackedAllocation
+        {
+            usize timeline_index = {};
+            usize offset = {};
+            usize size = {};
+            bool released = {};
+        };
+
+        ReadbackMemoryPoolInfo info = {};
+        TimelineSemaphore gpu_timeline = {};
+
+      private:
+        u64 current_timeline_value = {};
+        std::deque<TrackedAllocation> live_allocations = {};
+        BufferId buffer = {};
+        daxa::BufferDeviceAddress buffer_device_address = {};
+        void * buffer_host_address = {};
+        usize claimed_start = {};
+        usize claimed_size = {};
+    };
+
+    struct FrameLinearAllocatorInfo
+    {
+        Device device = {};
+        // When set, the allocator follows the frames of the swapchain.
+        // Its gpu timeline semaphore is used instead of gpu_timeline, frames_in_flight is set to the swapchains max allowed frames in flight plus one.
+        Swapchain swapchain = {};
+        // Timeline semaphore that is signaled with the frame value at the end of each frame.
+        // When neither a swapchain nor a timeline semaphore is set, the allocator creates its own.
+        TimelineSemaphore gpu_timeline = {};
+        usize frames_in_flight = 2;
+        // Size of the memory region of each frame in flight.
+        usize frame_capacity = 1 << 20;
+        bool use_bar_memory = {};
+        std::string name = {};
+    };
+
+    /// @brief  Linear allocator with one persistently mapped region per frame in flight.
+    ///         Allocations only bump an offset, there is no per allocation tracking.
+    ///         A region is reset as a whole when a new frame begins, once the gpu timeline shows the frame that last used it retired.
+    struct FrameLinearAllocator
+    {
+        FrameLinearAllocator(FrameLinearAllocatorInfo a_info);
+        FrameLinearAllocator(FrameLinearAllocator && other);
+        FrameLinearAllocator & operator=(FrameLinearAllocator && other);
+        ~FrameLinearAllocator();
+
+        struct Allocation
+        {
+            daxa::BufferDeviceAddress device_address = {};
+            void * host_address = {};
+            usize buffer_offset = {};
+            usize size = {};
+        };
+        // Switches to the region of the next frame and resets it.
+        // With a swapchain, call this after Swapchain::acquire_next_image, the frame value is the swapchains cpu timeline value.
+        // Otherwise the frame value is incremented by one.
+        // Only blocks when the gpu did not yet retire the frame that last used the region, which acquire_next_image already waits for.
+        void begin_frame();
+        // Returns nullopt if the region of the current frame is full.
+        auto allocate(usize size, usize alignment_requirement = 1) -> std::optional<Allocation>;
+        // Returns the value of the current frame.
+        // Without a swapchain, the last submission of the frame needs to signal the timeline semaphore with this value.
+        auto timeline_value() const -> u64;
+        auto get_timeline_semaphore() -> TimelineSemaphore;
+        // Bytes allocated in the current frame, including alignment padding.
+        auto used_size() const -> usize;
+        auto get_info() const -> FrameLinearAllocatorInfo const &;
+        auto get_buffer() const -> daxa::BufferId;
+
+      private:
+        FrameLinearAllocatorInfo info = {};
+        TimelineSemaphore gpu_timeline = {};
+
+      private:
+        u64 current_frame_value = {};
+        usize region_offset = {};
+        usize region_head = {};
+        BufferId buffer = {};
+        daxa::BufferDeviceAddress buffer_device_address = {};
+        void * buffer_host_address = {};
+    };
+
+    struct UploadBatcherInfo
+    {
+        Device device = {};
+        // Optional compute pipeline, compiled from daxa/utils/mem.inl with DAXA_UPLOAD_SCATTER_SHADER defined.
+        // When set, many small writes are scattered by a single compute dispatch instead of copy regions.
+        std::shared_ptr<ComputePipeline> scatter_pipeline = {};
+        // Merged ranges up to this size are written by the scatter dispatch.
+        usize scatter_max_size = 256;
+        // The scatter dispatch is only used with at least this many small ranges, below that copy regions are cheaper.
+        usize scatter_min_count = 64;
+        std::string name = {};
+    };
+
+    /// @brief  Collects many small buffer writes and records them as few copies as possible.
+    ///         Writes are packed contiguously into staging memory, sorted and merged by destination range.
+    ///         Each destination buffer receives one multi region copy, followed by one barrier for all writes.
+    struct UploadBatcher
+    {
+        UploadBatcher(UploadBatcherInfo a_info);
+
+        // Thread safe. The data is copied, it does not need to stay alive.
+        // Writes to overlapping ranges are applied in the order they were made.
+        void write(BufferId buffer, usize offset, void const * data, usize size);
+        template <typename T>
+        void write_as(BufferId buffer, usize offset, T const & value)
+        {
+            write(buffer, offset, &value, sizeof(T));
+        }
+        // Records a barrier from dst_access to the writes, all pending writes and a barrier from the writes to dst_access.
+        // dst_access is expected to be how earlier commands used the destination buffers too.
+        // With a scatter_pipeline, the scatter dispatch replaces the bound pipeline and push constants of cmd_list.
+        // Returns false and keeps all writes pending when the staging memory allocation fails.
+        auto record(CommandList & cmd_list, TransferMemoryPool & staging_memory, Access dst_access = AccessConsts::READ) -> bool;
+        auto pending_write_count() -> usize;
+        auto get_info() const -> UploadBatcherInfo const &;
+
+      private:
+        struct PendingWrite
+        {
+            BufferId buffer = {};
+            usize offset = {};
+            usize size = {};
+            usize data_offset = {};
+        };
+
+        UploadBatcherInfo info = {};
+        std::mutex mtx = {};
+        std::vector<PendingWrite> pending_writes = {};
+        std::vector<u8> pending_data = {};
+    };
+
+    struct GpuMirrorBufferInfo
+    {
+        Device device = {};
+        usize size = {};
+        // Size of the chunks dirty state is tracked for. Smaller chunks upload less, but need more copy regions.
+        usize dirty_granularity = 256;
+        // Optional compute pipeline, see UploadBatcherInfo::scatter_pipeline.
+        std::shared_ptr<ComputePipeline> scatter_pipeline = {};
+        usize scatter_min_count = 64;
+        std::string name = {};
+    };
+
+    /// @brief  Device local buffer with a cpu shadow copy.
+    ///         Writes go to the shadow copy and mark the touched chunks dirty.
+    ///         Once per frame, record_updates copies only the dirty chunks to the gpu.
+    struct GpuMirrorBuffer
+    {
+        GpuMirrorBuffer(GpuMirrorBufferInfo a_info);
+        GpuMirrorBuffer(GpuMirrorBuffer && other);
+        GpuMirrorBuffer & operator=(GpuMirrorBuffer && other);
+        ~GpuMirrorBuffer();
+
+        void write(usize offset, void const * data, usize size);
+        template <typename T>
+        void write_as(usize offset, T const & value)
+        {
+            write(offset, &value, sizeof(T));
+        }
+        // Marks the range dirty and returns a pointer to it in the shadow copy, for in place modification.
+        auto write_ptr(usize offset, usize size) -> void *;
+        template <typename T>
+        auto write_ptr_as(usize offset, usize count = 1) -> T *
+        {
+            return static_cast<T *>(write_ptr(offset, sizeof(T) * count));
+        }
+        void mark_dirty(usize offset, usize size);
+        // Records the copies of all dirty chunks, a barrier from earlier reads to the copies and a barrier from the copies to dst_access.
+        // When the staging memory can not fit all dirty chunks, as many as fit are uploaded and the rest stays dirty.
+        // With a scatter_pipeline, the scatter dispatch replaces the bound pipeline and push constants of cmd_list.
+        // Returns true when the gpu copy is up to date after the recorded commands.
+        auto record_updates(CommandList & cmd_list, TransferMemoryPool & staging_memory, Access dst_access = AccessConsts::READ) -> bool;
+        // Returns the bytes the next record_updates would upload.
+        auto dirty_size() const -> usize;
+        auto shadow() const -> std::span<u8 const>;
+        auto get_info() const -> GpuMirrorBufferInfo const &;
+        auto get_buffer() const -> daxa::BufferId;
+
+      private:
+        GpuMirrorBufferInfo info = {};
+        BufferId buffer = {};
+        std::vector<u8> shadow_data = {};
+        // One bit per dirty_granularity sized chunk.
+        std::vector<u64> dirty_chunks = {};
+        usize dirty_chunk_count = {};
     };
 } // namespace daxa
@@ -0,0 +1,56 @@
+#pragma once
+#include "../daxa.inl"
+
+/// @brief  Shader shared declarations of the UploadBatcher compute scatter path.
+///         Daxa can not compile shaders at build time, so the scatter pipeline is created by the user,
+///         by compiling this file as a compute shader, for example with the PipelineManager:
+///     pipeline_manager.add_compute_pipeline({
+///         .shader_info = {.source = daxa::ShaderFile{"daxa/utils/mem.inl"}, .compile_options = {.defines = {{"DAXA_UPLOAD_SCATTER_SHADER", "1"}}}},
+///         .push_constant_size = sizeof(daxa::UploadScatterPush),
+///         .name = "upload scatter",
+///     });
+
+#define DAXA_UPLOAD_SCATTER_WORKGROUP_SIZE 64
+
+#if __cplusplus
+namespace daxa
+{
+#endif
+    // Copies word_count 32 bit words from src_address to dst_address.
+    struct UploadScatterCommand
+    {
+        daxa_u64 dst_address;
+        daxa_u64 src_address;
+        daxa_u32 word_count;
+        daxa_u32 padding;
+    };
+
+    struct UploadScatterPush
+    {
+        daxa_u64 commands;
+        daxa_u32 command_count;
+    };
+#if __cplusplus
+} // namespace daxa
+#endif
+
+#if DAXA_SHADER && defined(DAXA_UPLOAD_SCATTER_SHADER)
+DAXA_DECL_BUFFER_PTR(UploadScatterCommand)
+DAXA_DECL_PUSH_CONSTANT(UploadScatterPush, push)
+
+// One invocation per command, scatter commands are meant for many tiny writes.
+layout(local_size_x = DAXA_UPLOAD_SCATTER_WORKGROUP_SIZE) in;
+void main()
+{
+    daxa_u32 command_index = gl_GlobalInvocationID.x;
+    if (command_index >= push.command_count)
+    {
+        return;
+    }
+    UploadScatterCommand command = deref(daxa_BufferPtr(UploadScatterCommand)(push.commands + daxa_u64(command_index) * 24));
+    for (daxa_u32 word = 0; word < command.word_count; ++word)
+    {
+        deref(daxa_RWBufferPtr(daxa_u32)(command.dst_address + daxa_u64(word) * 4)) = deref(daxa_BufferPtr(daxa_u32)(command.src_address + daxa_u64(word) * 4));
+    }
+}
+#endif
@@ -56,6 +56,8 @@ namespace daxa
     {
         ShaderSource source = std::monostate{};
         ShaderCompileOptions compile_options = {};
+        // Passed to the pipeline creation, so pipelines that only differ in these constants share the same shader source and defines.
+        std::vector<ShaderSpecializationConstant> specialization_constants = {};
     };
 
     struct ComputePipelineCompileInfo
@@ -77,6 +79,7 @@ namespace daxa
         DepthTestInfo depth_test = {};
         RasterizerInfo raster = {};
         TesselationInfo tesselation = {};
+        RasterDynamicStateFlags dynamic_state = RasterDynamicStateFlagBits::NONE;
         u32 push_constant_size = {};
         std::string name = {};
     };
@@ -86,6 +89,23 @@ namespace daxa
         Device device;
         ShaderCompileOptions shader_compile_options = {};
         bool register_null_pipelines_when_first_compile_fails = false;
+        // Number of threads used to compile the pipelines of add_*_pipelines and reload_all. 0 uses all hardware threads.
+        u32 compile_thread_count = 0;
+        // When set, compiled GLSL shaders are cached as SPIR-V files in this folder.
+        // Entries are keyed by the preprocessed source and all compile settings, so they never go stale.
+        // HLSL shaders are never cached, DXC resolves includes while it compiles, so they are compiled every time.
+        std::filesystem::path spirv_cache_path = {};
+        // The least recently used entries are deleted when the cache folder grows larger than this.
+        u64 spirv_cache_max_size = 256ull << 20;
+        // Linux only. Watches the shader files with inotify on a background thread, so that reload_all
+        // only looks at pipelines whose files changed and does no work at all when nothing changed.
+        // Other platforms, and systems where inotify is unavailable, keep polling the file write times.
+        bool enable_file_watcher = false;
+        // Looks for changed pipelines and recompiles them on a background thread every background_reload_interval.
+        // The new pipelines are only swapped in by apply_background_reloads, reload_all must not be called.
+        // Without DAXA_THREADSAFETY no thread is started and apply_background_reloads reloads synchronously.
+        bool enable_background_reload = false;
+        std::chrono::milliseconds background_reload_interval = std::chrono::milliseconds{250};
         std::string name = {};
     };
 
@@ -106,6 +126,12 @@ namespace daxa
 
     using PipelineReloadResult = std::variant<NoPipelineChanged, PipelineReloadSuccess, PipelineReloadError>;
 
+    struct PipelineDependents
+    {
+        std::vector<std::shared_ptr<ComputePipeline>> compute_pipelines = {};
+        std::vector<std::shared_ptr<RasterPipeline>> raster_pipelines = {};
+    };
+
     struct PipelineManager : ManagedPtr
     {
         PipelineManager() = default;
@@ -114,9 +140,39 @@ namespace daxa
 
         auto add_compute_pipeline(ComputePipelineCompileInfo const & info) -> Result<std::shared_ptr<ComputePipeline>>;
         auto add_raster_pipeline(RasterPipelineCompileInfo const & info) -> Result<std::shared_ptr<RasterPipeline>>;
+        /// @brief  Compiles all pipelines in parallel.
+        /// @return One result per info, in the same order as the infos.
+        auto add_compute_pipelines(std::span<ComputePipelineCompileInfo const> infos) -> std::vector<Result<std::shared_ptr<ComputePipeline>>>;
+        /// @brief  Compiles all pipelines in parallel.
+        /// @return One result per info, in the same order as the infos.
+        auto add_raster_pipelines(std::span<RasterPipelineCompileInfo const> infos) -> std::vector<Result<std::shared_ptr<RasterPipeline>>>;
         void remove_compute_pipeline(std::shared_ptr<ComputePipeline> const & pipeline);
         void remove_raster_pipeline(std::shared_ptr<RasterPipeline> const & pipeline);
         void add_virtual_file(VirtualFileInfo const & info);
+        /// @brief  Recompiles all pipelines with changed sources in parallel.
+        ///         Pipelines that compiled successfully are always replaced, even if others failed.
+        /// @return The error messages of all failed pipelines, compute pipelines first, each in the order they were added.
         auto reload_all() -> PipelineReloadResult;
+        /// @brief  Swaps all pipelines that finished compiling in the background into their existing pipeline objects.
+        ///         Never waits for the background compilation. Call it at a point where no other thread records
+        ///         commands with the managed pipelines, for example once per frame before recording.
+        ///         Failed compilations keep the old pipeline and are reported through pop_reload_errors.
+        /// @return true if any pipeline was swapped.
+        auto apply_background_reloads() -> bool;
+        /// @brief  Returns and clears the errors of all failed background reloads, oldest first.
+        auto pop_reload_errors() -> std::vector<PipelineReloadError>;
+        /// @brief  Returns all pipelines that include the given file or virtual file, directly or through other includes.
+        ///         Relative paths are searched in the root paths of the PipelineManagerInfo.
+        /// @return The pipelines in the order they were added.
+        auto pipelines_depending_on(std::filesystem::path const & file) -> PipelineDependents;
+        /// @brief  Number of shaders this pipeline manager loaded from the spirv cache instead of compiling them.
+        auto spirv_cache_hit_count() -> u64;
     };
+
+    /// @brief  Applies the preprocessing every shader file and virtual file goes through before it is compiled.
+    ///         `#pragma once` lines are replaced by an include guard named after the absolute path, or the name of virtual files.
+    ///         Comments, strings and all other lines are left untouched, includes are resolved by the compiler.
+    ///         Meant for tools that compile or inspect shaders outside of a PipelineManager and need the same source it compiles.
+    ///         Does not touch any pipeline manager state and is safe to call from any thread.
+    void preprocess_shader_source(std::string & source, std::filesystem::path const & path);
 } // namespace daxa
@@ -53,7 +53,7 @@ namespace daxa
 
     struct TaskTransientBufferInfo
     {
-        u32 size = {};
+        usize size = {};
         std::string name = {};
     };
 
@@ -123,7 +123,11 @@ namespace daxa
         /// @brief  Sets the size of the linear allocator of device local, host visible memory used by the linear staging allocator.
         ///         This memory is used internally as well as by tasks via the TaskInterface::get_allocator().
         ///         Setting the size to 0, disables a few task list features but also eliminates the memory allocation.
-        u32 staging_memory_pool_size = 262'144; // 2^16 bytes.
+        usize staging_memory_pool_size = 262'144; // 2^16 bytes.
+        /// @brief  When the staging memory pool runs out of memory, it chains a new larger block instead of failing the allocation.
+        ///         Use get_staging_memory_statistics to find a staging_memory_pool_size that never needs to grow.
+        ///         Off by default: once the pool grew, TransferMemoryPool::get_buffer only returns the newest block, so tasks must use Allocation::buffer.
+        bool staging_memory_pool_allow_growth = false;
         std::string name = {};
     };
 
@@ -217,6 +221,8 @@ namespace daxa
 
         auto get_debug_string() -> std::string;
         auto get_transient_memory_size() -> daxa::usize;
+        /// @brief  Returns nullopt when the task graph has no staging memory pool.
+        auto get_staging_memory_statistics() -> std::optional<TransferMemoryPoolStatistics>;
 
       private:
         void add_task(std::unique_ptr<detail::BaseTask> && base_task);
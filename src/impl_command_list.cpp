@@ -76,6 +76,35 @@ namespace daxa
             &vk_buffer_copy);
     }
 
+    void CommandList::copy_buffer_to_buffer_regions(BufferRegionsCopyInfo const & info)
+    {
+        auto & impl = *as<ImplCommandList>();
+        DAXA_DBG_ASSERT_TRUE_M(impl.recording_complete == false, "can only complete uncompleted command list");
+        if (info.regions.empty())
+        {
+            return;
+        }
+        impl.flush_barriers();
+
+        std::vector<VkBufferCopy> vk_buffer_copies = {};
+        vk_buffer_copies.reserve(info.regions.size());
+        for (auto const & region : info.regions)
+        {
+            vk_buffer_copies.push_back(VkBufferCopy{
+                .srcOffset = region.src_offset,
+                .dstOffset = region.dst_offset,
+                .size = region.size,
+            });
+        }
+
+        vkCmdCopyBuffer(
+            impl.vk_cmd_buffer,
+            impl.impl_device.as<ImplDevice>()->slot(info.src_buffer).vk_buffer,
+            impl.impl_device.as<ImplDevice>()->slot(info.dst_buffer).vk_buffer,
+            static_cast<u32>(vk_buffer_copies.size()),
+            vk_buffer_copies.data());
+    }
+
     void CommandList::copy_buffer_to_image(BufferImageCopyInfo const & info)
     {
         auto & impl = *as<ImplCommandList>();
@@ -287,6 +316,76 @@ namespace daxa
         impl.current_constant_buffer_bindings[info.slot] = info;
     }
 
+    // Shader objects have no baked state, everything a VkPipeline would contain is set dynamically here.
+    // Viewport, scissor and depth bias values stay in the hands of the user, as they are dynamic for regular pipelines as well.
+    static void bind_raster_shader_objects(ImplDevice const & device, VkCommandBuffer vk_cmd_buffer, ImplRasterPipeline const & pipeline)
+    {
+        auto const & info = pipeline.info;
+        u32 const bound_stage_count = static_cast<u32>(device.info.enable_mesh_shader ? RASTER_SHADER_OBJECT_STAGE_COUNT : RASTER_SHADER_OBJECT_STAGE_COUNT_NO_MESH);
+        device.vkCmdBindShadersEXT(vk_cmd_buffer, bound_stage_count, RASTER_SHADER_OBJECT_STAGES.data(), pipeline.vk_shaders.data());
+
+        if (info.vertex_shader_info.has_value())
+        {
+            device.vkCmdSetVertexInputEXT(vk_cmd_buffer, 0, nullptr, 0, nullptr);
+        }
+        vkCmdSetPrimitiveTopology(vk_cmd_buffer, static_cast<VkPrimitiveTopology>(info.raster.primitive_topology));
+        vkCmdSetPrimitiveRestartEnable(vk_cmd_buffer, static_cast<VkBool32>(info.raster.primitive_restart_enable));
+        device.vkCmdSetPatchControlPointsEXT(vk_cmd_buffer, info.tesselation.control_points);
+        device.vkCmdSetTessellationDomainOriginEXT(vk_cmd_buffer, static_cast<VkTessellationDomainOrigin>(info.tesselation.origin));
+
+        vkCmdSetRasterizerDiscardEnable(vk_cmd_buffer, info.fragment_shader_info.has_value() ? VK_FALSE : VK_TRUE);
+        device.vkCmdSetPolygonModeEXT(vk_cmd_buffer, static_cast<VkPolygonMode>(info.raster.polygon_mode));
+        vkCmdSetCullMode(vk_cmd_buffer, static_cast<VkCullModeFlags>(info.raster.face_culling.data));
+        vkCmdSetFrontFace(vk_cmd_buffer, static_cast<VkFrontFace>(info.raster.front_face_winding));
+        device.vkCmdSetDepthClampEnableEXT(vk_cmd_buffer, static_cast<VkBool32>(info.raster.depth_clamp_enable));
+        vkCmdSetDepthBiasEnable(vk_cmd_buffer, static_cast<VkBool32>(info.raster.depth_bias_enable));
+        vkCmdSetLineWidth(vk_cmd_buffer, info.raster.line_width);
+        if (device.info.enable_conservative_rasterization)
+        {
+            auto const conservative_raster_info = info.raster.conservative_raster_info.value_or(ConservativeRasterInfo{});
+            device.vkCmdSetConservativeRasterizationModeEXT(vk_cmd_buffer, static_cast<VkConservativeRasterizationModeEXT>(conservative_raster_info.mode));
+            device.vkCmdSetExtraPrimitiveOverestimationSizeEXT(vk_cmd_buffer, conservative_raster_info.size);
+        }
+
+        VkSampleMask const sample_mask = ~0u;
+        device.vkCmdSetRasterizationSamplesEXT(vk_cmd_buffer, VK_SAMPLE_COUNT_1_BIT);
+        device.vkCmdSetSampleMaskEXT(vk_cmd_buffer, VK_SAMPLE_COUNT_1_BIT, &sample_mask);
+        device.vkCmdSetAlphaToCoverageEnableEXT(vk_cmd_buffer, VK_FALSE);
+
+        vkCmdSetDepthTestEnable(vk_cmd_buffer, static_cast<VkBool32>(info.depth_test.enable_depth_test));
+        vkCmdSetDepthWriteEnable(vk_cmd_buffer, static_cast<VkBool32>(info.depth_test.enable_depth_write));
+        vkCmdSetDepthCompareOp(vk_cmd_buffer, static_cast<VkCompareOp>(info.depth_test.depth_test_compare_op));
+        vkCmdSetDepthBoundsTestEnable(vk_cmd_buffer, VK_FALSE);
+        vkCmdSetStencilTestEnable(vk_cmd_buffer, VK_FALSE);
+
+        if (!info.color_attachments.empty())
+        {
+            std::array<VkBool32, pipeline_manager_MAX_ATTACHMENTS> blend_enables = {};
+            std::array<VkColorBlendEquationEXT, pipeline_manager_MAX_ATTACHMENTS> blend_equations = {};
+            std::array<VkColorComponentFlags, pipeline_manager_MAX_ATTACHMENTS> write_masks = {};
+            for (usize i = 0; i < info.color_attachments.size(); ++i)
+            {
+                auto const & blend = *reinterpret_cast<VkPipelineColorBlendAttachmentState const *>(&info.color_attachments.at(i).blend);
+                blend_enables.at(i) = blend.blendEnable;
+                blend_equations.at(i) = VkColorBlendEquationEXT{
+                    .srcColorBlendFactor = blend.srcColorBlendFactor,
+                    .dstColorBlendFactor = blend.dstColorBlendFactor,
+                    .colorBlendOp = blend.colorBlendOp,
+                    .srcAlphaBlendFactor = blend.srcAlphaBlendFactor,
+                    .dstAlphaBlendFactor = blend.dstAlphaBlendFactor,
+                    .alphaBlendOp = blend.alphaBlendOp,
+                };
+                write_masks.at(i) = blend.colorWriteMask;
+            }
+            u32 const attachment_count = static_cast<u32>(info.color_attachments.size());
+            device.vkCmdSetColorBlendEnableEXT(vk_cmd_buffer, 0, attachment_count, blend_enables.data());
+            device.vkCmdSetColorBlendEquationEXT(vk_cmd_buffer, 0, attachment_count, blend_equations.data());
+            device.vkCmdSetColorWriteMaskEXT(vk_cmd_buffer, 0, attachment_count, write_masks.data());
+        }
+        std::array<f32, 4> const blend_constants = {1.0f, 1.0f, 1.0f, 1.0f};
+        vkCmdSetBlendConstants(vk_cmd_buffer, blend_constants.data());
+    }
+
     void CommandList::set_pipeline(RasterPipeline const & pipeline)
     {
         auto & impl = *as<ImplCommandList>();
@@ -299,7 +398,14 @@ namespace daxa
 
         impl.flush_constant_buffer_bindings(VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_impl.vk_pipeline_layout);
 
-        vkCmdBindPipeline(impl.vk_cmd_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_impl.vk_pipeline);
+        if (pipeline_impl.uses_shader_objects)
+        {
+            bind_raster_shader_objects(*impl.impl_device.as<ImplDevice>(), impl.vk_cmd_buffer, pipeline_impl);
+        }
+        else
+        {
+            vkCmdBindPipeline(impl.vk_cmd_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_impl.current_vk_pipeline());
+        }
     }
 
     void CommandList::dispatch(u32 group_x, u32 group_y, u32 group_z)
@@ -617,6 +723,11 @@ namespace daxa
         DAXA_DBG_ASSERT_TRUE_M(impl.recording_complete == false, "can only complete uncompleted command list");
         impl.flush_barriers();
         vkCmdSetViewport(impl.vk_cmd_buffer, 0, 1, reinterpret_cast<VkViewport const *>(&info));
+        // Shader objects require the viewport count to be set dynamically as well.
+        if (impl.impl_device.as<ImplDevice>()->shader_object_enabled)
+        {
+            vkCmdSetViewportWithCount(impl.vk_cmd_buffer, 1, reinterpret_cast<VkViewport const *>(&info));
+        }
     }
 
     void CommandList::set_scissor(Rect2D const & info)
@@ -625,6 +736,10 @@ namespace daxa
         DAXA_DBG_ASSERT_TRUE_M(impl.recording_complete == false, "can only complete uncompleted command list");
         impl.flush_barriers();
         vkCmdSetScissor(impl.vk_cmd_buffer, 0, 1, reinterpret_cast<VkRect2D const *>(&info));
+        if (impl.impl_device.as<ImplDevice>()->shader_object_enabled)
+        {
+            vkCmdSetScissorWithCount(impl.vk_cmd_buffer, 1, reinterpret_cast<VkRect2D const *>(&info));
+        }
     }
 
     void CommandList::set_depth_bias(DepthBiasInfo const & info)
@@ -635,6 +750,110 @@ namespace daxa
         vkCmdSetDepthBias(impl.vk_cmd_buffer, info.constant_factor, info.clamp, info.slope_factor);
     }
 
+    void CommandList::set_depth_test_enable(bool enable)
+    {
+        auto & impl = *as<ImplCommandList>();
+        DAXA_DBG_ASSERT_TRUE_M(impl.recording_complete == false, "can only complete uncompleted command list");
+        vkCmdSetDepthTestEnable(impl.vk_cmd_buffer, static_cast<VkBool32>(enable));
+    }
+
+    void CommandList::set_depth_write_enable(bool enable)
+    {
+        auto & impl = *as<ImplCommandList>();
+        DAXA_DBG_ASSERT_TRUE_M(impl.recording_complete == false, "can only complete uncompleted command list");
+        vkCmdSetDepthWriteEnable(impl.vk_cmd_buffer, static_cast<VkBool32>(enable));
+    }
+
+    void CommandList::set_depth_compare_op(CompareOp op)
+    {
+        auto & impl = *as<ImplCommandList>();
+        DAXA_DBG_ASSERT_TRUE_M(impl.recording_complete == false, "can only complete uncompleted command list");
+        vkCmdSetDepthCompareOp(impl.vk_cmd_buffer, static_cast<VkCompareOp>(op));
+    }
+
+    void CommandList::set_cull_mode(FaceCullFlags face_culling)
+    {
+        auto & impl = *as<ImplCommandList>();
+        DAXA_DBG_ASSERT_TRUE_M(impl.recording_complete == false, "can only complete uncompleted command list");
+        vkCmdSetCullMode(impl.vk_cmd_buffer, static_cast<VkCullModeFlags>(face_culling.data));
+    }
+
+    void CommandList::set_front_face(FrontFaceWinding winding)
+    {
+        auto & impl = *as<ImplCommandList>();
+        DAXA_DBG_ASSERT_TRUE_M(impl.recording_complete == false, "can only complete uncompleted command list");
+        vkCmdSetFrontFace(impl.vk_cmd_buffer, static_cast<VkFrontFace>(winding));
+    }
+
+    void CommandList::set_primitive_topology(PrimitiveTopology topology)
+    {
+        auto & impl = *as<ImplCommandList>();
+        DAXA_DBG_ASSERT_TRUE_M(impl.recording_complete == false, "can only complete uncompleted command list");
+        vkCmdSetPrimitiveTopology(impl.vk_cmd_buffer, static_cast<VkPrimitiveTopology>(topology));
+    }
+
+    void CommandList::set_primitive_restart_enable(bool enable)
+    {
+        auto & impl = *as<ImplCommandList>();
+        DAXA_DBG_ASSERT_TRUE_M(impl.recording_complete == false, "can only complete uncompleted command list");
+        vkCmdSetPrimitiveRestartEnable(impl.vk_cmd_buffer, static_cast<VkBool32>(enable));
+    }
+
+    void CommandList::set_depth_bias_enable(bool enable)
+    {
+        auto & impl = *as<ImplCommandList>();
+        DAXA_DBG_ASSERT_TRUE_M(impl.recording_complete == false, "can only complete uncompleted command list");
+        vkCmdSetDepthBiasEnable(impl.vk_cmd_buffer, static_cast<VkBool32>(enable));
+    }
+
+    void CommandList::set_polygon_mode(PolygonMode mode)
+    {
+        auto & impl = *as<ImplCommandList>();
+        auto const & device = *impl.impl_device.as<ImplDevice>();
+        DAXA_DBG_ASSERT_TRUE_M(impl.recording_complete == false, "can only complete uncompleted command list");
+        DAXA_DBG_ASSERT_TRUE_M(device.vkCmdSetPolygonModeEXT != nullptr, "dynamic polygon mode requires extended dynamic state 3 or shader objects");
+        device.vkCmdSetPolygonModeEXT(impl.vk_cmd_buffer, static_cast<VkPolygonMode>(mode));
+    }
+
+    void CommandList::set_color_blend(u32 first_attachment, std::span<BlendInfo const> blends)
+    {
+        auto & impl = *as<ImplCommandList>();
+        auto const & device = *impl.impl_device.as<ImplDevice>();
+        DAXA_DBG_ASSERT_TRUE_M(impl.recording_complete == false, "can only complete uncompleted command list");
+        DAXA_DBG_ASSERT_TRUE_M(device.vkCmdSetColorBlendEnableEXT != nullptr, "dynamic color blend requires extended dynamic state 3 or shader objects");
+        DAXA_DBG_ASSERT_TRUE_M(first_attachment + blends.size() <= pipeline_manager_MAX_ATTACHMENTS, "too many color attachments");
+        std::array<VkBool32, pipeline_manager_MAX_ATTACHMENTS> blend_enables = {};
+        std::array<VkColorBlendEquationEXT, pipeline_manager_MAX_ATTACHMENTS> blend_equations = {};
+        std::array<VkColorComponentFlags, pipeline_manager_MAX_ATTACHMENTS> write_masks = {};
+        for (usize i = 0; i < blends.size(); ++i)
+        {
+            auto const & blend = *reinterpret_cast<VkPipelineColorBlendAttachmentState const *>(&blends[i]);
+            blend_enables.at(i) = blend.blendEnable;
+            blend_equations.at(i) = VkColorBlendEquationEXT{
+                .srcColorBlendFactor = blend.srcColorBlendFactor,
+                .dstColorBlendFactor = blend.dstColorBlendFactor,
+                .colorBlendOp = blend.colorBlendOp,
+                .srcAlphaBlendFactor = blend.srcAlphaBlendFactor,
+                .dstAlphaBlendFactor = blend.dstAlphaBlendFactor,
+                .alphaBlendOp = blend.alphaBlendOp,
+            };
+            write_masks.at(i) = blend.colorWriteMask;
+        }
+        u32 const attachment_count = static_cast<u32>(blends.size());
+        device.vkCmdSetColorBlendEnableEXT(impl.vk_cmd_buffer, first_attachment, attachment_count, blend_enables.data());
+        device.vkCmdSetColorBlendEquationEXT(impl.vk_cmd_buffer, first_attachment, attachment_count, blend_equations.data());
+        device.vkCmdSetColorWriteMaskEXT(impl.vk_cmd_buffer, first_attachment, attachment_count, write_masks.data());
+    }
+
+    void CommandList::set_depth_clamp_enable(bool enable)
+    {
+        auto & impl = *as<ImplCommandList>();
+        auto const & device = *impl.impl_device.as<ImplDevice>();
+        DAXA_DBG_ASSERT_TRUE_M(impl.recording_complete == false, "can only complete uncompleted command list");
+        DAXA_DBG_ASSERT_TRUE_M(device.vkCmdSetDepthClampEnableEXT != nullptr, "dynamic depth clamp requires extended dynamic state 3 or shader objects");
+        device.vkCmdSetDepthClampEnableEXT(impl.vk_cmd_buffer, static_cast<VkBool32>(enable));
+    }
+
     void CommandList::set_index_buffer(BufferId id, usize offset, usize index_type_byte_size)
     {
         auto & impl = *as<ImplCommandList>();
@@ -769,6 +988,36 @@ namespace daxa
         vkCmdResetQueryPool(impl.vk_cmd_buffer, info.query_pool.as<ImplTimelineQueryPool>()->vk_timeline_query_pool, info.start_index, info.count);
     }
 
+    void CommandList::begin_query(BeginQueryInfo const & info)
+    {
+        auto & impl = *as<ImplCommandList>();
+        DAXA_DBG_ASSERT_TRUE_M(impl.recording_complete == false, "can only record to uncompleted command list");
+        DAXA_DBG_ASSERT_TRUE_M(info.query_index < info.query_pool.info().query_count, "query_index is out of bounds for the query pool");
+        DAXA_DBG_ASSERT_TRUE_M(!info.precise || info.query_pool.info().query_type == QueryType::OCCLUSION, "only occlusion queries can be precise");
+        DAXA_DBG_ASSERT_TRUE_M(!info.precise || impl.impl_device.as<ImplDevice>()->precise_occlusion_queries_enabled, "precise occlusion queries are not supported by the device");
+        impl.flush_barriers();
+        VkQueryControlFlags const flags = info.precise ? VK_QUERY_CONTROL_PRECISE_BIT : 0u;
+        vkCmdBeginQuery(impl.vk_cmd_buffer, info.query_pool.as<ImplQueryPool>()->vk_query_pool, info.query_index, flags);
+    }
+
+    void CommandList::end_query(EndQueryInfo const & info)
+    {
+        auto & impl = *as<ImplCommandList>();
+        DAXA_DBG_ASSERT_TRUE_M(impl.recording_complete == false, "can only record to uncompleted command list");
+        DAXA_DBG_ASSERT_TRUE_M(info.query_index < info.query_pool.info().query_count, "query_index is out of bounds for the query pool");
+        impl.flush_barriers();
+        vkCmdEndQuery(impl.vk_cmd_buffer, info.query_pool.as<ImplQueryPool>()->vk_query_pool, info.query_index);
+    }
+
+    void CommandList::reset_queries(ResetQueriesInfo const & info)
+    {
+        auto & impl = *as<ImplCommandList>();
+        DAXA_DBG_ASSERT_TRUE_M(impl.recording_complete == false, "can only record to uncompleted command list");
+        DAXA_DBG_ASSERT_TRUE_M(info.start_index + info.count <= info.query_pool.info().query_count, "reset range is out of bounds for the query pool");
+        impl.flush_barriers();
+        vkCmdResetQueryPool(impl.vk_cmd_buffer, info.query_pool.as<ImplQueryPool>()->vk_query_pool, info.start_index, info.count);
+    }
+
     void CommandList::begin_label(CommandLabelInfo const & info)
     {
         auto & impl = *as<ImplCommandList>();
@@ -925,6 +1174,7 @@ namespace daxa
           vk_cmd_pool{pool},
           pipeline_layouts{&(impl_device.as<ImplDevice>()->gpu_shader_resource_table.pipeline_layouts)}
     {
+        DAXA_ATOMIC_FETCH_INC(impl_device.as<ImplDevice>()->open_command_list_count);
         initialize();
     }
 
@@ -968,6 +1218,10 @@ namespace daxa
         auto & device = *this->impl_device.as<ImplDevice>();
 
         vkResetCommandPool(device.vk_device, this->vk_cmd_pool, {});
+        if (!this->submitted)
+        {
+            DAXA_ATOMIC_FETCH_DEC(device.open_command_list_count);
+        }
 
         DAXA_ONLY_IF_THREADSAFETY(std::unique_lock const lock{device.main_queue_zombies_mtx});
         u64 const main_queue_cpu_timeline = DAXA_ATOMIC_FETCH(device.main_queue_cpu_timeline);
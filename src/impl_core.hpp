@@ -9,6 +9,7 @@
 #include <fmt/format.h>
 
 #include <daxa/core.hpp>
+#include <daxa/trace.hpp>
 
 #if defined(_WIN32)
 #define VK_USE_PLATFORM_WIN32_KHR
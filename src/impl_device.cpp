@@ -1,5 +1,7 @@
 #include "impl_device.hpp"
 
+#include <algorithm>
+#include <random>
 #include <utility>
 
 namespace daxa
@@ -150,6 +152,49 @@ namespace daxa
         return impl.mesh_shader_properties;
     }
 
+    auto Device::precise_occlusion_queries_enabled() const -> bool
+    {
+        auto const & impl = *as<ImplDevice>();
+        return impl.precise_occlusion_queries_enabled;
+    }
+
+    auto Device::pipeline_statistics_queries_enabled() const -> bool
+    {
+        auto const & impl = *as<ImplDevice>();
+        return impl.pipeline_statistics_queries_enabled;
+    }
+
+    auto Device::sparse_resources_supported() const -> bool
+    {
+        auto const & impl = *as<ImplDevice>();
+        return impl.sparse_resources_supported;
+    }
+
+    auto Device::shader_object_enabled() const -> bool
+    {
+        auto const & impl = *as<ImplDevice>();
+        return impl.shader_object_enabled;
+    }
+
+    auto Device::extended_dynamic_state_3_enabled() const -> bool
+    {
+        auto const & impl = *as<ImplDevice>();
+        return impl.extended_dynamic_state_3_enabled;
+    }
+
+    auto Device::graphics_pipeline_library_enabled() const -> bool
+    {
+        auto const & impl = *as<ImplDevice>();
+        return impl.graphics_pipeline_library_enabled;
+    }
+
+    auto Device::pipeline_library_count() -> u32
+    {
+        auto & impl = *as<ImplDevice>();
+        DAXA_ONLY_IF_THREADSAFETY(std::unique_lock const lock{impl.pipeline_libraries_mtx});
+        return static_cast<u32>(impl.pipeline_libraries.size());
+    }
+
     void Device::wait_idle()
     {
         auto & impl = *as<ImplDevice>();
@@ -158,6 +203,7 @@ namespace daxa
 
     void Device::submit_commands(CommandSubmitInfo const & submit_info)
     {
+        DAXA_TRACE_SCOPE("Device::submit_commands");
         auto & impl = *as<ImplDevice>();
 
         impl.main_queue_collect_garbage();
@@ -188,6 +234,8 @@ namespace daxa
             auto const & impl_cmd_list = *command_list.as<ImplCommandList>();
             DAXA_DBG_ASSERT_TRUE_M(impl_cmd_list.recording_complete, "all submitted command lists must be completed before submission");
             submit.second.push_back(command_list);
+            submit.second.back().as<ImplCommandList>()->submitted = true;
+            DAXA_ATOMIC_FETCH_DEC(impl.open_command_list_count);
             submit_vk_command_buffers.push_back(impl_cmd_list.vk_cmd_buffer);
         }
 
@@ -217,6 +265,14 @@ namespace daxa
         std::vector<VkPipelineStageFlags> submit_semaphore_wait_stage_masks = {};
         std::vector<u64> submit_semaphore_wait_values = {}; // Used for timeline semaphores. Ignored (push dummy value) for binary semaphores.
 
+        u64 const sparse_bind_timeline_value = DAXA_ATOMIC_FETCH(impl.main_queue_sparse_bind_timeline_value);
+        if (sparse_bind_timeline_value != 0)
+        {
+            submit_semaphore_waits.push_back(impl.vk_main_queue_gpu_timeline_semaphore);
+            submit_semaphore_wait_stage_masks.push_back(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+            submit_semaphore_wait_values.push_back(sparse_bind_timeline_value);
+        }
+
         for (auto const & [timeline_semaphore, wait_value] : submit_info.wait_timeline_semaphores)
         {
             auto const & impl_timeline_semaphore = *timeline_semaphore.as<ImplTimelineSemaphore>();
@@ -261,6 +317,7 @@ namespace daxa
 
     void Device::present_frame(PresentInfo const & info)
     {
+        DAXA_TRACE_SCOPE("Device::present_frame");
         auto & impl = *as<ImplDevice>();
         auto const & swapchain_impl = *info.swapchain.as<ImplSwapchain>();
 
@@ -305,14 +362,78 @@ namespace daxa
 
     auto Device::create_raster_pipeline(RasterPipelineInfo const & info) -> RasterPipeline
     {
+        DAXA_TRACE_SCOPE("Device::create_raster_pipeline");
         return RasterPipeline{ManagedPtr{new ImplRasterPipeline(this->make_weak(), info)}};
     }
 
     auto Device::create_compute_pipeline(ComputePipelineInfo const & info) -> ComputePipeline
     {
+        DAXA_TRACE_SCOPE("Device::create_compute_pipeline");
         return ComputePipeline{ManagedPtr{new ImplComputePipeline(this->make_weak(), info)}};
     }
 
+    // Shader byte code is only referenced by pipeline infos. Async creations copy it, as the caller may free it before the creation runs.
+    static auto raster_pipeline_shader_infos(RasterPipelineInfo & info) -> std::array<std::optional<ShaderInfo> *, 6>
+    {
+        return {
+            &info.mesh_shader_info,
+            &info.vertex_shader_info,
+            &info.tesselation_control_shader_info,
+            &info.tesselation_evaluation_shader_info,
+            &info.fragment_shader_info,
+            &info.task_shader_info,
+        };
+    }
+
+    auto Device::create_raster_pipeline_async(RasterPipelineInfo const & info) -> AsyncRasterPipeline
+    {
+        DAXA_TRACE_SCOPE("Device::create_raster_pipeline_async");
+        RasterPipelineInfo info_copy = info;
+        std::array<std::vector<u32>, 6> byte_codes = {};
+        auto shader_infos = raster_pipeline_shader_infos(info_copy);
+        for (usize i = 0; i < shader_infos.size(); ++i)
+        {
+            if (shader_infos[i]->has_value())
+            {
+                byte_codes[i].assign(shader_infos[i]->value().byte_code.begin(), shader_infos[i]->value().byte_code.end());
+            }
+        }
+        auto task = std::make_shared<std::packaged_task<RasterPipeline()>>(
+            [impl_device = this->make_weak(), info = std::move(info_copy), byte_codes = std::move(byte_codes)]() mutable
+            {
+                DAXA_TRACE_SCOPE("create raster pipeline");
+                auto async_shader_infos = raster_pipeline_shader_infos(info);
+                for (usize i = 0; i < async_shader_infos.size(); ++i)
+                {
+                    if (async_shader_infos[i]->has_value())
+                    {
+                        async_shader_infos[i]->value().byte_code = byte_codes[i];
+                    }
+                }
+                return RasterPipeline{ManagedPtr{new ImplRasterPipeline(impl_device, info)}};
+            });
+        auto result = AsyncRasterPipeline{task->get_future().share()};
+        as<ImplDevice>()->enqueue_pipeline_compile([task]()
+                                                   { (*task)(); });
+        return result;
+    }
+
+    auto Device::create_compute_pipeline_async(ComputePipelineInfo const & info) -> AsyncComputePipeline
+    {
+        DAXA_TRACE_SCOPE("Device::create_compute_pipeline_async");
+        auto task = std::make_shared<std::packaged_task<ComputePipeline()>>(
+            [impl_device = this->make_weak(), info = info, byte_code = std::vector<u32>(info.shader_info.byte_code.begin(), info.shader_info.byte_code.end())]() mutable
+            {
+                DAXA_TRACE_SCOPE("create compute pipeline");
+                info.shader_info.byte_code = byte_code;
+                return ComputePipeline{ManagedPtr{new ImplComputePipeline(impl_device, info)}};
+            });
+        auto result = AsyncComputePipeline{task->get_future().share()};
+        as<ImplDevice>()->enqueue_pipeline_compile([task]()
+                                                   { (*task)(); });
+        return result;
+    }
+
     auto Device::create_command_list(CommandListInfo const & info) -> CommandList
     {
         auto & impl = *as<ImplDevice>();
@@ -341,6 +462,520 @@ namespace daxa
         return TimelineQueryPool(ManagedPtr(new ImplTimelineQueryPool(this->make_weak(), info)));
     }
 
+    auto Device::create_query_pool(QueryPoolInfo const & info) -> QueryPool
+    {
+        return QueryPool(ManagedPtr(new ImplQueryPool(this->make_weak(), info)));
+    }
+
+    auto Device::defragment(DefragmentInfo const & info) -> DefragmentResult
+    {
+        DAXA_TRACE_SCOPE("Device::defragment");
+        auto & impl = *as<ImplDevice>();
+
+        // Ends the previous pass when the gpu finished its copies.
+        impl.main_queue_collect_garbage();
+
+        DAXA_ONLY_IF_THREADSAFETY(std::unique_lock lock{impl.main_queue_zombies_mtx});
+        if (impl.defragmentation_pass_pending)
+        {
+            return DefragmentResult{.pass_pending = true};
+        }
+        // Command lists recorded before the move would still reference the old buffers when they are submitted after it.
+        DAXA_DBG_ASSERT_TRUE_M(DAXA_ATOMIC_FETCH(impl.open_command_list_count) == 0, "defragment must not be called while command lists are recorded or waiting for submission");
+        if (impl.vma_defragmentation_context == nullptr)
+        {
+            VmaDefragmentationInfo const vma_defragmentation_info{
+                .flags = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_BALANCED_BIT,
+                .pool = nullptr,
+                .maxBytesPerPass = static_cast<VkDeviceSize>(info.max_bytes_per_pass),
+                .maxAllocationsPerPass = info.max_moves_per_pass,
+            };
+            [[maybe_unused]] VkResult const begin_result = vmaBeginDefragmentation(impl.vma_allocator, &vma_defragmentation_info, &impl.vma_defragmentation_context);
+            DAXA_DBG_ASSERT_TRUE_M(begin_result == VK_SUCCESS, "failed to begin defragmentation");
+        }
+        VmaDefragmentationPassMoveInfo & pass = impl.vma_defragmentation_pass;
+        if (vmaBeginDefragmentationPass(impl.vma_allocator, impl.vma_defragmentation_context, &pass) == VK_SUCCESS)
+        {
+            // Nothing left to move.
+            vmaEndDefragmentation(impl.vma_allocator, impl.vma_defragmentation_context, nullptr);
+            impl.vma_defragmentation_context = {};
+            return DefragmentResult{.complete = true};
+        }
+
+        DefragmentResult ret = {};
+        std::vector<std::pair<BufferId, VkBuffer>> moved_buffers = {};
+        impl.defragmentation_old_buffers.assign(pass.moveCount, VK_NULL_HANDLE);
+        for (u32 move_index = 0; move_index < pass.moveCount; ++move_index)
+        {
+            VmaDefragmentationMove & move = pass.pMoves[move_index];
+            VmaAllocationInfo vma_allocation_info = {};
+            vmaGetAllocationInfo(impl.vma_allocator, move.srcAllocation, &vma_allocation_info);
+            // Images, memory blocks, mapped and internal buffers are not tagged with a buffer id and are never moved.
+            if (vma_allocation_info.pUserData == nullptr)
+            {
+                move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+                continue;
+            }
+            // Tagged with the id plus one, so that no id is mistaken for an untagged allocation.
+            BufferId const id = BufferId{std::bit_cast<GPUResourceId>(static_cast<u32>(reinterpret_cast<usize>(vma_allocation_info.pUserData) - 1))};
+            if (impl.slot(id).zombie)
+            {
+                move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+                continue;
+            }
+            ImplBufferSlot const & buffer_slot = impl.slot(id);
+            VkBufferCreateInfo const vk_buffer_create_info{
+                .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = {},
+                .size = static_cast<VkDeviceSize>(buffer_slot.info.size),
+                .usage = BUFFER_USE_FLAGS,
+                .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                .queueFamilyIndexCount = 1,
+                .pQueueFamilyIndices = &impl.main_queue_family_index,
+            };
+            VkBuffer new_vk_buffer = {};
+            [[maybe_unused]] VkResult const vk_create_buffer_result = vkCreateBuffer(impl.vk_device, &vk_buffer_create_info, nullptr, &new_vk_buffer);
+            DAXA_DBG_ASSERT_TRUE_M(vk_create_buffer_result == VK_SUCCESS, "failed to create buffer");
+            vmaBindBufferMemory2(impl.vma_allocator, move.dstTmpAllocation, 0, new_vk_buffer, {});
+            impl.defragmentation_old_buffers[move_index] = buffer_slot.vk_buffer;
+            moved_buffers.push_back({id, new_vk_buffer});
+            ret.moved_buffers += 1;
+            ret.moved_bytes += static_cast<usize>(vma_allocation_info.size);
+        }
+        if (moved_buffers.empty())
+        {
+            impl.end_defragmentation_pass();
+            ret.complete = impl.vma_defragmentation_context == nullptr;
+            return ret;
+        }
+        // Marked pending before the lock is released, so that neither the garbage collection of the submit ends the pass early,
+        // nor buffers destroyed on other threads in the meantime are freed while they are moved.
+        impl.defragmentation_pass_pending = true;
+        impl.defragmentation_pass_timeline_value = std::numeric_limits<u64>::max();
+        u64 const previous_submit_timeline_value = DAXA_ATOMIC_FETCH(impl.main_queue_cpu_timeline);
+        DAXA_ONLY_IF_THREADSAFETY(lock.unlock());
+
+        // The descriptors and device addresses of the moved buffers are rewritten right after the copies are submitted.
+        // No earlier submission may still use them at that point, so all of them must be finished before the copies are submitted.
+        // Only passes that move buffers wait, and they wait without holding the zombie lock.
+        {
+            VkSemaphoreWaitInfo const vk_semaphore_wait_info{
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                .pNext = nullptr,
+                .flags = {},
+                .semaphoreCount = 1,
+                .pSemaphores = &impl.vk_main_queue_gpu_timeline_semaphore,
+                .pValues = &previous_submit_timeline_value,
+            };
+            [[maybe_unused]] VkResult const wait_result = vkWaitSemaphores(impl.vk_device, &vk_semaphore_wait_info, std::numeric_limits<u64>::max());
+            DAXA_DBG_ASSERT_TRUE_M(wait_result == VK_SUCCESS, "failed to wait for previous submissions");
+        }
+
+        CommandList cmd_list = this->create_command_list({.name = "daxa defragmentation"});
+        auto & impl_cmd_list = *cmd_list.as<ImplCommandList>();
+        // All previous submissions must be done accessing the buffers before they are copied.
+        cmd_list.pipeline_barrier({
+            .src_access = AccessConsts::READ_WRITE,
+            .dst_access = AccessConsts::TRANSFER_READ,
+        });
+        impl_cmd_list.flush_barriers();
+        for (auto const & [id, new_vk_buffer] : moved_buffers)
+        {
+            ImplBufferSlot const & buffer_slot = impl.slot(id);
+            VkBufferCopy const vk_buffer_copy{
+                .srcOffset = 0,
+                .dstOffset = 0,
+                .size = static_cast<VkDeviceSize>(buffer_slot.info.size),
+            };
+            vkCmdCopyBuffer(impl_cmd_list.vk_cmd_buffer, buffer_slot.vk_buffer, new_vk_buffer, 1, &vk_buffer_copy);
+        }
+        cmd_list.pipeline_barrier({
+            .src_access = AccessConsts::TRANSFER_WRITE,
+            .dst_access = AccessConsts::READ_WRITE,
+        });
+        cmd_list.complete();
+        this->submit_commands({.command_lists = {std::move(cmd_list)}});
+
+        DAXA_ONLY_IF_THREADSAFETY(lock.lock());
+        impl.defragmentation_pass_timeline_value = DAXA_ATOMIC_FETCH(impl.main_queue_cpu_timeline);
+        // The ids stay the same, only the slots, descriptors and device addresses are redirected to the new buffers.
+        // All earlier submissions are finished and no command list is open, so only the copies still use the old buffers.
+        // They stay alive until the pass ends with the copies.
+        for (auto const & [id, new_vk_buffer] : moved_buffers)
+        {
+            ImplBufferSlot & buffer_slot = impl.gpu_shader_resource_table.buffer_slots.dereference_id(id);
+            VkBufferDeviceAddressInfo const vk_buffer_device_address_info{
+                .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+                .pNext = nullptr,
+                .buffer = new_vk_buffer,
+            };
+            buffer_slot.vk_buffer = new_vk_buffer;
+            buffer_slot.device_address = vkGetBufferDeviceAddress(impl.vk_device, &vk_buffer_device_address_info);
+            impl.buffer_device_address_buffer_host_ptr[id.index] = buffer_slot.device_address;
+            write_descriptor_set_buffer(impl.vk_device, impl.gpu_shader_resource_table.vk_descriptor_set, new_vk_buffer, 0, impl.buffer_descriptor_range(buffer_slot.info.size), id.index);
+            if (impl.impl_ctx.as<ImplInstance>()->info.enable_debug_utils && !buffer_slot.info.name.empty())
+            {
+                VkDebugUtilsObjectNameInfoEXT const buffer_name_info{
+                    .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT,
+                    .pNext = nullptr,
+                    .objectType = VK_OBJECT_TYPE_BUFFER,
+                    .objectHandle = reinterpret_cast<uint64_t>(new_vk_buffer),
+                    .pObjectName = buffer_slot.info.name.c_str(),
+                };
+                impl.vkSetDebugUtilsObjectNameEXT(impl.vk_device, &buffer_name_info);
+            }
+        }
+        ret.pass_pending = true;
+        return ret;
+    }
+
+    // Tiles of mip levels in the mip tail all share the key of the first mip tail level and tile zero.
+    static auto sparse_tile_key(u32 array_layer, u32 mip_level, u32 tile_x, u32 tile_y, u32 tile_z) -> u64
+    {
+        return (static_cast<u64>(array_layer) << 52) | (static_cast<u64>(mip_level) << 48) | (static_cast<u64>(tile_z) << 32) | (static_cast<u64>(tile_y) << 16) | static_cast<u64>(tile_x);
+    }
+
+    auto Device::write_pipeline_cache() -> bool
+    {
+        DAXA_TRACE_SCOPE("Device::write_pipeline_cache");
+        return as<ImplDevice>()->write_pipeline_cache_file();
+    }
+
+    void Device::bind_sparse_memory(SparseBindInfo const & info)
+    {
+        DAXA_TRACE_SCOPE("Device::bind_sparse_memory");
+        auto & impl = *as<ImplDevice>();
+        DAXA_DBG_ASSERT_TRUE_M(impl.info.enable_sparse_resources, "sparse binding requires DeviceInfo::enable_sparse_resources");
+
+        impl.main_queue_collect_garbage();
+
+        auto allocate_page = [&](VkMemoryRequirements const & resource_requirements, VkDeviceSize size) -> std::pair<VmaAllocation, VmaAllocationInfo>
+        {
+            VkMemoryRequirements const page_requirements{
+                .size = size,
+                .alignment = resource_requirements.alignment,
+                .memoryTypeBits = resource_requirements.memoryTypeBits,
+            };
+            VmaAllocationCreateInfo const page_create_info{
+                .flags = {},
+                .usage = VMA_MEMORY_USAGE_GPU_ONLY,
+                .requiredFlags = {},
+                .preferredFlags = {},
+                .memoryTypeBits = {},
+                .pool = {},
+                .pUserData = {},
+                .priority = 0.5f,
+            };
+            std::pair<VmaAllocation, VmaAllocationInfo> page = {};
+            [[maybe_unused]] VkResult const result = vmaAllocateMemory(impl.vma_allocator, &page_requirements, &page_create_info, &page.first, &page.second);
+            DAXA_DBG_ASSERT_TRUE_M(result == VK_SUCCESS, "failed to allocate sparse page memory");
+            return page;
+        };
+
+        std::vector<VmaAllocation> freed_pages = {};
+        // The bind infos point into these, so they are only resized before pointers are taken.
+        std::vector<std::vector<VkSparseMemoryBind>> buffer_memory_binds(info.buffer_binds.size());
+        std::vector<VkSparseBufferMemoryBindInfo> buffer_bind_infos = {};
+        std::vector<std::vector<VkSparseMemoryBind>> image_opaque_memory_binds(info.image_binds.size());
+        std::vector<VkSparseImageOpaqueMemoryBindInfo> image_opaque_bind_infos = {};
+        std::vector<std::vector<VkSparseImageMemoryBind>> image_memory_binds(info.image_binds.size());
+        std::vector<VkSparseImageMemoryBindInfo> image_bind_infos = {};
+
+        for (usize bind_index = 0; bind_index < info.buffer_binds.size(); ++bind_index)
+        {
+            SparseBufferBind const & bind = info.buffer_binds[bind_index];
+            ImplBufferSlot & buffer_slot = impl.gpu_shader_resource_table.buffer_slots.dereference_id(bind.buffer);
+            DAXA_DBG_ASSERT_TRUE_M(std::holds_alternative<SparseAllocInfo>(buffer_slot.info.allocate_info), "can only bind memory to sparse buffers");
+            DAXA_DBG_ASSERT_TRUE_M(bind.first_page + bind.page_count <= buffer_slot.sparse_pages.size(), "sparse bind exceeds the page count of the buffer");
+            VkDeviceSize const page_size = buffer_slot.sparse_memory_requirements.alignment;
+            auto & memory_binds = buffer_memory_binds[bind_index];
+            for (usize page_index = bind.first_page; page_index < bind.first_page + bind.page_count; ++page_index)
+            {
+                VmaAllocation & page = buffer_slot.sparse_pages[page_index];
+                // Binding resident pages or unbinding non resident pages is a no op.
+                if ((page != VK_NULL_HANDLE) == bind.resident)
+                {
+                    continue;
+                }
+                VkSparseMemoryBind memory_bind{
+                    .resourceOffset = page_index * page_size,
+                    .size = std::min(page_size, buffer_slot.sparse_memory_requirements.size - page_index * page_size),
+                    .memory = VK_NULL_HANDLE,
+                    .memoryOffset = 0,
+                    .flags = {},
+                };
+                if (bind.resident)
+                {
+                    auto const [allocation, allocation_info] = allocate_page(buffer_slot.sparse_memory_requirements, page_size);
+                    page = allocation;
+                    memory_bind.memory = allocation_info.deviceMemory;
+                    memory_bind.memoryOffset = allocation_info.offset;
+                }
+                else
+                {
+                    freed_pages.push_back(page);
+                    page = VK_NULL_HANDLE;
+                }
+                memory_binds.push_back(memory_bind);
+            }
+            if (!memory_binds.empty())
+            {
+                buffer_bind_infos.push_back(VkSparseBufferMemoryBindInfo{
+                    .buffer = buffer_slot.vk_buffer,
+                    .bindCount = static_cast<u32>(memory_binds.size()),
+                    .pBinds = memory_binds.data(),
+                });
+            }
+        }
+
+        for (usize bind_index = 0; bind_index < info.image_binds.size(); ++bind_index)
+        {
+            SparseImageBind const & bind = info.image_binds[bind_index];
+            ImplImageSlot & image_slot = impl.gpu_shader_resource_table.image_slots.dereference_id(bind.image);
+            DAXA_DBG_ASSERT_TRUE_M(std::holds_alternative<SparseAllocInfo>(image_slot.info.allocate_info), "can only bind memory to sparse images");
+            DAXA_DBG_ASSERT_TRUE_M(bind.mip_level < image_slot.info.mip_level_count && bind.array_layer < image_slot.info.array_layer_count, "sparse bind exceeds the subresources of the image");
+            VkSparseImageMemoryRequirements const & sparse_requirements = image_slot.sparse_image_requirements;
+            VkExtent3D const granularity = sparse_requirements.formatProperties.imageGranularity;
+            VkDeviceSize const page_size = image_slot.sparse_memory_requirements.alignment;
+
+            auto bind_tile = [&](u64 tile_key, VkDeviceSize size) -> std::optional<std::pair<VkDeviceMemory, VkDeviceSize>>
+            {
+                auto iter = image_slot.sparse_tiles.find(tile_key);
+                if ((iter != image_slot.sparse_tiles.end()) == bind.resident)
+                {
+                    return std::nullopt;
+                }
+                if (bind.resident)
+                {
+                    auto const [allocation, allocation_info] = allocate_page(image_slot.sparse_memory_requirements, size);
+                    image_slot.sparse_tiles[tile_key] = allocation;
+                    return std::pair{allocation_info.deviceMemory, allocation_info.offset};
+                }
+                freed_pages.push_back(iter->second);
+                image_slot.sparse_tiles.erase(iter);
+                return std::pair{VkDeviceMemory{VK_NULL_HANDLE}, VkDeviceSize{0}};
+            };
+
+            if (bind.mip_level >= sparse_requirements.imageMipTailFirstLod)
+            {
+                // The mip tail has no tile layout, it is bound as opaque memory.
+                bool const single_mip_tail = (sparse_requirements.formatProperties.flags & VK_SPARSE_IMAGE_FORMAT_SINGLE_MIPTAIL_BIT) != 0;
+                u32 const tail_layer = single_mip_tail ? 0 : bind.array_layer;
+                auto const memory = bind_tile(sparse_tile_key(tail_layer, sparse_requirements.imageMipTailFirstLod, 0, 0, 0), sparse_requirements.imageMipTailSize);
+                if (memory.has_value())
+                {
+                    image_opaque_memory_binds[bind_index].push_back(VkSparseMemoryBind{
+                        .resourceOffset = sparse_requirements.imageMipTailOffset + tail_layer * sparse_requirements.imageMipTailStride,
+                        .size = sparse_requirements.imageMipTailSize,
+                        .memory = memory->first,
+                        .memoryOffset = memory->second,
+                        .flags = {},
+                    });
+                    image_opaque_bind_infos.push_back(VkSparseImageOpaqueMemoryBindInfo{
+                        .image = image_slot.vk_image,
+                        .bindCount = 1,
+                        .pBinds = image_opaque_memory_binds[bind_index].data(),
+                    });
+                }
+                continue;
+            }
+
+            u32 const mip_x = std::max(image_slot.info.size.x >> bind.mip_level, 1u);
+            u32 const mip_y = std::max(image_slot.info.size.y >> bind.mip_level, 1u);
+            u32 const mip_z = std::max(image_slot.info.size.z >> bind.mip_level, 1u);
+            auto & memory_binds = image_memory_binds[bind_index];
+            for (u32 tile_z = static_cast<u32>(bind.first_tile.z); tile_z < static_cast<u32>(bind.first_tile.z) + bind.tile_count.z; ++tile_z)
+            {
+                for (u32 tile_y = static_cast<u32>(bind.first_tile.y); tile_y < static_cast<u32>(bind.first_tile.y) + bind.tile_count.y; ++tile_y)
+                {
+                    for (u32 tile_x = static_cast<u32>(bind.first_tile.x); tile_x < static_cast<u32>(bind.first_tile.x) + bind.tile_count.x; ++tile_x)
+                    {
+                        VkOffset3D const offset{
+                            .x = static_cast<i32>(tile_x * granularity.width),
+                            .y = static_cast<i32>(tile_y * granularity.height),
+                            .z = static_cast<i32>(tile_z * granularity.depth),
+                        };
+                        DAXA_DBG_ASSERT_TRUE_M(static_cast<u32>(offset.x) < mip_x && static_cast<u32>(offset.y) < mip_y && static_cast<u32>(offset.z) < mip_z, "sparse bind exceeds the tiles of the mip level");
+                        auto const memory = bind_tile(sparse_tile_key(bind.array_layer, bind.mip_level, tile_x, tile_y, tile_z), page_size);
+                        if (!memory.has_value())
+                        {
+                            continue;
+                        }
+                        // Tiles at the border of the mip level are cut off at its extent.
+                        memory_binds.push_back(VkSparseImageMemoryBind{
+                            .subresource = {
+                                .aspectMask = image_slot.aspect_flags,
+                                .mipLevel = bind.mip_level,
+                                .arrayLayer = bind.array_layer,
+                            },
+                            .offset = offset,
+                            .extent = {
+                                .width = std::min(granularity.width, mip_x - static_cast<u32>(offset.x)),
+                                .height = std::min(granularity.height, mip_y - static_cast<u32>(offset.y)),
+                                .depth = std::min(granularity.depth, mip_z - static_cast<u32>(offset.z)),
+                            },
+                            .memory = memory->first,
+                            .memoryOffset = memory->second,
+                            .flags = {},
+                        });
+                    }
+                }
+            }
+            if (!memory_binds.empty())
+            {
+                image_bind_infos.push_back(VkSparseImageMemoryBindInfo{
+                    .image = image_slot.vk_image,
+                    .bindCount = static_cast<u32>(memory_binds.size()),
+                    .pBinds = memory_binds.data(),
+                });
+            }
+        }
+
+        // The bind waits for all previous submissions, so that unbound memory is no longer in use.
+        u64 const bind_timeline_value = DAXA_ATOMIC_FETCH_INC(impl.main_queue_cpu_timeline) + 1;
+
+        std::vector<VkSemaphore> wait_semaphores = {impl.vk_main_queue_gpu_timeline_semaphore};
+        std::vector<u64> wait_values = {bind_timeline_value - 1};
+        for (auto const & [timeline_semaphore, wait_value] : info.wait_timeline_semaphores)
+        {
+            wait_semaphores.push_back(timeline_semaphore.as<ImplTimelineSemaphore>()->vk_semaphore);
+            wait_values.push_back(wait_value);
+        }
+        std::vector<VkSemaphore> signal_semaphores = {impl.vk_main_queue_gpu_timeline_semaphore};
+        std::vector<u64> signal_values = {bind_timeline_value};
+        for (auto const & [timeline_semaphore, signal_value] : info.signal_timeline_semaphores)
+        {
+            signal_semaphores.push_back(timeline_semaphore.as<ImplTimelineSemaphore>()->vk_semaphore);
+            signal_values.push_back(signal_value);
+        }
+
+        VkTimelineSemaphoreSubmitInfo const timeline_info{
+            .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+            .pNext = nullptr,
+            .waitSemaphoreValueCount = static_cast<u32>(wait_values.size()),
+            .pWaitSemaphoreValues = wait_values.data(),
+            .signalSemaphoreValueCount = static_cast<u32>(signal_values.size()),
+            .pSignalSemaphoreValues = signal_values.data(),
+        };
+        VkBindSparseInfo const vk_bind_sparse_info{
+            .sType = VK_STRUCTURE_TYPE_BIND_SPARSE_INFO,
+            .pNext = &timeline_info,
+            .waitSemaphoreCount = static_cast<u32>(wait_semaphores.size()),
+            .pWaitSemaphores = wait_semaphores.data(),
+            .bufferBindCount = static_cast<u32>(buffer_bind_infos.size()),
+            .pBufferBinds = buffer_bind_infos.data(),
+            .imageOpaqueBindCount = static_cast<u32>(image_opaque_bind_infos.size()),
+            .pImageOpaqueBinds = image_opaque_bind_infos.data(),
+            .imageBindCount = static_cast<u32>(image_bind_infos.size()),
+            .pImageBinds = image_bind_infos.data(),
+            .signalSemaphoreCount = static_cast<u32>(signal_semaphores.size()),
+            .pSignalSemaphores = signal_semaphores.data(),
+        };
+        [[maybe_unused]] VkResult const result = vkQueueBindSparse(impl.main_queue_vk_queue, 1, &vk_bind_sparse_info, VK_NULL_HANDLE);
+        DAXA_DBG_ASSERT_TRUE_M(result == VK_SUCCESS, "failed to bind sparse memory");
+        impl.main_queue_sparse_bind_timeline_value = bind_timeline_value;
+
+        DAXA_ONLY_IF_THREADSAFETY(std::unique_lock const lock{impl.main_queue_zombies_mtx});
+        for (VmaAllocation const page : freed_pages)
+        {
+            impl.main_queue_memory_block_zombies.push_front({bind_timeline_value, MemoryBlockZombie{.allocation = page}});
+        }
+    }
+
+    auto Device::sparse_residency(BufferId id) const -> SparseResidency
+    {
+        auto const & impl = *as<ImplDevice>();
+        ImplBufferSlot const & buffer_slot = impl.slot(id);
+        DAXA_DBG_ASSERT_TRUE_M(std::holds_alternative<SparseAllocInfo>(buffer_slot.info.allocate_info), "can only query the residency of sparse buffers");
+        return SparseResidency{
+            .page_size = static_cast<usize>(buffer_slot.sparse_memory_requirements.alignment),
+            .tile_extent = {},
+            .mip_tail_first_lod = {},
+            .page_count = buffer_slot.sparse_pages.size(),
+            .resident_page_count = static_cast<usize>(std::count_if(buffer_slot.sparse_pages.begin(), buffer_slot.sparse_pages.end(), [](VmaAllocation page)
+                                                                    { return page != VK_NULL_HANDLE; })),
+        };
+    }
+
+    auto Device::sparse_residency(ImageId id) const -> SparseResidency
+    {
+        auto const & impl = *as<ImplDevice>();
+        ImplImageSlot const & image_slot = impl.slot(id);
+        DAXA_DBG_ASSERT_TRUE_M(std::holds_alternative<SparseAllocInfo>(image_slot.info.allocate_info), "can only query the residency of sparse images");
+        VkSparseImageMemoryRequirements const & sparse_requirements = image_slot.sparse_image_requirements;
+        VkExtent3D const granularity = sparse_requirements.formatProperties.imageGranularity;
+        usize tiles_per_layer = {};
+        for (u32 mip_level = 0; mip_level < std::min(sparse_requirements.imageMipTailFirstLod, image_slot.info.mip_level_count); ++mip_level)
+        {
+            u32 const mip_x = std::max(image_slot.info.size.x >> mip_level, 1u);
+            u32 const mip_y = std::max(image_slot.info.size.y >> mip_level, 1u);
+            u32 const mip_z = std::max(image_slot.info.size.z >> mip_level, 1u);
+            tiles_per_layer += static_cast<usize>((mip_x + granularity.width - 1) / granularity.width) *
+                               static_cast<usize>((mip_y + granularity.height - 1) / granularity.height) *
+                               static_cast<usize>((mip_z + granularity.depth - 1) / granularity.depth);
+        }
+        bool const has_mip_tail = sparse_requirements.imageMipTailFirstLod < image_slot.info.mip_level_count;
+        bool const single_mip_tail = (sparse_requirements.formatProperties.flags & VK_SPARSE_IMAGE_FORMAT_SINGLE_MIPTAIL_BIT) != 0;
+        usize const mip_tail_count = !has_mip_tail ? 0 : (single_mip_tail ? 1 : image_slot.info.array_layer_count);
+        return SparseResidency{
+            .page_size = static_cast<usize>(image_slot.sparse_memory_requirements.alignment),
+            .tile_extent = std::bit_cast<Extent3D>(granularity),
+            .mip_tail_first_lod = sparse_requirements.imageMipTailFirstLod,
+            .page_count = tiles_per_layer * image_slot.info.array_layer_count + mip_tail_count,
+            .resident_page_count = image_slot.sparse_tiles.size(),
+        };
+    }
+
+    auto Device::memory_statistics() const -> DeviceMemoryStatistics
+    {
+        auto const & impl = *as<ImplDevice>();
+        VkPhysicalDeviceMemoryProperties const * memory_properties = {};
+        vmaGetMemoryProperties(impl.vma_allocator, &memory_properties);
+        std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> budgets = {};
+        vmaGetHeapBudgets(impl.vma_allocator, budgets.data());
+        VmaTotalStatistics total_statistics = {};
+        vmaCalculateStatistics(impl.vma_allocator, &total_statistics);
+
+        DeviceMemoryStatistics ret = {};
+        ret.heaps.reserve(memory_properties->memoryHeapCount);
+        for (u32 heap_index = 0; heap_index < memory_properties->memoryHeapCount; ++heap_index)
+        {
+            VmaBudget const & budget = budgets[heap_index];
+            VmaDetailedStatistics const & heap_statistics = total_statistics.memoryHeap[heap_index];
+            ret.heaps.push_back(MemoryHeapStatistics{
+                .budget = static_cast<usize>(budget.budget),
+                .usage = static_cast<usize>(budget.usage),
+                .block_bytes = static_cast<usize>(heap_statistics.statistics.blockBytes),
+                .allocation_bytes = static_cast<usize>(heap_statistics.statistics.allocationBytes),
+                .block_count = heap_statistics.statistics.blockCount,
+                .allocation_count = heap_statistics.statistics.allocationCount,
+                .device_local = (memory_properties->memoryHeaps[heap_index].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0,
+            });
+        }
+        ret.buffers = impl.buffer_memory_counter.statistics();
+        ret.host_accessible_buffers = impl.host_accessible_buffer_memory_counter.statistics();
+        ret.images = impl.image_memory_counter.statistics();
+        ret.memory_blocks = impl.memory_block_memory_counter.statistics();
+
+        VmaDetailedStatistics const & total = total_statistics.total;
+        ret.unused_range_count = total.unusedRangeCount;
+        ret.unused_range_bytes = static_cast<usize>(total.statistics.blockBytes - total.statistics.allocationBytes);
+        ret.largest_unused_range = total.unusedRangeCount != 0 ? static_cast<usize>(total.unusedRangeSizeMax) : 0;
+        ret.fragmentation = ret.unused_range_bytes != 0 ? 1.0f - static_cast<f32>(static_cast<f64>(ret.largest_unused_range) / static_cast<f64>(ret.unused_range_bytes)) : 0.0f;
+        return ret;
+    }
+
+    auto Device::memory_statistics_json(bool detailed_map) const -> std::string
+    {
+        auto const & impl = *as<ImplDevice>();
+        char * stats_string = {};
+        vmaBuildStatsString(impl.vma_allocator, &stats_string, static_cast<VkBool32>(detailed_map));
+        std::string ret = stats_string;
+        vmaFreeStatsString(impl.vma_allocator, stats_string);
+        return ret;
+    }
+
     auto Device::create_buffer(BufferInfo const & info) -> BufferId
     {
         auto & impl = *as<ImplDevice>();
@@ -455,6 +1090,46 @@ namespace daxa
         return !id.is_empty() && impl.gpu_shader_resource_table.sampler_slots.is_id_valid(id);
     }
 
+    void ImplDevice::end_defragmentation_pass()
+    {
+        // The gpu finished the copies and all submissions that could have used the old buffers.
+        for (VkBuffer const old_vk_buffer : this->defragmentation_old_buffers)
+        {
+            if (old_vk_buffer != VK_NULL_HANDLE)
+            {
+                vkDestroyBuffer(this->vk_device, old_vk_buffer, nullptr);
+            }
+        }
+        this->defragmentation_old_buffers.clear();
+        this->defragmentation_pass_pending = false;
+        // Frees the old memory and rebinds the moved allocations to their new memory.
+        if (vmaEndDefragmentationPass(this->vma_allocator, this->vma_defragmentation_context, &this->vma_defragmentation_pass) == VK_SUCCESS)
+        {
+            vmaEndDefragmentation(this->vma_allocator, this->vma_defragmentation_context, nullptr);
+            this->vma_defragmentation_context = {};
+        }
+    }
+
+    void ImplResourceMemoryCounter::add(u64 size)
+    {
+        DAXA_ATOMIC_FETCH_INC(this->count);
+        DAXA_ATOMIC_ADD_FETCH(this->bytes, size);
+    }
+
+    void ImplResourceMemoryCounter::remove(u64 size)
+    {
+        DAXA_ATOMIC_FETCH_DEC(this->count);
+        DAXA_ATOMIC_SUB_FETCH(this->bytes, size);
+    }
+
+    auto ImplResourceMemoryCounter::statistics() const -> ResourceMemoryStatistics
+    {
+        return ResourceMemoryStatistics{
+            .count = static_cast<u32>(DAXA_ATOMIC_FETCH(this->count)),
+            .bytes = static_cast<usize>(DAXA_ATOMIC_FETCH(this->bytes)),
+        };
+    }
+
     ImplDevice::ImplDevice(DeviceInfo a_info, ManagedWeakPtr a_impl_ctx, VkPhysicalDevice a_physical_device)
         : impl_ctx{std::move(a_impl_ctx)},
           vk_physical_device{a_physical_device},
@@ -505,6 +1180,26 @@ namespace daxa
             .pQueuePriorities = queue_priorities.data(),
         };
 
+        // Sparse residency of 3d images and shader residency queries are not supported everywhere, they are only enabled when available.
+        // The same goes for precise occlusion and pipeline statistics queries.
+        VkPhysicalDeviceFeatures supported_physical_device_features = {};
+        vkGetPhysicalDeviceFeatures(a_physical_device, &supported_physical_device_features);
+        this->precise_occlusion_queries_enabled = supported_physical_device_features.occlusionQueryPrecise == VK_TRUE;
+        this->pipeline_statistics_queries_enabled = supported_physical_device_features.pipelineStatisticsQuery == VK_TRUE;
+        this->sparse_resources_supported =
+            supported_physical_device_features.sparseBinding == VK_TRUE &&
+            supported_physical_device_features.sparseResidencyBuffer == VK_TRUE &&
+            supported_physical_device_features.sparseResidencyImage2D == VK_TRUE &&
+            (queue_props[this->main_queue_family_index].queueFlags & VK_QUEUE_SPARSE_BINDING_BIT) != 0;
+        bool const enable_sparse = this->info.enable_sparse_resources;
+        if (enable_sparse)
+        {
+            DAXA_DBG_ASSERT_TRUE_M(supported_physical_device_features.sparseBinding == VK_TRUE, "sparse resources require the device to support sparseBinding");
+            DAXA_DBG_ASSERT_TRUE_M(supported_physical_device_features.sparseResidencyBuffer == VK_TRUE, "sparse resources require the device to support sparseResidencyBuffer");
+            DAXA_DBG_ASSERT_TRUE_M(supported_physical_device_features.sparseResidencyImage2D == VK_TRUE, "sparse resources require the device to support sparseResidencyImage2D");
+            DAXA_DBG_ASSERT_TRUE_M((queue_props[this->main_queue_family_index].queueFlags & VK_QUEUE_SPARSE_BINDING_BIT) != 0, "sparse resources require the main queue to support sparse binding");
+        }
+
         VkPhysicalDeviceFeatures const REQUIRED_PHYSICAL_DEVICE_FEATURES{
             .robustBufferAccess = VK_FALSE,
             .fullDrawIndexUint32 = VK_FALSE,
@@ -529,8 +1224,8 @@ namespace daxa
             .textureCompressionETC2 = VK_FALSE,
             .textureCompressionASTC_LDR = VK_FALSE,
             .textureCompressionBC = VK_FALSE,
-            .occlusionQueryPrecise = VK_FALSE,
-            .pipelineStatisticsQuery = VK_FALSE,
+            .occlusionQueryPrecise = supported_physical_device_features.occlusionQueryPrecise,
+            .pipelineStatisticsQuery = supported_physical_device_features.pipelineStatisticsQuery,
             .vertexPipelineStoresAndAtomics = VK_FALSE,
             .fragmentStoresAndAtomics = VK_TRUE,
             .shaderTessellationAndGeometryPointSize = VK_FALSE,
@@ -548,12 +1243,12 @@ namespace daxa
             .shaderFloat64 = VK_FALSE,
             .shaderInt64 = VK_TRUE, // Used for buffer device address math.
             .shaderInt16 = VK_FALSE,
-            .shaderResourceResidency = VK_FALSE,
+            .shaderResourceResidency = enable_sparse ? supported_physical_device_features.shaderResourceResidency : VK_FALSE,
             .shaderResourceMinLod = VK_FALSE,
-            .sparseBinding = VK_FALSE,
-            .sparseResidencyBuffer = VK_FALSE,
-            .sparseResidencyImage2D = VK_FALSE,
-            .sparseResidencyImage3D = VK_FALSE,
+            .sparseBinding = enable_sparse ? supported_physical_device_features.sparseBinding : VK_FALSE,
+            .sparseResidencyBuffer = enable_sparse ? supported_physical_device_features.sparseResidencyBuffer : VK_FALSE,
+            .sparseResidencyImage2D = enable_sparse ? supported_physical_device_features.sparseResidencyImage2D : VK_FALSE,
+            .sparseResidencyImage3D = enable_sparse ? supported_physical_device_features.sparseResidencyImage3D : VK_FALSE,
             .sparseResidency2Samples = VK_FALSE,
             .sparseResidency4Samples = VK_FALSE,
             .sparseResidency8Samples = VK_FALSE,
@@ -674,6 +1369,38 @@ namespace daxa
             extension_names.push_back(VK_EXT_CONSERVATIVE_RASTERIZATION_EXTENSION_NAME);
         }
 
+        // Memory budget is optional, without it the reported heap budgets are only estimates.
+        bool memory_budget_supported = false;
+        bool shader_object_supported = false;
+        bool extended_dynamic_state_3_supported = false;
+        bool graphics_pipeline_library_supported = false;
+        {
+            u32 available_extension_count = {};
+            vkEnumerateDeviceExtensionProperties(a_physical_device, nullptr, &available_extension_count, nullptr);
+            std::vector<VkExtensionProperties> available_extensions(available_extension_count);
+            vkEnumerateDeviceExtensionProperties(a_physical_device, nullptr, &available_extension_count, available_extensions.data());
+            for (auto const & extension : available_extensions)
+            {
+                if (std::strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0)
+                {
+                    memory_budget_supported = true;
+                    extension_names.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+                }
+                if (std::strcmp(extension.extensionName, VK_EXT_SHADER_OBJECT_EXTENSION_NAME) == 0)
+                {
+                    shader_object_supported = true;
+                }
+                if (std::strcmp(extension.extensionName, VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME) == 0)
+                {
+                    extended_dynamic_state_3_supported = true;
+                }
+                if (std::strcmp(extension.extensionName, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME) == 0)
+                {
+                    graphics_pipeline_library_supported = true;
+                }
+            }
+        }
+
         // Mesh shading
         VkPhysicalDeviceMeshShaderFeaturesEXT REQUIRED_PHYSICAL_DEVICE_FEATURES_MESH_SHADER{
             .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT,
@@ -690,6 +1417,67 @@ namespace daxa
             REQUIRED_DEVICE_FEATURE_P_CHAIN = reinterpret_cast<void *>(&REQUIRED_PHYSICAL_DEVICE_FEATURES_MESH_SHADER);
         }
 
+        // Shader object
+        VkPhysicalDeviceShaderObjectFeaturesEXT REQUIRED_PHYSICAL_DEVICE_FEATURES_SHADER_OBJECT{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_OBJECT_FEATURES_EXT,
+            .pNext = REQUIRED_DEVICE_FEATURE_P_CHAIN,
+            .shaderObject = VK_TRUE,
+        };
+        this->shader_object_enabled = this->info.enable_shader_object && shader_object_supported;
+        if (this->shader_object_enabled)
+        {
+            extension_names.push_back(VK_EXT_SHADER_OBJECT_EXTENSION_NAME);
+            REQUIRED_DEVICE_FEATURE_P_CHAIN = reinterpret_cast<void *>(&REQUIRED_PHYSICAL_DEVICE_FEATURES_SHADER_OBJECT);
+        }
+
+        // Extended dynamic state 3
+        VkPhysicalDeviceExtendedDynamicState3FeaturesEXT REQUIRED_PHYSICAL_DEVICE_FEATURES_EXTENDED_DYNAMIC_STATE_3{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT,
+            .pNext = REQUIRED_DEVICE_FEATURE_P_CHAIN,
+            .extendedDynamicState3DepthClampEnable = VK_TRUE,
+            .extendedDynamicState3PolygonMode = VK_TRUE,
+            .extendedDynamicState3ColorBlendEnable = VK_TRUE,
+            .extendedDynamicState3ColorBlendEquation = VK_TRUE,
+            .extendedDynamicState3ColorWriteMask = VK_TRUE,
+        };
+        if (this->info.enable_extended_dynamic_state_3 && extended_dynamic_state_3_supported)
+        {
+            // The extension does not guarantee any of its features, only enable it when all the used ones are supported.
+            VkPhysicalDeviceExtendedDynamicState3FeaturesEXT supported_extended_dynamic_state_3 = {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT,
+            };
+            VkPhysicalDeviceFeatures2 supported_features_2 = {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+                .pNext = &supported_extended_dynamic_state_3,
+            };
+            vkGetPhysicalDeviceFeatures2(a_physical_device, &supported_features_2);
+            this->extended_dynamic_state_3_enabled =
+                supported_extended_dynamic_state_3.extendedDynamicState3DepthClampEnable == VK_TRUE &&
+                supported_extended_dynamic_state_3.extendedDynamicState3PolygonMode == VK_TRUE &&
+                supported_extended_dynamic_state_3.extendedDynamicState3ColorBlendEnable == VK_TRUE &&
+                supported_extended_dynamic_state_3.extendedDynamicState3ColorBlendEquation == VK_TRUE &&
+                supported_extended_dynamic_state_3.extendedDynamicState3ColorWriteMask == VK_TRUE;
+        }
+        if (this->extended_dynamic_state_3_enabled)
+        {
+            extension_names.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME);
+            REQUIRED_DEVICE_FEATURE_P_CHAIN = reinterpret_cast<void *>(&REQUIRED_PHYSICAL_DEVICE_FEATURES_EXTENDED_DYNAMIC_STATE_3);
+        }
+
+        // Graphics pipeline library
+        VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT REQUIRED_PHYSICAL_DEVICE_FEATURES_GRAPHICS_PIPELINE_LIBRARY{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT,
+            .pNext = REQUIRED_DEVICE_FEATURE_P_CHAIN,
+            .graphicsPipelineLibrary = VK_TRUE,
+        };
+        this->graphics_pipeline_library_enabled = this->info.enable_graphics_pipeline_library && graphics_pipeline_library_supported;
+        if (this->graphics_pipeline_library_enabled)
+        {
+            extension_names.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+            extension_names.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+            REQUIRED_DEVICE_FEATURE_P_CHAIN = reinterpret_cast<void *>(&REQUIRED_PHYSICAL_DEVICE_FEATURES_GRAPHICS_PIPELINE_LIBRARY);
+        }
+
         VkPhysicalDeviceFeatures2 physical_device_features_2{
             .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
             .pNext = REQUIRED_DEVICE_FEATURE_P_CHAIN,
@@ -736,6 +1524,30 @@ namespace daxa
             }
         }
 
+        if (this->shader_object_enabled)
+        {
+            this->vkCreateShadersEXT = reinterpret_cast<PFN_vkCreateShadersEXT>(vkGetDeviceProcAddr(this->vk_device, "vkCreateShadersEXT"));
+            this->vkDestroyShaderEXT = reinterpret_cast<PFN_vkDestroyShaderEXT>(vkGetDeviceProcAddr(this->vk_device, "vkDestroyShaderEXT"));
+            this->vkCmdBindShadersEXT = reinterpret_cast<PFN_vkCmdBindShadersEXT>(vkGetDeviceProcAddr(this->vk_device, "vkCmdBindShadersEXT"));
+        }
+        // Shader objects expose the dynamic state setters of extended dynamic state 3 as well.
+        if (this->shader_object_enabled || this->extended_dynamic_state_3_enabled)
+        {
+            this->vkCmdSetPolygonModeEXT = reinterpret_cast<PFN_vkCmdSetPolygonModeEXT>(vkGetDeviceProcAddr(this->vk_device, "vkCmdSetPolygonModeEXT"));
+            this->vkCmdSetRasterizationSamplesEXT = reinterpret_cast<PFN_vkCmdSetRasterizationSamplesEXT>(vkGetDeviceProcAddr(this->vk_device, "vkCmdSetRasterizationSamplesEXT"));
+            this->vkCmdSetSampleMaskEXT = reinterpret_cast<PFN_vkCmdSetSampleMaskEXT>(vkGetDeviceProcAddr(this->vk_device, "vkCmdSetSampleMaskEXT"));
+            this->vkCmdSetAlphaToCoverageEnableEXT = reinterpret_cast<PFN_vkCmdSetAlphaToCoverageEnableEXT>(vkGetDeviceProcAddr(this->vk_device, "vkCmdSetAlphaToCoverageEnableEXT"));
+            this->vkCmdSetColorBlendEnableEXT = reinterpret_cast<PFN_vkCmdSetColorBlendEnableEXT>(vkGetDeviceProcAddr(this->vk_device, "vkCmdSetColorBlendEnableEXT"));
+            this->vkCmdSetColorBlendEquationEXT = reinterpret_cast<PFN_vkCmdSetColorBlendEquationEXT>(vkGetDeviceProcAddr(this->vk_device, "vkCmdSetColorBlendEquationEXT"));
+            this->vkCmdSetColorWriteMaskEXT = reinterpret_cast<PFN_vkCmdSetColorWriteMaskEXT>(vkGetDeviceProcAddr(this->vk_device, "vkCmdSetColorWriteMaskEXT"));
+            this->vkCmdSetDepthClampEnableEXT = reinterpret_cast<PFN_vkCmdSetDepthClampEnableEXT>(vkGetDeviceProcAddr(this->vk_device, "vkCmdSetDepthClampEnableEXT"));
+            this->vkCmdSetVertexInputEXT = reinterpret_cast<PFN_vkCmdSetVertexInputEXT>(vkGetDeviceProcAddr(this->vk_device, "vkCmdSetVertexInputEXT"));
+            this->vkCmdSetPatchControlPointsEXT = reinterpret_cast<PFN_vkCmdSetPatchControlPointsEXT>(vkGetDeviceProcAddr(this->vk_device, "vkCmdSetPatchControlPointsEXT"));
+            this->vkCmdSetTessellationDomainOriginEXT = reinterpret_cast<PFN_vkCmdSetTessellationDomainOriginEXT>(vkGetDeviceProcAddr(this->vk_device, "vkCmdSetTessellationDomainOriginEXT"));
+            this->vkCmdSetConservativeRasterizationModeEXT = reinterpret_cast<PFN_vkCmdSetConservativeRasterizationModeEXT>(vkGetDeviceProcAddr(this->vk_device, "vkCmdSetConservativeRasterizationModeEXT"));
+            this->vkCmdSetExtraPrimitiveOverestimationSizeEXT = reinterpret_cast<PFN_vkCmdSetExtraPrimitiveOverestimationSizeEXT>(vkGetDeviceProcAddr(this->vk_device, "vkCmdSetExtraPrimitiveOverestimationSizeEXT"));
+        }
+
         vkGetDeviceQueue(this->vk_device, this->main_queue_family_index, 0, &this->main_queue_vk_queue);
 
         VkCommandPool init_cmd_pool = {};
@@ -844,7 +1656,7 @@ namespace daxa
         };
 
         VmaAllocatorCreateInfo const vma_allocator_create_info{
-            .flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT,
+            .flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT | (memory_budget_supported ? VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT : VmaAllocatorCreateFlags{}),
             .physicalDevice = this->vk_physical_device,
             .device = this->vk_device,
             .preferredLargeHeapBlockSize = 0, // Sets it to lib internal default (256MiB).
@@ -859,6 +1671,19 @@ namespace daxa
 
         vmaCreateAllocator(&vma_allocator_create_info, &this->vma_allocator);
 
+        {
+            std::vector<std::byte> const pipeline_cache_data = this->read_pipeline_cache_file();
+            VkPipelineCacheCreateInfo const vk_pipeline_cache_create_info{
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = {},
+                .initialDataSize = pipeline_cache_data.size(),
+                .pInitialData = pipeline_cache_data.data(),
+            };
+            [[maybe_unused]] VkResult const result = vkCreatePipelineCache(this->vk_device, &vk_pipeline_cache_create_info, nullptr, &this->vk_pipeline_cache);
+            DAXA_DBG_ASSERT_TRUE_M(result == VK_SUCCESS, "failed to create pipeline cache");
+        }
+
         {
             auto buffer_data = std::array<u8, 4>{0xff, 0x00, 0xff, 0xff};
 
@@ -1121,6 +1946,7 @@ namespace daxa
 
     void ImplDevice::main_queue_collect_garbage()
     {
+        DAXA_TRACE_SCOPE("ImplDevice::main_queue_collect_garbage");
         DAXA_ONLY_IF_THREADSAFETY(std::unique_lock lock{this->main_queue_zombies_mtx});
 
         u64 gpu_timeline_value = std::numeric_limits<u64>::max();
@@ -1157,12 +1983,20 @@ namespace daxa
                     this->buffer_pool_pool.put_back({command_list_zombie.vk_cmd_pool, command_list_zombie.vk_cmd_buffer});
                 });
         }
-        check_and_cleanup_gpu_resources(
-            this->main_queue_buffer_zombies,
-            [&](auto id)
-            {
-                this->cleanup_buffer(id);
-            });
+        if (this->defragmentation_pass_pending && this->defragmentation_pass_timeline_value <= gpu_timeline_value)
+        {
+            this->end_defragmentation_pass();
+        }
+        // Buffers must not be freed while a defragmentation pass may be moving them.
+        if (!this->defragmentation_pass_pending)
+        {
+            check_and_cleanup_gpu_resources(
+                this->main_queue_buffer_zombies,
+                [&](auto id)
+                {
+                    this->cleanup_buffer(id);
+                });
+        }
         check_and_cleanup_gpu_resources(
             this->main_queue_image_view_zombies, [&](auto id)
             { this->cleanup_image_view(id); });
@@ -1183,6 +2017,13 @@ namespace daxa
             [&](auto & pipeline_zombie)
             {
                 vkDestroyPipeline(this->vk_device, pipeline_zombie.vk_pipeline, nullptr);
+                for (auto vk_shader : pipeline_zombie.vk_shaders)
+                {
+                    if (vk_shader != VK_NULL_HANDLE)
+                    {
+                        this->vkDestroyShaderEXT(this->vk_device, vk_shader, nullptr);
+                    }
+                }
             });
         check_and_cleanup_gpu_resources(
             this->main_queue_semaphore_zombies,
@@ -1202,6 +2043,12 @@ namespace daxa
             {
                 vkDestroyQueryPool(this->vk_device, timeline_query_pool_zombie.vk_timeline_query_pool, nullptr);
             });
+        check_and_cleanup_gpu_resources(
+            this->main_queue_memory_block_zombies,
+            [&](auto & memory_block_zombie)
+            {
+                vmaFreeMemory(this->vma_allocator, memory_block_zombie.allocation);
+            });
     }
 
     void ImplDevice::wait_idle() const
@@ -1210,8 +2057,14 @@ namespace daxa
         vkDeviceWaitIdle(this->vk_device);
     }
 
+    auto ImplDevice::buffer_descriptor_range(usize size) const -> VkDeviceSize
+    {
+        return std::min(static_cast<VkDeviceSize>(size), static_cast<VkDeviceSize>(this->vk_info.limits.max_storage_buffer_range));
+    }
+
     auto ImplDevice::new_buffer(BufferInfo const & buffer_info) -> BufferId
     {
+        DAXA_TRACE_SCOPE("ImplDevice::new_buffer");
         auto [id, ret] = gpu_shader_resource_table.buffer_slots.new_slot();
 
         DAXA_DBG_ASSERT_TRUE_M(buffer_info.size > 0, "can not create buffers with size zero");
@@ -1249,12 +2102,25 @@ namespace daxa
                 .preferredFlags = {},
                 .memoryTypeBits = std::numeric_limits<u32>::max(),
                 .pool = nullptr,
-                .pUserData = nullptr,
+                // Only device local buffers can be moved by defragmentation, host pointers into mapped buffers must stay valid.
+                .pUserData = host_accessible ? nullptr : reinterpret_cast<void *>(static_cast<usize>(std::bit_cast<u32>(id)) + 1),
                 .priority = 0.5f,
             };
 
             [[maybe_unused]] VkResult const vk_create_buffer_result = vmaCreateBuffer(this->vma_allocator, &vk_buffer_create_info, &vma_allocation_create_info, &ret.vk_buffer, &ret.vma_allocation, &vma_allocation_info);
             DAXA_DBG_ASSERT_TRUE_M(vk_create_buffer_result == VK_SUCCESS, "failed to create buffer");
+            (host_accessible ? this->host_accessible_buffer_memory_counter : this->buffer_memory_counter).add(vma_allocation_info.size);
+        }
+        else if (std::holds_alternative<SparseAllocInfo>(buffer_info.allocate_info))
+        {
+            DAXA_DBG_ASSERT_TRUE_M(this->info.enable_sparse_resources, "sparse buffers require DeviceInfo::enable_sparse_resources");
+            VkBufferCreateInfo sparse_buffer_create_info = vk_buffer_create_info;
+            sparse_buffer_create_info.flags = VK_BUFFER_CREATE_SPARSE_BINDING_BIT | VK_BUFFER_CREATE_SPARSE_RESIDENCY_BIT;
+            [[maybe_unused]] VkResult const vk_create_buffer_result = vkCreateBuffer(this->vk_device, &sparse_buffer_create_info, nullptr, &ret.vk_buffer);
+            DAXA_DBG_ASSERT_TRUE_M(vk_create_buffer_result == VK_SUCCESS, "failed to create buffer");
+            vkGetBufferMemoryRequirements(this->vk_device, ret.vk_buffer, &ret.sparse_memory_requirements);
+            VkDeviceSize const page_size = ret.sparse_memory_requirements.alignment;
+            ret.sparse_pages.resize(static_cast<usize>((ret.sparse_memory_requirements.size + page_size - 1) / page_size), VK_NULL_HANDLE);
         }
         else
         {
@@ -1299,7 +2165,7 @@ namespace daxa
             this->vkSetDebugUtilsObjectNameEXT(vk_device, &buffer_name_info);
         }
 
-        write_descriptor_set_buffer(this->vk_device, this->gpu_shader_resource_table.vk_descriptor_set, ret.vk_buffer, 0, static_cast<VkDeviceSize>(buffer_info.size), id.index);
+        write_descriptor_set_buffer(this->vk_device, this->gpu_shader_resource_table.vk_descriptor_set, ret.vk_buffer, 0, this->buffer_descriptor_range(buffer_info.size), id.index);
 
         return BufferId{id};
     }
@@ -1411,6 +2277,7 @@ namespace daxa
 
     auto ImplDevice::new_image(ImageInfo const & image_info) -> ImageId
     {
+        DAXA_TRACE_SCOPE("ImplDevice::new_image");
         auto [id, image_slot_variant] = gpu_shader_resource_table.image_slots.new_slot();
         DAXA_DBG_ASSERT_TRUE_M(image_info.dimensions >= 1 && image_info.dimensions <= 3, "image dimensions must be a value between 1 to 3(inclusive)");
         ImplImageSlot ret = {};
@@ -1443,8 +2310,26 @@ namespace daxa
                 .priority = 0.5f,
             };
 
-            [[maybe_unused]] VkResult const vk_create_image_result = vmaCreateImage(this->vma_allocator, &vk_image_create_info, &vma_allocation_create_info, &ret.vk_image, &ret.vma_allocation, nullptr);
+            VmaAllocationInfo vma_allocation_info = {};
+            [[maybe_unused]] VkResult const vk_create_image_result = vmaCreateImage(this->vma_allocator, &vk_image_create_info, &vma_allocation_create_info, &ret.vk_image, &ret.vma_allocation, &vma_allocation_info);
             DAXA_DBG_ASSERT_TRUE_M(vk_create_image_result == VK_SUCCESS, "failed to create image");
+            this->image_memory_counter.add(vma_allocation_info.size);
+        }
+        else if (std::holds_alternative<SparseAllocInfo>(image_info.allocate_info))
+        {
+            DAXA_DBG_ASSERT_TRUE_M(this->info.enable_sparse_resources, "sparse images require DeviceInfo::enable_sparse_resources");
+            DAXA_DBG_ASSERT_TRUE_M(ret.aspect_flags == VK_IMAGE_ASPECT_COLOR_BIT, "sparse images must have a color format");
+            VkImageCreateInfo sparse_image_create_info = vk_image_create_info;
+            sparse_image_create_info.flags |= VK_IMAGE_CREATE_SPARSE_BINDING_BIT | VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT;
+            [[maybe_unused]] VkResult const vk_create_image_result = vkCreateImage(this->vk_device, &sparse_image_create_info, nullptr, &ret.vk_image);
+            DAXA_DBG_ASSERT_TRUE_M(vk_create_image_result == VK_SUCCESS, "failed to create image");
+            vkGetImageMemoryRequirements(this->vk_device, ret.vk_image, &ret.sparse_memory_requirements);
+            u32 sparse_requirement_count = {};
+            vkGetImageSparseMemoryRequirements(this->vk_device, ret.vk_image, &sparse_requirement_count, nullptr);
+            std::vector<VkSparseImageMemoryRequirements> sparse_requirements(sparse_requirement_count);
+            vkGetImageSparseMemoryRequirements(this->vk_device, ret.vk_image, &sparse_requirement_count, sparse_requirements.data());
+            DAXA_DBG_ASSERT_TRUE_M(sparse_requirement_count > 0, "image format does not support sparse residency");
+            ret.sparse_image_requirements = sparse_requirements[0];
         }
         else
         {
@@ -1529,6 +2414,7 @@ namespace daxa
 
     auto ImplDevice::new_image_view(ImageViewInfo const & image_view_info) -> ImageViewId
     {
+        DAXA_TRACE_SCOPE("ImplDevice::new_image_view");
         auto [id, image_slot] = gpu_shader_resource_table.image_slots.new_slot();
         image_slot = {};
         ImplImageSlot const & parent_image_slot = slot(image_view_info.image);
@@ -1572,6 +2458,7 @@ namespace daxa
 
     auto ImplDevice::new_sampler(SamplerInfo const & sampler_info) -> SamplerId
     {
+        DAXA_TRACE_SCOPE("ImplDevice::new_sampler");
         auto [id, ret] = gpu_shader_resource_table.sampler_slots.new_slot();
 
         ret.info = sampler_info;
@@ -1634,10 +2521,20 @@ namespace daxa
         write_descriptor_set_buffer(this->vk_device, this->gpu_shader_resource_table.vk_descriptor_set, this->vk_null_buffer, 0, VK_WHOLE_SIZE, id.index);
         if (std::holds_alternative<AutoAllocInfo>(buffer_slot.info.allocate_info))
         {
+            VmaAllocationInfo vma_allocation_info = {};
+            vmaGetAllocationInfo(this->vma_allocator, buffer_slot.vma_allocation, &vma_allocation_info);
+            (buffer_slot.host_address != nullptr ? this->host_accessible_buffer_memory_counter : this->buffer_memory_counter).remove(vma_allocation_info.size);
             vmaDestroyBuffer(this->vma_allocator, buffer_slot.vk_buffer, buffer_slot.vma_allocation);
         }
         else
         {
+            for (VmaAllocation const page : buffer_slot.sparse_pages)
+            {
+                if (page != VK_NULL_HANDLE)
+                {
+                    vmaFreeMemory(this->vma_allocator, page);
+                }
+            }
             vkDestroyBuffer(this->vk_device, buffer_slot.vk_buffer, {});
         }
         buffer_slot = {};
@@ -1653,10 +2550,17 @@ namespace daxa
         {
             if (std::holds_alternative<AutoAllocInfo>(image_slot.info.allocate_info))
             {
+                VmaAllocationInfo vma_allocation_info = {};
+                vmaGetAllocationInfo(this->vma_allocator, image_slot.vma_allocation, &vma_allocation_info);
+                this->image_memory_counter.remove(vma_allocation_info.size);
                 vmaDestroyImage(this->vma_allocator, image_slot.vk_image, image_slot.vma_allocation);
             }
             else
             {
+                for (auto const & [tile_key, tile] : image_slot.sparse_tiles)
+                {
+                    vmaFreeMemory(this->vma_allocator, tile);
+                }
                 vkDestroyImage(this->vk_device, image_slot.vk_image, {});
             }
         }
@@ -1685,9 +2589,24 @@ namespace daxa
 
     ImplDevice::~ImplDevice() // NOLINT(bugprone-exception-escape)
     {
+        stop_pipeline_compile_threads();
         wait_idle();
         main_queue_collect_garbage();
+        if (this->vma_defragmentation_context != nullptr)
+        {
+            vmaEndDefragmentation(this->vma_allocator, this->vma_defragmentation_context, nullptr);
+        }
         buffer_pool_pool.cleanup(this);
+        // Only parts still referenced by pipeline compile jobs that never ran are left.
+        for (auto const & [key, library] : this->pipeline_libraries)
+        {
+            vkDestroyPipeline(this->vk_device, library.vk_pipeline, nullptr);
+        }
+        if (!this->info.pipeline_cache_path.empty())
+        {
+            this->write_pipeline_cache_file();
+        }
+        vkDestroyPipelineCache(this->vk_device, this->vk_pipeline_cache, nullptr);
         vmaUnmapMemory(this->vma_allocator, this->buffer_device_address_buffer_allocation);
         vmaDestroyBuffer(this->vma_allocator, this->buffer_device_address_buffer, this->buffer_device_address_buffer_allocation);
         this->gpu_shader_resource_table.cleanup(this->vk_device);
@@ -1700,6 +2619,226 @@ namespace daxa
         vkDestroyDevice(this->vk_device, nullptr);
     }
 
+#if DAXA_THREADSAFETY
+    // Counts a job handed to the user executor until it ran, or until the executor dropped it without running it.
+    struct PipelineCompileExecutorJob
+    {
+        ImplDevice * device = {};
+
+        explicit PipelineCompileExecutorJob(ImplDevice * a_device) : device{a_device}
+        {
+            std::unique_lock const lock{device->pipeline_compile_mtx};
+            device->pipeline_compile_executor_jobs += 1;
+        }
+        PipelineCompileExecutorJob(PipelineCompileExecutorJob const &) = delete;
+        PipelineCompileExecutorJob & operator=(PipelineCompileExecutorJob const &) = delete;
+        ~PipelineCompileExecutorJob()
+        {
+            {
+                std::unique_lock const lock{device->pipeline_compile_mtx};
+                device->pipeline_compile_executor_jobs -= 1;
+            }
+            device->pipeline_compile_cv.notify_all();
+        }
+    };
+#endif
+
+    void ImplDevice::enqueue_pipeline_compile(std::function<void()> && task)
+    {
+#if DAXA_THREADSAFETY
+        if (this->info.pipeline_compile_executor)
+        {
+            auto job = std::make_shared<PipelineCompileExecutorJob>(this);
+            this->info.pipeline_compile_executor(
+                [job = std::move(job), task = std::move(task)]() mutable
+                {
+                    task();
+                    job.reset();
+                });
+            return;
+        }
+        std::unique_lock lock{this->pipeline_compile_mtx};
+        if (this->pipeline_compile_threads.empty())
+        {
+            u32 const thread_count = this->info.pipeline_compile_thread_count != 0
+                                         ? this->info.pipeline_compile_thread_count
+                                         : std::max(1u, std::thread::hardware_concurrency() / 2);
+            for (u32 i = 0; i < thread_count; ++i)
+            {
+                this->pipeline_compile_threads.emplace_back([this]()
+                                                            {
+                    while (true)
+                    {
+                        std::function<void()> next_task = {};
+                        {
+                            std::unique_lock worker_lock{this->pipeline_compile_mtx};
+                            this->pipeline_compile_cv.wait(worker_lock, [this]() { return this->pipeline_compile_stop || !this->pipeline_compile_tasks.empty(); });
+                            if (this->pipeline_compile_stop)
+                            {
+                                return;
+                            }
+                            next_task = std::move(this->pipeline_compile_tasks.front());
+                            this->pipeline_compile_tasks.pop_front();
+                        }
+                        next_task();
+                    } });
+            }
+        }
+        this->pipeline_compile_tasks.push_back(std::move(task));
+        lock.unlock();
+        this->pipeline_compile_cv.notify_one();
+#else
+        task();
+#endif
+    }
+
+    void ImplDevice::stop_pipeline_compile_threads()
+    {
+#if DAXA_THREADSAFETY
+        {
+            std::unique_lock const lock{this->pipeline_compile_mtx};
+            this->pipeline_compile_stop = true;
+            // Pending creations are abandoned, the device can not be used to create pipelines while it is destroyed.
+            this->pipeline_compile_tasks.clear();
+        }
+        this->pipeline_compile_cv.notify_all();
+        for (auto & thread : this->pipeline_compile_threads)
+        {
+            thread.join();
+        }
+        this->pipeline_compile_threads.clear();
+        // Jobs already handed to the user executor can not be taken back, they reference the device until they ran or were dropped.
+        std::unique_lock lock{this->pipeline_compile_mtx};
+        this->pipeline_compile_cv.wait(lock, [this]() { return this->pipeline_compile_executor_jobs == 0; });
+#endif
+    }
+
+    void ImplDevice::release_pipeline_libraries(std::span<std::string const> keys)
+    {
+        DAXA_ONLY_IF_THREADSAFETY(std::unique_lock const lock{this->pipeline_libraries_mtx});
+        for (auto const & key : keys)
+        {
+            auto const iter = this->pipeline_libraries.find(key);
+            DAXA_DBG_ASSERT_TRUE_M(iter != this->pipeline_libraries.end() && iter->second.ref_count > 0, "released an unreferenced pipeline library");
+            iter->second.ref_count -= 1;
+            if (iter->second.ref_count == 0)
+            {
+                {
+                    DAXA_ONLY_IF_THREADSAFETY(std::unique_lock const zombies_lock{this->main_queue_zombies_mtx});
+                    u64 const main_queue_cpu_timeline_value = DAXA_ATOMIC_FETCH(this->main_queue_cpu_timeline);
+                    this->main_queue_pipeline_zombies.push_front({
+                        main_queue_cpu_timeline_value,
+                        PipelineZombie{
+                            .vk_pipeline = iter->second.vk_pipeline,
+                        },
+                    });
+                }
+                this->pipeline_libraries.erase(iter);
+            }
+        }
+    }
+
+    // Returns the content of the pipeline cache file, or nothing when the file is missing or was written for another driver or device.
+    auto ImplDevice::read_pipeline_cache_file() const -> std::vector<std::byte>
+    {
+        if (this->info.pipeline_cache_path.empty())
+        {
+            return {};
+        }
+        std::ifstream ifs{this->info.pipeline_cache_path, std::ios_base::binary | std::ios_base::ate};
+        if (!ifs.good())
+        {
+            return {};
+        }
+        auto const size = static_cast<usize>(ifs.tellg());
+        if (size < sizeof(VkPipelineCacheHeaderVersionOne))
+        {
+            return {};
+        }
+        std::vector<std::byte> data(size);
+        ifs.seekg(0);
+        ifs.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(size));
+        if (!ifs.good())
+        {
+            return {};
+        }
+        // Drivers are supposed to reject foreign caches themselves, but some crash on them instead.
+        VkPipelineCacheHeaderVersionOne header = {};
+        std::memcpy(&header, data.data(), sizeof(VkPipelineCacheHeaderVersionOne));
+        bool const header_valid =
+            header.headerSize >= sizeof(VkPipelineCacheHeaderVersionOne) &&
+            header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+            header.vendorID == this->vk_info.vendor_id &&
+            header.deviceID == this->vk_info.device_id &&
+            std::memcmp(header.pipelineCacheUUID, this->vk_info.pipeline_cache_uuid, VK_UUID_SIZE) == 0;
+        if (!header_valid)
+        {
+            return {};
+        }
+        return data;
+    }
+
+    auto ImplDevice::write_pipeline_cache_file() -> bool
+    {
+        if (this->info.pipeline_cache_path.empty())
+        {
+            return false;
+        }
+        DAXA_ONLY_IF_THREADSAFETY(std::unique_lock const lock{this->pipeline_cache_file_mtx});
+        // The device cache is merged into a cache created from the current file content, as merging into the device cache would need to lock out all pipeline creations.
+        std::vector<std::byte> const file_data = this->read_pipeline_cache_file();
+        VkPipelineCacheCreateInfo const vk_pipeline_cache_create_info{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = {},
+            .initialDataSize = file_data.size(),
+            .pInitialData = file_data.data(),
+        };
+        VkPipelineCache vk_merged_pipeline_cache = {};
+        if (vkCreatePipelineCache(this->vk_device, &vk_pipeline_cache_create_info, nullptr, &vk_merged_pipeline_cache) != VK_SUCCESS)
+        {
+            return false;
+        }
+        vkMergePipelineCaches(this->vk_device, vk_merged_pipeline_cache, 1, &this->vk_pipeline_cache);
+        usize data_size = {};
+        vkGetPipelineCacheData(this->vk_device, vk_merged_pipeline_cache, &data_size, nullptr);
+        std::vector<std::byte> data(data_size);
+        VkResult const result = vkGetPipelineCacheData(this->vk_device, vk_merged_pipeline_cache, &data_size, data.data());
+        vkDestroyPipelineCache(this->vk_device, vk_merged_pipeline_cache, nullptr);
+        if (result != VK_SUCCESS)
+        {
+            return false;
+        }
+        // Written to a temporary file first and then renamed, so that a crash or a concurrent reader never sees a partially written cache.
+        // The temporary name is random, as other devices or processes may write the same cache file at once.
+        std::random_device random_device = {};
+        u64 const temporary_id = (static_cast<u64>(random_device()) << 32) | static_cast<u64>(random_device());
+        std::filesystem::path temporary_path = this->info.pipeline_cache_path;
+        temporary_path += fmt::format(".{:016x}.tmp", temporary_id);
+        std::error_code error = {};
+        {
+            std::ofstream ofs{temporary_path, std::ios_base::trunc | std::ios_base::binary};
+            if (!ofs.good())
+            {
+                return false;
+            }
+            ofs.write(reinterpret_cast<char const *>(data.data()), static_cast<std::streamsize>(data_size));
+            if (!ofs.good())
+            {
+                ofs.close();
+                std::filesystem::remove(temporary_path, error);
+                return false;
+            }
+        }
+        std::filesystem::rename(temporary_path, this->info.pipeline_cache_path, error);
+        if (error)
+        {
+            std::filesystem::remove(temporary_path, error);
+            return false;
+        }
+        return true;
+    }
+
     void ImplDevice::zombify_buffer(BufferId id)
     {
         DAXA_ONLY_IF_THREADSAFETY(std::unique_lock const lock{this->main_queue_zombies_mtx});
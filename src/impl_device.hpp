@@ -4,6 +4,9 @@
 #include <daxa/device.hpp>
 
 #include "impl_core.hpp"
+
+#include <condition_variable>
+#include <thread>
 #include "impl_instance.hpp"
 
 #include "impl_pipeline.hpp"
@@ -17,6 +20,16 @@
 
 namespace daxa
 {
+    struct ImplResourceMemoryCounter
+    {
+        DAXA_ATOMIC_U64 count = {};
+        DAXA_ATOMIC_U64 bytes = {};
+
+        void add(u64 size);
+        void remove(u64 size);
+        auto statistics() const -> ResourceMemoryStatistics;
+    };
+
     struct ImplDevice final : ManagedSharedState
     {
         ManagedWeakPtr impl_ctx = {};
@@ -34,6 +47,32 @@ namespace daxa
         PFN_vkCmdDrawMeshTasksIndirectCountEXT vkCmdDrawMeshTasksIndirectCountEXT = {};
         MeshShaderDeviceProperties mesh_shader_properties = {};
 
+        // Optional query features, enabled when the device supports them:
+        bool precise_occlusion_queries_enabled = {};
+        bool pipeline_statistics_queries_enabled = {};
+        bool sparse_resources_supported = {};
+
+        // Shader object and extended dynamic state 3:
+        bool shader_object_enabled = {};
+        bool extended_dynamic_state_3_enabled = {};
+        bool graphics_pipeline_library_enabled = {};
+        PFN_vkCreateShadersEXT vkCreateShadersEXT = {};
+        PFN_vkDestroyShaderEXT vkDestroyShaderEXT = {};
+        PFN_vkCmdBindShadersEXT vkCmdBindShadersEXT = {};
+        PFN_vkCmdSetPolygonModeEXT vkCmdSetPolygonModeEXT = {};
+        PFN_vkCmdSetRasterizationSamplesEXT vkCmdSetRasterizationSamplesEXT = {};
+        PFN_vkCmdSetSampleMaskEXT vkCmdSetSampleMaskEXT = {};
+        PFN_vkCmdSetAlphaToCoverageEnableEXT vkCmdSetAlphaToCoverageEnableEXT = {};
+        PFN_vkCmdSetColorBlendEnableEXT vkCmdSetColorBlendEnableEXT = {};
+        PFN_vkCmdSetColorBlendEquationEXT vkCmdSetColorBlendEquationEXT = {};
+        PFN_vkCmdSetColorWriteMaskEXT vkCmdSetColorWriteMaskEXT = {};
+        PFN_vkCmdSetDepthClampEnableEXT vkCmdSetDepthClampEnableEXT = {};
+        PFN_vkCmdSetVertexInputEXT vkCmdSetVertexInputEXT = {};
+        PFN_vkCmdSetPatchControlPointsEXT vkCmdSetPatchControlPointsEXT = {};
+        PFN_vkCmdSetTessellationDomainOriginEXT vkCmdSetTessellationDomainOriginEXT = {};
+        PFN_vkCmdSetConservativeRasterizationModeEXT vkCmdSetConservativeRasterizationModeEXT = {};
+        PFN_vkCmdSetExtraPrimitiveOverestimationSizeEXT vkCmdSetExtraPrimitiveOverestimationSizeEXT = {};
+
         VmaAllocator vma_allocator = {};
         DeviceProperties vk_info = {};
         DeviceInfo info = {};
@@ -41,6 +80,55 @@ namespace daxa
         u64 * buffer_device_address_buffer_host_ptr = {};
         VmaAllocation buffer_device_address_buffer_allocation = {};
 
+        // Memory statistics:
+        // Only resources owning their allocation are counted here, resources placed in memory blocks are part of the memory block counter.
+        ImplResourceMemoryCounter buffer_memory_counter = {};
+        ImplResourceMemoryCounter host_accessible_buffer_memory_counter = {};
+        ImplResourceMemoryCounter image_memory_counter = {};
+        ImplResourceMemoryCounter memory_block_memory_counter = {};
+
+        // Defragmentation:
+        // Guarded by the main queue zombie mutex. The old buffers of a pass are destroyed once the gpu reached the pass timeline value.
+        VmaDefragmentationContext vma_defragmentation_context = {};
+        VmaDefragmentationPassMoveInfo vma_defragmentation_pass = {};
+        std::vector<VkBuffer> defragmentation_old_buffers = {};
+        u64 defragmentation_pass_timeline_value = {};
+        bool defragmentation_pass_pending = {};
+        void end_defragmentation_pass();
+
+        // Pipeline cache:
+        // Used by all pipeline creations. Vulkan synchronizes pipeline cache access internally.
+        VkPipelineCache vk_pipeline_cache = {};
+        DAXA_ONLY_IF_THREADSAFETY(std::mutex pipeline_cache_file_mtx = {});
+        auto read_pipeline_cache_file() const -> std::vector<std::byte>;
+        auto write_pipeline_cache_file() -> bool;
+
+        // Graphics pipeline library parts, keyed by all their inputs.
+        // Every pipeline linked from a part, and every optimized link still running on it, holds a reference.
+        // The part is zombified when the last reference is released.
+        struct PipelineLibrary
+        {
+            VkPipeline vk_pipeline = {};
+            u32 ref_count = {};
+        };
+        DAXA_ONLY_IF_THREADSAFETY(std::mutex pipeline_libraries_mtx = {});
+        std::unordered_map<std::string, PipelineLibrary> pipeline_libraries = {};
+        void release_pipeline_libraries(std::span<std::string const> keys);
+
+        // Async pipeline creation:
+        // The worker threads are started on the first async creation that does not use a user executor.
+#if DAXA_THREADSAFETY
+        std::mutex pipeline_compile_mtx = {};
+        std::condition_variable pipeline_compile_cv = {};
+        std::deque<std::function<void()>> pipeline_compile_tasks = {};
+        std::vector<std::thread> pipeline_compile_threads = {};
+        bool pipeline_compile_stop = {};
+        // Jobs handed to the user executor that did not finish yet. The device waits for them before it is destroyed.
+        u64 pipeline_compile_executor_jobs = {};
+#endif
+        void enqueue_pipeline_compile(std::function<void()> && task);
+        void stop_pipeline_compile_threads();
+
         // 'Null' resources, used to fill empty slots in the resource table after a resource is destroyed.
         // This is not necessary, as it is valid to have "garbage" in the descriptor slots given our enabled features.
         // BUT, accessing garbage descriptors normally causes a device lost immediately, making debugging much harder.
@@ -64,6 +152,10 @@ namespace daxa
         u32 main_queue_family_index = {};
 
         DAXA_ATOMIC_U64 main_queue_cpu_timeline = {};
+        // Command lists that were created but not submitted yet.
+        DAXA_ATOMIC_U64 open_command_list_count = {};
+        // Submissions are not ordered with sparse binds by the queue, so each submit waits for the latest bind.
+        DAXA_ATOMIC_U64 main_queue_sparse_bind_timeline_value = {};
         VkSemaphore vk_main_queue_gpu_timeline_semaphore = {};
 
         DAXA_ONLY_IF_THREADSAFETY(std::mutex main_queue_zombies_mtx = {});
@@ -77,6 +169,7 @@ namespace daxa
         std::deque<std::pair<u64, SplitBarrierZombie>> main_queue_split_barrier_zombies = {};
         std::deque<std::pair<u64, PipelineZombie>> main_queue_pipeline_zombies = {};
         std::deque<std::pair<u64, TimelineQueryPoolZombie>> main_queue_timeline_query_pool_zombies = {};
+        std::deque<std::pair<u64, MemoryBlockZombie>> main_queue_memory_block_zombies = {};
         void main_queue_collect_garbage();
         void wait_idle() const;
 
@@ -87,6 +180,8 @@ namespace daxa
         auto validate_image_slice(ImageMipArraySlice const & slice, ImageViewId id) -> ImageMipArraySlice;
 
         auto new_buffer(BufferInfo const & buffer_info) -> BufferId;
+        // Storage buffer descriptors can not cover more than maxStorageBufferRange, larger buffers are only fully reachable through their device address.
+        auto buffer_descriptor_range(usize size) const -> VkDeviceSize;
         auto new_swapchain_image(VkImage swapchain_image, VkFormat format, u32 index, ImageUsageFlags usage, ImageInfo const & info) -> ImageId;
         auto new_image(ImageInfo const & image_info) -> ImageId;
         auto new_image_view(ImageViewInfo const & image_view_info) -> ImageViewId;
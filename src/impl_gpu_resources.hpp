@@ -19,6 +19,9 @@ namespace daxa
         VmaAllocation vma_allocation = {};
         VkDeviceAddress device_address = {};
         void * host_address = {};
+        // Sparse buffers only:
+        VkMemoryRequirements sparse_memory_requirements = {};
+        std::vector<VmaAllocation> sparse_pages = {};
         bool zombie = {};
     };
 
@@ -38,6 +41,10 @@ namespace daxa
         VmaAllocation vma_allocation = {};
         i32 swapchain_image_index = NOT_OWNED_BY_SWAPCHAIN;
         VkImageAspectFlags aspect_flags = {}; // Inferred from format.
+        // Sparse images only:
+        VkMemoryRequirements sparse_memory_requirements = {};
+        VkSparseImageMemoryRequirements sparse_image_requirements = {};
+        std::unordered_map<u64, VmaAllocation> sparse_tiles = {};
         bool zombie = {};
     };
 
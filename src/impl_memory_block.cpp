@@ -16,11 +16,13 @@ namespace daxa
         , allocation{ a_alloc }
         , alloc_info{ a_alloc_info }
     {
+        this->impl_device.as<ImplDevice>()->memory_block_memory_counter.add(this->alloc_info.size);
     }
 
     ImplMemoryBlock::~ImplMemoryBlock()
     {
         auto * device = this->impl_device.as<ImplDevice>();
+        device->memory_block_memory_counter.remove(this->alloc_info.size);
         vmaFreeMemory(device->vma_allocator, this->allocation);
     }
 } // namespace daxa
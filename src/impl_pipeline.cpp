@@ -20,11 +20,153 @@ namespace daxa
         return impl.info;
     }
 
+    // Owns the arrays a VkSpecializationInfo points to.
+    struct SpecializationData
+    {
+        std::vector<VkSpecializationMapEntry> map_entries = {};
+        std::vector<u32> data = {};
+        VkSpecializationInfo vk_specialization_info = {};
+    };
+
+    static auto specialization_constant_bits(ShaderSpecializationConstant const & constant) -> u32
+    {
+        return std::visit(
+            [](auto value) -> u32
+            {
+                if constexpr (std::is_same_v<decltype(value), bool>)
+                {
+                    return value ? VK_TRUE : VK_FALSE;
+                }
+                else
+                {
+                    return std::bit_cast<u32>(value);
+                }
+            },
+            constant.value);
+    }
+
+    // Returns nullptr when the shader has no specialization constants.
+    static auto fill_specialization_info(ShaderInfo const & shader_info, SpecializationData & out) -> VkSpecializationInfo const *
+    {
+        if (shader_info.specialization_constants.empty())
+        {
+            return nullptr;
+        }
+        for (auto const & constant : shader_info.specialization_constants)
+        {
+            out.map_entries.push_back(VkSpecializationMapEntry{
+                .constantID = constant.constant_id,
+                .offset = static_cast<u32>(out.data.size() * sizeof(u32)),
+                .size = sizeof(u32),
+            });
+            out.data.push_back(specialization_constant_bits(constant));
+        }
+        out.vk_specialization_info = VkSpecializationInfo{
+            .mapEntryCount = static_cast<u32>(out.map_entries.size()),
+            .pMapEntries = out.map_entries.data(),
+            .dataSize = out.data.size() * sizeof(u32),
+            .pData = out.data.data(),
+        };
+        return &out.vk_specialization_info;
+    }
+
+    // Pipeline library keys contain every input of the library part, so that parts with equal keys can be shared.
+    // Only scalar values are appended, so that struct padding never ends up in a key.
+    template <typename T>
+        requires std::is_scalar_v<T>
+    static void append_library_key(std::string & key, T value)
+    {
+        key.append(reinterpret_cast<char const *>(&value), sizeof(T));
+    }
+
+    static void append_library_key(std::string & key, std::optional<ShaderInfo> const & shader_info)
+    {
+        append_library_key(key, shader_info.has_value());
+        if (!shader_info.has_value())
+        {
+            return;
+        }
+        append_library_key(key, shader_info->byte_code.size());
+        key.append(reinterpret_cast<char const *>(shader_info->byte_code.data()), shader_info->byte_code.size_bytes());
+        std::string const entry_point = shader_info->entry_point.value_or("main");
+        append_library_key(key, entry_point.size());
+        key.append(entry_point);
+        append_library_key(key, shader_info->specialization_constants.size());
+        for (auto const & constant : shader_info->specialization_constants)
+        {
+            append_library_key(key, constant.constant_id);
+            append_library_key(key, specialization_constant_bits(constant));
+        }
+    }
+
+    static auto link_pipeline_libraries(ImplDevice & device, std::span<VkPipeline const> libraries, VkPipelineLayout vk_pipeline_layout, VkPipelineCreateFlags flags) -> VkPipeline
+    {
+        VkPipelineLibraryCreateInfoKHR const vk_library_create_info{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR,
+            .pNext = nullptr,
+            .libraryCount = static_cast<u32>(libraries.size()),
+            .pLibraries = libraries.data(),
+        };
+        VkGraphicsPipelineCreateInfo const vk_graphics_pipeline_create_info{
+            .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+            .pNext = &vk_library_create_info,
+            .flags = flags,
+            .layout = vk_pipeline_layout,
+        };
+        VkPipeline vk_pipeline = {};
+        [[maybe_unused]] auto const result = vkCreateGraphicsPipelines(device.vk_device, device.vk_pipeline_cache, 1u, &vk_graphics_pipeline_create_info, nullptr, &vk_pipeline);
+        DAXA_DBG_ASSERT_TRUE_M(result == VK_SUCCESS, "failed to link graphics pipeline libraries");
+        return vk_pipeline;
+    }
+
+    // The library is created without holding the lock, so that concurrent pipeline creations do not serialize on the cache.
+    // When two threads create the same part, the second one to finish discards its library.
+    // Adds a reference to the part, released with ImplDevice::release_pipeline_libraries.
+    static auto get_or_create_pipeline_library(ImplDevice & device, VkGraphicsPipelineLibraryFlagsEXT part, std::string & key, VkGraphicsPipelineCreateInfo create_info) -> VkPipeline
+    {
+        append_library_key(key, part);
+        {
+            DAXA_ONLY_IF_THREADSAFETY(std::unique_lock const lock{device.pipeline_libraries_mtx});
+            auto const iter = device.pipeline_libraries.find(key);
+            if (iter != device.pipeline_libraries.end())
+            {
+                iter->second.ref_count += 1;
+                return iter->second.vk_pipeline;
+            }
+        }
+        VkGraphicsPipelineLibraryCreateInfoEXT const vk_library_create_info{
+            .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT,
+            .pNext = create_info.pNext,
+            .flags = part,
+        };
+        create_info.pNext = &vk_library_create_info;
+        // Link time optimization info is retained, so that optimized pipelines can be linked from the same libraries.
+        create_info.flags |= VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+        VkPipeline vk_library = {};
+        [[maybe_unused]] auto const result = vkCreateGraphicsPipelines(device.vk_device, device.vk_pipeline_cache, 1u, &create_info, nullptr, &vk_library);
+        DAXA_DBG_ASSERT_TRUE_M(result == VK_SUCCESS, "failed to create graphics pipeline library");
+        DAXA_ONLY_IF_THREADSAFETY(std::unique_lock const lock{device.pipeline_libraries_mtx});
+        auto const [iter, inserted] = device.pipeline_libraries.emplace(key, ImplDevice::PipelineLibrary{.vk_pipeline = vk_library});
+        if (!inserted)
+        {
+            vkDestroyPipeline(device.vk_device, vk_library, nullptr);
+        }
+        iter->second.ref_count += 1;
+        return iter->second.vk_pipeline;
+    }
+
     ImplRasterPipeline::ImplRasterPipeline(ManagedWeakPtr a_impl_device, RasterPipelineInfo a_info)
         : ImplPipeline(std::move(a_impl_device)), info{std::move(a_info)}
     {
+        if (this->impl_device.as<ImplDevice>()->shader_object_enabled)
+        {
+            create_shader_objects();
+            return;
+        }
         std::vector<VkShaderModule> vk_shader_modules{};
         std::vector<VkPipelineShaderStageCreateInfo> vk_pipeline_shader_stage_create_infos{};
+        // Deque, so that the pointers to already filled specialization infos stay valid.
+        std::deque<SpecializationData> specialization_datas{};
 
         auto create_shader_module = [&](ShaderInfo const & shader_info, VkShaderStageFlagBits shader_stage)
         {
@@ -45,7 +187,7 @@ namespace daxa
                 .stage = shader_stage,
                 .module = vk_shader_module,
                 .pName = shader_info.entry_point.has_value() ? shader_info.entry_point.value().c_str() : "main",
-                .pSpecializationInfo = nullptr,
+                .pSpecializationInfo = fill_specialization_info(shader_info, specialization_datas.emplace_back()),
             };
             vk_pipeline_shader_stage_create_infos.push_back(vk_pipeline_shader_stage_create_info);
         };
@@ -200,11 +342,60 @@ namespace daxa
             .scissorCount = 1,
             .pScissors = &DEFAULT_SCISSOR,
         };
-        auto dynamic_state = std::array{
+        auto dynamic_state = std::vector{
             VkDynamicState::VK_DYNAMIC_STATE_VIEWPORT,
             VkDynamicState::VK_DYNAMIC_STATE_SCISSOR,
             VkDynamicState::VK_DYNAMIC_STATE_DEPTH_BIAS,
         };
+        auto const has_dynamic_state = [&](RasterDynamicStateFlags flag)
+        {
+            return (this->info.dynamic_state & flag) != RasterDynamicStateFlagBits::NONE;
+        };
+        if (has_dynamic_state(RasterDynamicStateFlagBits::DEPTH_TEST))
+        {
+            dynamic_state.push_back(VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE);
+            dynamic_state.push_back(VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE);
+            dynamic_state.push_back(VK_DYNAMIC_STATE_DEPTH_COMPARE_OP);
+        }
+        if (has_dynamic_state(RasterDynamicStateFlagBits::CULL_MODE))
+        {
+            dynamic_state.push_back(VK_DYNAMIC_STATE_CULL_MODE);
+        }
+        if (has_dynamic_state(RasterDynamicStateFlagBits::FRONT_FACE))
+        {
+            dynamic_state.push_back(VK_DYNAMIC_STATE_FRONT_FACE);
+        }
+        if (has_dynamic_state(RasterDynamicStateFlagBits::PRIMITIVE_TOPOLOGY))
+        {
+            dynamic_state.push_back(VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY);
+        }
+        if (has_dynamic_state(RasterDynamicStateFlagBits::PRIMITIVE_RESTART_ENABLE))
+        {
+            dynamic_state.push_back(VK_DYNAMIC_STATE_PRIMITIVE_RESTART_ENABLE);
+        }
+        if (has_dynamic_state(RasterDynamicStateFlagBits::DEPTH_BIAS_ENABLE))
+        {
+            dynamic_state.push_back(VK_DYNAMIC_STATE_DEPTH_BIAS_ENABLE);
+        }
+        [[maybe_unused]] auto const extended_dynamic_state_3_flags =
+            RasterDynamicStateFlagBits::POLYGON_MODE | RasterDynamicStateFlagBits::COLOR_BLEND | RasterDynamicStateFlagBits::DEPTH_CLAMP_ENABLE;
+        DAXA_DBG_ASSERT_TRUE_M(
+            !has_dynamic_state(extended_dynamic_state_3_flags) || this->impl_device.as<ImplDevice>()->extended_dynamic_state_3_enabled,
+            "polygon mode, color blend and depth clamp dynamic state require extended dynamic state 3 to be enabled on the device");
+        if (has_dynamic_state(RasterDynamicStateFlagBits::POLYGON_MODE))
+        {
+            dynamic_state.push_back(VK_DYNAMIC_STATE_POLYGON_MODE_EXT);
+        }
+        if (has_dynamic_state(RasterDynamicStateFlagBits::COLOR_BLEND))
+        {
+            dynamic_state.push_back(VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT);
+            dynamic_state.push_back(VK_DYNAMIC_STATE_COLOR_BLEND_EQUATION_EXT);
+            dynamic_state.push_back(VK_DYNAMIC_STATE_COLOR_WRITE_MASK_EXT);
+        }
+        if (has_dynamic_state(RasterDynamicStateFlagBits::DEPTH_CLAMP_ENABLE))
+        {
+            dynamic_state.push_back(VK_DYNAMIC_STATE_DEPTH_CLAMP_ENABLE_EXT);
+        }
         VkPipelineDynamicStateCreateInfo const vk_dynamic_state{
             .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
             .pNext = nullptr,
@@ -242,14 +433,21 @@ namespace daxa
             .basePipelineHandle = VK_NULL_HANDLE,
             .basePipelineIndex = 0,
         };
-        [[maybe_unused]] auto pipeline_result = vkCreateGraphicsPipelines(
-            this->impl_device.as<ImplDevice>()->vk_device,
-            VK_NULL_HANDLE,
-            1u,
-            &vk_graphics_pipeline_create_info,
-            nullptr,
-            &this->vk_pipeline);
-        DAXA_DBG_ASSERT_TRUE_M(pipeline_result == VK_SUCCESS, "failed to create graphics pipeline");
+        if (this->impl_device.as<ImplDevice>()->graphics_pipeline_library_enabled)
+        {
+            link_from_pipeline_libraries(vk_graphics_pipeline_create_info);
+        }
+        else
+        {
+            [[maybe_unused]] auto pipeline_result = vkCreateGraphicsPipelines(
+                this->impl_device.as<ImplDevice>()->vk_device,
+                this->impl_device.as<ImplDevice>()->vk_pipeline_cache,
+                1u,
+                &vk_graphics_pipeline_create_info,
+                nullptr,
+                &this->vk_pipeline);
+            DAXA_DBG_ASSERT_TRUE_M(pipeline_result == VK_SUCCESS, "failed to create graphics pipeline");
+        }
 
         for (auto & vk_shader_module : vk_shader_modules)
         {
@@ -269,6 +467,302 @@ namespace daxa
         }
     }
 
+    void ImplRasterPipeline::link_from_pipeline_libraries(VkGraphicsPipelineCreateInfo const & full_create_info)
+    {
+        auto & device = *this->impl_device.as<ImplDevice>();
+        std::vector<VkPipelineShaderStageCreateInfo> pre_raster_stages = {};
+        std::vector<VkPipelineShaderStageCreateInfo> fragment_stages = {};
+        for (u32 i = 0; i < full_create_info.stageCount; ++i)
+        {
+            auto const & stage = full_create_info.pStages[i];
+            (stage.stage == VK_SHADER_STAGE_FRAGMENT_BIT ? fragment_stages : pre_raster_stages).push_back(stage);
+        }
+
+        std::string shared_key = {};
+        append_library_key(shared_key, this->info.dynamic_state.data);
+        append_library_key(shared_key, this->info.push_constant_size);
+        std::array<VkPipeline, 4> libraries = {};
+        u32 library_count = 0;
+        this->library_keys.reserve(libraries.size());
+
+        // Mesh pipelines have no vertex input.
+        if (!this->info.mesh_shader_info.has_value())
+        {
+            std::string key = shared_key;
+            append_library_key(key, this->info.raster.primitive_topology);
+            append_library_key(key, this->info.raster.primitive_restart_enable);
+            libraries.at(library_count++) = get_or_create_pipeline_library(
+                device, VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT, key,
+                VkGraphicsPipelineCreateInfo{
+                    .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+                    .pNext = full_create_info.pNext,
+                    .pVertexInputState = full_create_info.pVertexInputState,
+                    .pInputAssemblyState = full_create_info.pInputAssemblyState,
+                    .pDynamicState = full_create_info.pDynamicState,
+                });
+            this->library_keys.push_back(std::move(key));
+        }
+        {
+            std::string key = shared_key;
+            append_library_key(key, this->info.vertex_shader_info);
+            append_library_key(key, this->info.tesselation_control_shader_info);
+            append_library_key(key, this->info.tesselation_evaluation_shader_info);
+            append_library_key(key, this->info.task_shader_info);
+            append_library_key(key, this->info.mesh_shader_info);
+            append_library_key(key, this->info.fragment_shader_info.has_value());
+            auto const & raster = this->info.raster;
+            append_library_key(key, raster.polygon_mode);
+            append_library_key(key, raster.face_culling.data);
+            append_library_key(key, raster.front_face_winding);
+            append_library_key(key, raster.depth_clamp_enable);
+            append_library_key(key, raster.depth_bias_enable);
+            append_library_key(key, raster.depth_bias_constant_factor);
+            append_library_key(key, raster.depth_bias_clamp);
+            append_library_key(key, raster.depth_bias_slope_factor);
+            append_library_key(key, raster.line_width);
+            append_library_key(key, raster.conservative_raster_info.has_value());
+            append_library_key(key, raster.conservative_raster_info.value_or(ConservativeRasterInfo{}).mode);
+            append_library_key(key, raster.conservative_raster_info.value_or(ConservativeRasterInfo{}).size);
+            append_library_key(key, this->info.tesselation.control_points);
+            append_library_key(key, this->info.tesselation.origin);
+            libraries.at(library_count++) = get_or_create_pipeline_library(
+                device, VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT, key,
+                VkGraphicsPipelineCreateInfo{
+                    .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+                    .pNext = full_create_info.pNext,
+                    .stageCount = static_cast<u32>(pre_raster_stages.size()),
+                    .pStages = pre_raster_stages.data(),
+                    .pTessellationState = full_create_info.pTessellationState,
+                    .pViewportState = full_create_info.pViewportState,
+                    .pRasterizationState = full_create_info.pRasterizationState,
+                    .pDynamicState = full_create_info.pDynamicState,
+                    .layout = full_create_info.layout,
+                });
+            this->library_keys.push_back(std::move(key));
+        }
+        std::string attachment_key = shared_key;
+        append_library_key(attachment_key, this->info.depth_test.depth_attachment_format);
+        for (auto const & attachment : this->info.color_attachments)
+        {
+            append_library_key(attachment_key, attachment.format);
+        }
+        {
+            std::string key = attachment_key;
+            append_library_key(key, this->info.fragment_shader_info);
+            auto const & depth_test = this->info.depth_test;
+            append_library_key(key, depth_test.enable_depth_test);
+            append_library_key(key, depth_test.enable_depth_write);
+            append_library_key(key, depth_test.depth_test_compare_op);
+            append_library_key(key, depth_test.min_depth_bounds);
+            append_library_key(key, depth_test.max_depth_bounds);
+            libraries.at(library_count++) = get_or_create_pipeline_library(
+                device, VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT, key,
+                VkGraphicsPipelineCreateInfo{
+                    .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+                    .pNext = full_create_info.pNext,
+                    .stageCount = static_cast<u32>(fragment_stages.size()),
+                    .pStages = fragment_stages.data(),
+                    .pMultisampleState = full_create_info.pMultisampleState,
+                    .pDepthStencilState = full_create_info.pDepthStencilState,
+                    .pDynamicState = full_create_info.pDynamicState,
+                    .layout = full_create_info.layout,
+                });
+            this->library_keys.push_back(std::move(key));
+        }
+        {
+            std::string key = attachment_key;
+            for (auto const & attachment : this->info.color_attachments)
+            {
+                auto const & blend = attachment.blend;
+                append_library_key(key, blend.blend_enable);
+                append_library_key(key, blend.src_color_blend_factor);
+                append_library_key(key, blend.dst_color_blend_factor);
+                append_library_key(key, blend.color_blend_op);
+                append_library_key(key, blend.src_alpha_blend_factor);
+                append_library_key(key, blend.dst_alpha_blend_factor);
+                append_library_key(key, blend.alpha_blend_op);
+                append_library_key(key, blend.color_write_mask.data);
+            }
+            libraries.at(library_count++) = get_or_create_pipeline_library(
+                device, VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT, key,
+                VkGraphicsPipelineCreateInfo{
+                    .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+                    .pNext = full_create_info.pNext,
+                    .pMultisampleState = full_create_info.pMultisampleState,
+                    .pColorBlendState = full_create_info.pColorBlendState,
+                    .pDynamicState = full_create_info.pDynamicState,
+                });
+            this->library_keys.push_back(std::move(key));
+        }
+
+        // Fast link without optimization, usable right away.
+        this->vk_pipeline = link_pipeline_libraries(device, std::span{libraries.data(), library_count}, this->vk_pipeline_layout, 0);
+
+        // The optimized link replaces the fast linked pipeline once it is done.
+        // It holds its own references to the libraries, as the pipeline may be destroyed before the link finishes.
+        {
+            DAXA_ONLY_IF_THREADSAFETY(std::unique_lock const lock{device.pipeline_libraries_mtx});
+            for (auto const & key : this->library_keys)
+            {
+                device.pipeline_libraries.at(key).ref_count += 1;
+            }
+        }
+        auto link = std::make_shared<ImplOptimizedPipelineLink>();
+        this->optimized_link = link;
+        // The device waits for all pipeline compile jobs before it is destroyed, so the job can not outlive it.
+        ImplDevice * device_ptr = &device;
+        device.enqueue_pipeline_compile(
+            [device_ptr, link, libraries, library_count, library_keys = this->library_keys, vk_pipeline_layout = this->vk_pipeline_layout]()
+            {
+                DAXA_TRACE_SCOPE("link optimized raster pipeline");
+                VkPipeline const vk_optimized_pipeline = link_pipeline_libraries(
+                    *device_ptr, std::span{libraries.data(), library_count}, vk_pipeline_layout, VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT);
+                {
+                    DAXA_ONLY_IF_THREADSAFETY(std::unique_lock const lock{link->mtx});
+                    if (link->abandoned)
+                    {
+                        // The pipeline was destroyed before the link finished, the optimized pipeline was never bound.
+                        vkDestroyPipeline(device_ptr->vk_device, vk_optimized_pipeline, nullptr);
+                    }
+                    else
+                    {
+                        link->vk_pipeline.store(vk_optimized_pipeline, std::memory_order_release);
+                    }
+                }
+                device_ptr->release_pipeline_libraries(library_keys);
+            });
+    }
+
+    auto ImplRasterPipeline::current_vk_pipeline() const -> VkPipeline
+    {
+        if (this->optimized_link != nullptr)
+        {
+            VkPipeline const vk_optimized_pipeline = this->optimized_link->vk_pipeline.load(std::memory_order_acquire);
+            if (vk_optimized_pipeline != VK_NULL_HANDLE)
+            {
+                return vk_optimized_pipeline;
+            }
+        }
+        return this->vk_pipeline;
+    }
+
+    ImplRasterPipeline::~ImplRasterPipeline() // NOLINT(bugprone-exception-escape)
+    {
+        if (this->optimized_link == nullptr)
+        {
+            return;
+        }
+        this->impl_device.as<ImplDevice>()->release_pipeline_libraries(this->library_keys);
+        VkPipeline vk_optimized_pipeline = {};
+        {
+            DAXA_ONLY_IF_THREADSAFETY(std::unique_lock const lock{this->optimized_link->mtx});
+            this->optimized_link->abandoned = true;
+            vk_optimized_pipeline = this->optimized_link->vk_pipeline.load(std::memory_order_relaxed);
+        }
+        if (vk_optimized_pipeline != VK_NULL_HANDLE)
+        {
+            auto * device = this->impl_device.as<ImplDevice>();
+            DAXA_ONLY_IF_THREADSAFETY(std::unique_lock const lock{device->main_queue_zombies_mtx});
+            u64 const main_queue_cpu_timeline_value = DAXA_ATOMIC_FETCH(device->main_queue_cpu_timeline);
+            device->main_queue_pipeline_zombies.push_front({
+                main_queue_cpu_timeline_value,
+                PipelineZombie{
+                    .vk_pipeline = vk_optimized_pipeline,
+                },
+            });
+        }
+    }
+
+    void ImplRasterPipeline::create_shader_objects()
+    {
+        auto & device = *this->impl_device.as<ImplDevice>();
+        this->uses_shader_objects = true;
+        u32 const push_constant_word_count = (this->info.push_constant_size + 3) / 4;
+        this->vk_pipeline_layout = device.gpu_shader_resource_table.pipeline_layouts.at(push_constant_word_count);
+        // Must match the pipeline layouts used to bind descriptor sets and push constants.
+        std::array<VkDescriptorSetLayout, 2> const vk_descriptor_set_layouts = {
+            device.gpu_shader_resource_table.vk_descriptor_set_layout,
+            device.gpu_shader_resource_table.uniform_buffer_descriptor_set_layout,
+        };
+        VkPushConstantRange const vk_push_constant_range{
+            .stageFlags = VK_SHADER_STAGE_ALL,
+            .offset = 0,
+            .size = push_constant_word_count * 4,
+        };
+        std::array<std::optional<ShaderInfo> const *, RASTER_SHADER_OBJECT_STAGE_COUNT> const shader_infos = {
+            &this->info.vertex_shader_info,
+            &this->info.tesselation_control_shader_info,
+            &this->info.tesselation_evaluation_shader_info,
+            &this->info.fragment_shader_info,
+            &this->info.task_shader_info,
+            &this->info.mesh_shader_info,
+        };
+        std::array<VkShaderStageFlags, RASTER_SHADER_OBJECT_STAGE_COUNT> const next_stages = {
+            VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+            VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT,
+            VK_SHADER_STAGE_FRAGMENT_BIT,
+            0,
+            VK_SHADER_STAGE_MESH_BIT_EXT,
+            VK_SHADER_STAGE_FRAGMENT_BIT,
+        };
+        std::array<SpecializationData, RASTER_SHADER_OBJECT_STAGE_COUNT> specialization_datas = {};
+        std::array<VkShaderCreateInfoEXT, RASTER_SHADER_OBJECT_STAGE_COUNT> vk_shader_create_infos = {};
+        std::array<usize, RASTER_SHADER_OBJECT_STAGE_COUNT> stage_indices = {};
+        u32 shader_count = 0;
+        for (usize stage_index = 0; stage_index < RASTER_SHADER_OBJECT_STAGE_COUNT; ++stage_index)
+        {
+            if (!shader_infos[stage_index]->has_value())
+            {
+                continue;
+            }
+            auto const & shader_info = shader_infos[stage_index]->value();
+            VkShaderStageFlagBits const stage = RASTER_SHADER_OBJECT_STAGES[stage_index];
+            // Shaders are not linked, each stage is compiled on its own and combined at bind time.
+            VkShaderCreateFlagsEXT flags = {};
+            if (stage == VK_SHADER_STAGE_MESH_BIT_EXT && !this->info.task_shader_info.has_value())
+            {
+                flags |= VK_SHADER_CREATE_NO_TASK_SHADER_BIT_EXT;
+            }
+            vk_shader_create_infos[shader_count] = VkShaderCreateInfoEXT{
+                .sType = VK_STRUCTURE_TYPE_SHADER_CREATE_INFO_EXT,
+                .pNext = nullptr,
+                .flags = flags,
+                .stage = stage,
+                .nextStage = next_stages[stage_index],
+                .codeType = VK_SHADER_CODE_TYPE_SPIRV_EXT,
+                .codeSize = shader_info.byte_code.size() * sizeof(u32),
+                .pCode = shader_info.byte_code.data(),
+                .pName = shader_info.entry_point.has_value() ? shader_info.entry_point.value().c_str() : "main",
+                .setLayoutCount = static_cast<u32>(vk_descriptor_set_layouts.size()),
+                .pSetLayouts = vk_descriptor_set_layouts.data(),
+                .pushConstantRangeCount = push_constant_word_count != 0 ? 1u : 0u,
+                .pPushConstantRanges = push_constant_word_count != 0 ? &vk_push_constant_range : nullptr,
+                .pSpecializationInfo = fill_specialization_info(shader_info, specialization_datas[stage_index]),
+            };
+            stage_indices[shader_count] = stage_index;
+            ++shader_count;
+        }
+        std::array<VkShaderEXT, RASTER_SHADER_OBJECT_STAGE_COUNT> created_shaders = {};
+        [[maybe_unused]] auto const result = device.vkCreateShadersEXT(device.vk_device, shader_count, vk_shader_create_infos.data(), nullptr, created_shaders.data());
+        DAXA_DBG_ASSERT_TRUE_M(result == VK_SUCCESS, "failed to create raster pipeline shader objects");
+        for (u32 i = 0; i < shader_count; ++i)
+        {
+            this->vk_shaders[stage_indices[i]] = created_shaders[i];
+            if (device.impl_ctx.as<ImplInstance>()->info.enable_debug_utils && !this->info.name.empty())
+            {
+                auto shader_name = this->info.name;
+                VkDebugUtilsObjectNameInfoEXT const name_info{
+                    .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT,
+                    .pNext = nullptr,
+                    .objectType = VK_OBJECT_TYPE_SHADER_EXT,
+                    .objectHandle = reinterpret_cast<uint64_t>(created_shaders[i]),
+                    .pObjectName = shader_name.c_str(),
+                };
+                device.vkSetDebugUtilsObjectNameEXT(device.vk_device, &name_info);
+            }
+        }
+    }
+
     ImplComputePipeline::ImplComputePipeline(ManagedWeakPtr a_impl_device, ComputePipelineInfo a_info)
         : ImplPipeline(std::move(a_impl_device)), info{std::move(a_info)}
     {
@@ -282,6 +776,7 @@ namespace daxa
         };
         vkCreateShaderModule(this->impl_device.as<ImplDevice>()->vk_device, &shader_module_ci, nullptr, &vk_shader_module);
         this->vk_pipeline_layout = this->impl_device.as<ImplDevice>()->gpu_shader_resource_table.pipeline_layouts.at((this->info.push_constant_size + 3) / 4);
+        SpecializationData specialization_data{};
         VkComputePipelineCreateInfo const vk_compute_pipeline_create_info{
             .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
             .pNext = nullptr,
@@ -293,7 +788,7 @@ namespace daxa
                 .stage = VkShaderStageFlagBits::VK_SHADER_STAGE_COMPUTE_BIT,
                 .module = vk_shader_module,
                 .pName = this->info.shader_info.entry_point.has_value() ? this->info.shader_info.entry_point.value().c_str() : "main",
-                .pSpecializationInfo = nullptr,
+                .pSpecializationInfo = fill_specialization_info(this->info.shader_info, specialization_data),
             },
             .layout = this->vk_pipeline_layout,
             .basePipelineHandle = VK_NULL_HANDLE,
@@ -301,7 +796,7 @@ namespace daxa
         };
         [[maybe_unused]] auto pipeline_result = vkCreateComputePipelines(
             this->impl_device.as<ImplDevice>()->vk_device,
-            VK_NULL_HANDLE,
+            this->impl_device.as<ImplDevice>()->vk_pipeline_cache,
             1u,
             &vk_compute_pipeline_create_info,
             nullptr,
@@ -336,6 +831,7 @@ namespace daxa
             main_queue_cpu_timeline_value,
             PipelineZombie{
                 .vk_pipeline = vk_pipeline,
+                .vk_shaders = vk_shaders,
             },
         });
     }
@@ -10,9 +10,23 @@ namespace daxa
 
     static inline constexpr usize pipeline_manager_MAX_ATTACHMENTS = 16;
 
+    // Vertex, tesselation control, tesselation evaluation, fragment, task, mesh.
+    static inline constexpr usize RASTER_SHADER_OBJECT_STAGE_COUNT = 6;
+    // Graphics stages that must always be bound when the mesh shader feature is disabled.
+    static inline constexpr usize RASTER_SHADER_OBJECT_STAGE_COUNT_NO_MESH = 4;
+    static inline constexpr std::array<VkShaderStageFlagBits, RASTER_SHADER_OBJECT_STAGE_COUNT> RASTER_SHADER_OBJECT_STAGES = {
+        VK_SHADER_STAGE_VERTEX_BIT,
+        VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT,
+        VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT,
+        VK_SHADER_STAGE_FRAGMENT_BIT,
+        VK_SHADER_STAGE_TASK_BIT_EXT,
+        VK_SHADER_STAGE_MESH_BIT_EXT,
+    };
+
     struct PipelineZombie
     {
         VkPipeline vk_pipeline = {};
+        std::array<VkShaderEXT, RASTER_SHADER_OBJECT_STAGE_COUNT> vk_shaders = {};
     };
 
     struct ImplPipeline : ManagedSharedState
@@ -22,15 +36,39 @@ namespace daxa
         ManagedWeakPtr impl_device;
         VkPipeline vk_pipeline = {};
         VkPipelineLayout vk_pipeline_layout = {};
+        // Only used by raster pipelines created as shader objects, indexed like RASTER_SHADER_OBJECT_STAGES.
+        // Unused stages are VK_NULL_HANDLE, so that binding all of them unbinds the stages of the previous pipeline.
+        std::array<VkShaderEXT, RASTER_SHADER_OBJECT_STAGE_COUNT> vk_shaders = {};
 
         virtual ~ImplPipeline() override;
     };
 
+    // Shared with the background optimized link, which may finish after the pipeline was destroyed.
+    struct ImplOptimizedPipelineLink
+    {
+        DAXA_ONLY_IF_THREADSAFETY(std::mutex mtx = {});
+        std::atomic<VkPipeline> vk_pipeline = {};
+        bool abandoned = {};
+    };
+
     struct ImplRasterPipeline final : ImplPipeline
     {
         RasterPipelineInfo info;
+        bool uses_shader_objects = {};
+        // Only set for pipelines linked from graphics pipeline libraries.
+        std::shared_ptr<ImplOptimizedPipelineLink> optimized_link = {};
+        // Keys of the pipeline library parts this pipeline holds a reference to.
+        std::vector<std::string> library_keys = {};
 
         ImplRasterPipeline(ManagedWeakPtr a_impl_device, RasterPipelineInfo a_info);
+        virtual ~ImplRasterPipeline() override;
+
+        // The optimized pipeline once its background link finished, the fast linked or regular pipeline otherwise.
+        auto current_vk_pipeline() const -> VkPipeline;
+
+      private:
+        void create_shader_objects();
+        void link_from_pipeline_libraries(VkGraphicsPipelineCreateInfo const & full_create_info);
     };
 
     struct ImplComputePipeline final : ImplPipeline
@@ -34,6 +34,7 @@ namespace daxa
 
     auto Swapchain::acquire_next_image() -> ImageId
     {
+        DAXA_TRACE_SCOPE("Swapchain::acquire_next_image");
         auto & impl = *as<ImplSwapchain>();
         // A new frame starts.
         // We wait until the gpu timeline is frames of flight behind our cpu timeline value.
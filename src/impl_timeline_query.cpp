@@ -16,12 +16,19 @@ namespace daxa
 
     // NOTE(msakmary) should this be in device instead to avoid having to friend ImplQueryPool in QueryPool?
     auto TimelineQueryPool::get_query_results(u32 start_index, u32 count) -> std::vector<u64>
+    {
+        std::vector<u64> results(static_cast<u64>(count) * 2);
+        get_query_results(start_index, count, results);
+        return results;
+    }
+
+    auto TimelineQueryPool::get_query_results(u32 start_index, u32 count, std::span<u64> results) -> bool
     {
         auto & impl = *as<ImplTimelineQueryPool>();
         DAXA_DBG_ASSERT_TRUE_M(start_index + count - 1 < impl.info.query_count, "attempting to query results that are out of bound for given pool");
+        DAXA_DBG_ASSERT_TRUE_M(results.size() >= static_cast<usize>(count) * 2, "results span is too small to hold the queried results");
 
-        std::vector<u64> results(static_cast<u64>(count) * 2);
-        vkGetQueryPoolResults(
+        VkResult const result = vkGetQueryPoolResults(
             impl.impl_device.as<ImplDevice>()->vk_device,
             impl.vk_timeline_query_pool,
             start_index,
@@ -31,7 +38,7 @@ namespace daxa
             2ul * sizeof(u64),
             VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
 
-        return results;
+        return result == VK_SUCCESS;
     }
 
     ImplTimelineQueryPool::ImplTimelineQueryPool(ManagedWeakPtr a_impl_device, TimelineQueryPoolInfo a_info)
@@ -76,4 +83,98 @@ namespace daxa
                 .vk_timeline_query_pool = vk_timeline_query_pool,
             });
     }
+
+    QueryPool::QueryPool(ManagedPtr impl) : ManagedPtr(std::move(impl)) {}
+
+    auto QueryPool::info() const -> QueryPoolInfo const &
+    {
+        auto const & impl = *as<ImplQueryPool>();
+        return impl.info;
+    }
+
+    auto QueryPool::result_stride() const -> u32
+    {
+        auto const & impl = *as<ImplQueryPool>();
+        return impl.result_stride;
+    }
+
+    auto QueryPool::get_query_results(u32 start_index, u32 count, std::span<u64> results) -> bool
+    {
+        auto & impl = *as<ImplQueryPool>();
+        DAXA_DBG_ASSERT_TRUE_M(start_index + count - 1 < impl.info.query_count, "attempting to query results that are out of bound for given pool");
+        DAXA_DBG_ASSERT_TRUE_M(results.size() >= static_cast<usize>(count) * impl.result_stride, "results span is too small to hold the queried results");
+
+        // NOTE: Not passing VK_QUERY_RESULT_WAIT_BIT, the call returns VK_NOT_READY instead of blocking when a result is not available.
+        VkResult const result = vkGetQueryPoolResults(
+            impl.impl_device.as<ImplDevice>()->vk_device,
+            impl.vk_query_pool,
+            start_index,
+            count,
+            static_cast<usize>(count) * impl.result_stride * sizeof(u64),
+            results.data(),
+            impl.result_stride * sizeof(u64),
+            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+        return result == VK_SUCCESS;
+    }
+
+    auto QueryPool::is_query_available(u32 index) -> bool
+    {
+        // One value per possible pipeline statistic plus the availability value.
+        std::array<u64, 12> results = {};
+        return get_query_results(index, 1, results);
+    }
+
+    ImplQueryPool::ImplQueryPool(ManagedWeakPtr a_impl_device, QueryPoolInfo a_info)
+        : info{std::move(a_info)}, impl_device{std::move(a_impl_device)}
+    {
+        DAXA_DBG_ASSERT_TRUE_M(info.query_count > 0, "query pool must contain at least one query");
+        DAXA_DBG_ASSERT_TRUE_M(
+            info.query_type != QueryType::PIPELINE_STATISTICS || info.pipeline_statistics != PipelineStatisticFlagBits::NONE,
+            "pipeline statistics query pools must enable at least one statistic");
+        DAXA_DBG_ASSERT_TRUE_M(
+            info.query_type != QueryType::PIPELINE_STATISTICS || impl_device.as<ImplDevice>()->pipeline_statistics_queries_enabled,
+            "pipeline statistics queries are not supported by the device");
+
+        u32 const value_count = info.query_type == QueryType::PIPELINE_STATISTICS ? static_cast<u32>(std::popcount(info.pipeline_statistics.data)) : 1u;
+        result_stride = value_count + 1;
+
+        VkQueryPoolCreateInfo const vk_query_pool_create_info{
+            .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .queryType = static_cast<VkQueryType>(info.query_type),
+            .queryCount = info.query_count,
+            .pipelineStatistics = info.query_type == QueryType::PIPELINE_STATISTICS ? static_cast<VkQueryPipelineStatisticFlags>(info.pipeline_statistics.data) : 0u,
+        };
+
+        vkCreateQueryPool(impl_device.as<ImplDevice>()->vk_device, &vk_query_pool_create_info, nullptr, &vk_query_pool);
+        vkResetQueryPool(impl_device.as<ImplDevice>()->vk_device, vk_query_pool, 0, info.query_count);
+
+        if (this->impl_device.as<ImplDevice>()->impl_ctx.as<ImplInstance>()->info.enable_debug_utils && !info.name.empty())
+        {
+            VkDebugUtilsObjectNameInfoEXT const query_pool_name_info{
+                .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT,
+                .pNext = nullptr,
+                .objectType = VK_OBJECT_TYPE_QUERY_POOL,
+                .objectHandle = reinterpret_cast<uint64_t>(vk_query_pool),
+                .pObjectName = info.name.c_str(),
+            };
+            this->impl_device.as<ImplDevice>()->vkSetDebugUtilsObjectNameEXT(impl_device.as<ImplDevice>()->vk_device, &query_pool_name_info);
+        }
+    }
+
+    ImplQueryPool::~ImplQueryPool() // NOLINT(bugprone-exception-escape)
+    {
+        auto * device = this->impl_device.as<ImplDevice>();
+        DAXA_ONLY_IF_THREADSAFETY(std::unique_lock const lock{device->main_queue_zombies_mtx});
+        u64 const main_queue_cpu_timeline = DAXA_ATOMIC_FETCH(device->main_queue_cpu_timeline);
+
+        // NOTE: The zombie only holds the VkQueryPool, so it is shared with the timeline query pools.
+        device->main_queue_timeline_query_pool_zombies.emplace_back(
+            main_queue_cpu_timeline,
+            TimelineQueryPoolZombie{
+                .vk_timeline_query_pool = vk_query_pool,
+            });
+    }
 } // namespace daxa
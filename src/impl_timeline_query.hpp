@@ -27,4 +27,19 @@ namespace daxa
         friend struct TimelineQueryPool;
         ManagedWeakPtr impl_device = {};
     };
+
+    struct ImplQueryPool final : ManagedSharedState
+    {
+        QueryPoolInfo info = {};
+        VkQueryPool vk_query_pool = {};
+        // Number of u64 values written per query, including the availability value.
+        u32 result_stride = {};
+
+        ImplQueryPool(ManagedWeakPtr a_impl_device, QueryPoolInfo a_info);
+        ~ImplQueryPool();
+
+      private:
+        friend struct QueryPool;
+        ManagedWeakPtr impl_device = {};
+    };
 } // namespace daxa
@@ -0,0 +1,198 @@
+#include "impl_core.hpp"
+
+#include <daxa/trace.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace daxa
+{
+#if DAXA_TRACING
+    static constexpr u32 TRACE_CHUNK_EVENT_COUNT = 4096;
+
+    struct TraceEvent
+    {
+        std::array<char, TRACE_EVENT_NAME_SIZE> name = {};
+        u64 begin_ns = {};
+        u64 end_ns = {};
+    };
+
+    // Events are only ever written by the owning thread.
+    // The count is published with release semantics, so that readers on other threads only see completely written events.
+    struct TraceChunk
+    {
+        std::array<TraceEvent, TRACE_CHUNK_EVENT_COUNT> events = {};
+        std::atomic<u32> count = {};
+        std::atomic<TraceChunk *> next = {};
+    };
+
+    struct ThreadTraceBuffer
+    {
+        u32 thread_index = {};
+        TraceChunk head = {};
+        TraceChunk * tail = &head;
+
+        void free_chunks()
+        {
+            TraceChunk * chunk = head.next.exchange(nullptr);
+            while (chunk != nullptr)
+            {
+                TraceChunk * next = chunk->next.load();
+                delete chunk;
+                chunk = next;
+            }
+            head.count.store(0);
+            tail = &head;
+        }
+
+        ~ThreadTraceBuffer()
+        {
+            free_chunks();
+        }
+    };
+
+    struct TraceRegistry
+    {
+        std::mutex mtx = {};
+        // Buffers are kept alive after their thread exits, so that their events can still be exported.
+        std::vector<std::shared_ptr<ThreadTraceBuffer>> buffers = {};
+        std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    };
+
+    static auto trace_registry() -> TraceRegistry &
+    {
+        static TraceRegistry registry = {};
+        return registry;
+    }
+
+    static auto trace_time_ns() -> u64
+    {
+        auto const since_epoch = std::chrono::steady_clock::now() - trace_registry().epoch;
+        return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch).count());
+    }
+
+    static auto thread_trace_buffer() -> ThreadTraceBuffer &
+    {
+        thread_local std::shared_ptr<ThreadTraceBuffer> const buffer = []()
+        {
+            auto & registry = trace_registry();
+            auto new_buffer = std::make_shared<ThreadTraceBuffer>();
+            std::lock_guard const lock{registry.mtx};
+            new_buffer->thread_index = static_cast<u32>(registry.buffers.size());
+            registry.buffers.push_back(new_buffer);
+            return new_buffer;
+        }();
+        return *buffer;
+    }
+
+    TraceScope::TraceScope(std::string_view a_name)
+    {
+        usize const name_size = std::min(a_name.size(), TRACE_EVENT_NAME_SIZE - 1);
+        std::memcpy(this->name.data(), a_name.data(), name_size);
+        this->name[name_size] = '\0';
+        this->begin_ns = trace_time_ns();
+    }
+
+    TraceScope::~TraceScope()
+    {
+        u64 const end_ns = trace_time_ns();
+        ThreadTraceBuffer & buffer = thread_trace_buffer();
+        TraceChunk * chunk = buffer.tail;
+        u32 event_index = chunk->count.load(std::memory_order_relaxed);
+        if (event_index == TRACE_CHUNK_EVENT_COUNT)
+        {
+            auto * new_chunk = new TraceChunk{};
+            chunk->next.store(new_chunk, std::memory_order_release);
+            buffer.tail = new_chunk;
+            chunk = new_chunk;
+            event_index = 0;
+        }
+        TraceEvent & event = chunk->events[event_index];
+        event.name = this->name;
+        event.begin_ns = this->begin_ns;
+        event.end_ns = end_ns;
+        chunk->count.store(event_index + 1, std::memory_order_release);
+    }
+
+    static void append_json_escaped(std::string & out, char const * str)
+    {
+        for (; *str != '\0'; ++str)
+        {
+            char const c = *str;
+            if (c == '"' || c == '\\')
+            {
+                out += '\\';
+                out += c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                out += fmt::format("\\u{:04x}", static_cast<u32>(c));
+            }
+            else
+            {
+                out += c;
+            }
+        }
+    }
+#endif
+
+    auto get_chrome_trace() -> std::string
+    {
+        std::string out = "{\"traceEvents\":[";
+#if DAXA_TRACING
+        auto & registry = trace_registry();
+        std::lock_guard const lock{registry.mtx};
+        bool first_event = true;
+        for (auto const & buffer : registry.buffers)
+        {
+            for (TraceChunk const * chunk = &buffer->head; chunk != nullptr; chunk = chunk->next.load(std::memory_order_acquire))
+            {
+                u32 const event_count = chunk->count.load(std::memory_order_acquire);
+                for (u32 event_index = 0; event_index < event_count; ++event_index)
+                {
+                    TraceEvent const & event = chunk->events[event_index];
+                    if (!first_event)
+                    {
+                        out += ",";
+                    }
+                    first_event = false;
+                    // Chrome trace timestamps and durations are in microseconds.
+                    out += "\n{\"name\":\"";
+                    append_json_escaped(out, event.name.data());
+                    out += fmt::format(
+                        "\",\"cat\":\"daxa\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":0,\"tid\":{}}}",
+                        static_cast<f64>(event.begin_ns) / 1000.0,
+                        static_cast<f64>(event.end_ns - event.begin_ns) / 1000.0,
+                        buffer->thread_index);
+                }
+            }
+        }
+#endif
+        out += "\n]}\n";
+        return out;
+    }
+
+    auto write_chrome_trace(std::filesystem::path const & path) -> bool
+    {
+        auto const trace = get_chrome_trace();
+        std::ofstream ofs{path, std::ios_base::trunc | std::ios_base::binary};
+        if (!ofs.good())
+        {
+            return false;
+        }
+        ofs.write(trace.data(), static_cast<std::streamsize>(trace.size()));
+        return ofs.good();
+    }
+
+    void clear_trace()
+    {
+#if DAXA_TRACING
+        auto & registry = trace_registry();
+        std::lock_guard const lock{registry.mtx};
+        for (auto & buffer : registry.buffers)
+        {
+            buffer->free_chunks();
+        }
+#endif
+    }
+} // namespace daxa
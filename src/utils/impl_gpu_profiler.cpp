@@ -0,0 +1,261 @@
+#if DAXA_BUILT_WITH_UTILS_GPU_PROFILER
+
+#include <daxa/utils/gpu_profiler.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace daxa
+{
+    static constexpr u32 NO_SCOPE = ~0u;
+
+    GpuProfiler::GpuProfiler(GpuProfilerInfo a_info)
+        : info{std::move(a_info)},
+          gpu_timeline{this->info.device.create_timeline_semaphore({
+              .initial_value = {},
+              .name = std::string("GpuProfiler") + this->info.name,
+          })},
+          timestamp_period_ns{static_cast<f64>(this->info.device.properties().limits.timestamp_period)}
+    {
+        DAXA_DBG_ASSERT_TRUE_M(this->info.frames_in_flight > 0, "gpu profiler needs at least one frame in flight");
+        DAXA_DBG_ASSERT_TRUE_M(this->info.max_scopes_per_frame > 0, "gpu profiler needs at least one scope per frame");
+        DAXA_DBG_ASSERT_TRUE_M(this->info.history_length > 0, "gpu profiler needs a history length of at least one frame");
+        this->frame_slots.resize(this->info.frames_in_flight);
+        for (u32 slot_index = 0; slot_index < this->info.frames_in_flight; ++slot_index)
+        {
+            this->frame_slots[slot_index].query_pool = this->info.device.create_timeline_query_pool({
+                .query_count = this->info.max_scopes_per_frame * 2,
+                .name = std::string("GpuProfiler") + this->info.name + " frame " + std::to_string(slot_index),
+            });
+            this->frame_slots[slot_index].scopes.reserve(this->info.max_scopes_per_frame);
+        }
+        this->query_results.resize(static_cast<usize>(this->info.max_scopes_per_frame) * 4);
+        this->sorted_durations.reserve(this->info.history_length);
+    }
+
+    GpuProfiler::GpuProfiler(GpuProfiler && other) = default;
+    GpuProfiler & GpuProfiler::operator=(GpuProfiler && other) = default;
+    GpuProfiler::~GpuProfiler() = default;
+
+    void GpuProfiler::begin_frame(CommandList & cmd_list)
+    {
+        DAXA_DBG_ASSERT_TRUE_M(!this->frame_open, "must end the previous frame before beginning a new one");
+        this->resolve_finished_frames();
+        this->frame_open = true;
+        this->frame_index += 1;
+        this->scope_stack.clear();
+        FrameSlot & slot = this->frame_slots[this->next_slot];
+        if (slot.pending)
+        {
+            // The gpu has not finished the frame that last used this slot. Instead of waiting, this frame is not profiled.
+            this->recording_slot = NO_SLOT;
+            this->dropped_frames += 1;
+            return;
+        }
+        this->recording_slot = this->next_slot;
+        this->next_slot = (this->next_slot + 1) % this->info.frames_in_flight;
+        slot.scopes.clear();
+        slot.frame_index = this->frame_index;
+        cmd_list.reset_timestamps({
+            .query_pool = slot.query_pool,
+            .start_index = 0,
+            .count = slot.query_pool.info().query_count,
+        });
+    }
+
+    void GpuProfiler::end_frame()
+    {
+        DAXA_DBG_ASSERT_TRUE_M(this->frame_open, "must begin a frame before ending it");
+        DAXA_DBG_ASSERT_TRUE_M(this->scope_stack.empty(), "all scopes must be ended before ending the frame");
+        this->frame_open = false;
+        // Dropped frames advance the timeline too, every frame signals its own strictly increasing value.
+        this->current_timeline_value += 1;
+        if (this->recording_slot == NO_SLOT)
+        {
+            return;
+        }
+        FrameSlot & slot = this->frame_slots[this->recording_slot];
+        slot.timeline_value = this->current_timeline_value;
+        slot.pending = true;
+        this->recording_slot = NO_SLOT;
+    }
+
+    void GpuProfiler::begin_scope(CommandList & cmd_list, std::string_view name)
+    {
+        DAXA_DBG_ASSERT_TRUE_M(this->frame_open, "scopes can only be recorded between begin and end frame");
+        cmd_list.begin_label({.label_name = std::string(name)});
+        if (this->recording_slot == NO_SLOT)
+        {
+            this->scope_stack.push_back(NO_SCOPE);
+            return;
+        }
+        FrameSlot & slot = this->frame_slots[this->recording_slot];
+        // When the scope limit is reached, the scope is only labeled but not timed.
+        if (slot.scopes.size() >= this->info.max_scopes_per_frame)
+        {
+            this->scope_stack.push_back(NO_SCOPE);
+            return;
+        }
+        u32 parent_index = GpuProfilerScope::NO_PARENT;
+        for (auto iter = this->scope_stack.rbegin(); iter != this->scope_stack.rend(); ++iter)
+        {
+            if (*iter != NO_SCOPE)
+            {
+                parent_index = *iter;
+                break;
+            }
+        }
+        u32 const scope_index = static_cast<u32>(slot.scopes.size());
+        RecordedScope scope = {
+            .name = std::string(name),
+            .path = {},
+            .parent_index = parent_index,
+            .depth = parent_index == GpuProfilerScope::NO_PARENT ? 0 : slot.scopes[parent_index].depth + 1,
+            .query_index = scope_index * 2,
+        };
+        scope.path = parent_index == GpuProfilerScope::NO_PARENT ? scope.name : slot.scopes[parent_index].path + "/" + scope.name;
+        cmd_list.write_timestamp({
+            .query_pool = slot.query_pool,
+            .pipeline_stage = PipelineStageFlagBits::TOP_OF_PIPE,
+            .query_index = scope.query_index,
+        });
+        slot.scopes.push_back(std::move(scope));
+        this->scope_stack.push_back(scope_index);
+    }
+
+    void GpuProfiler::end_scope(CommandList & cmd_list)
+    {
+        DAXA_DBG_ASSERT_TRUE_M(!this->scope_stack.empty(), "end_scope called without a matching begin_scope");
+        u32 const scope_index = this->scope_stack.back();
+        this->scope_stack.pop_back();
+        if (scope_index != NO_SCOPE)
+        {
+            FrameSlot & slot = this->frame_slots[this->recording_slot];
+            cmd_list.write_timestamp({
+                .query_pool = slot.query_pool,
+                .pipeline_stage = PipelineStageFlagBits::BOTTOM_OF_PIPE,
+                .query_index = slot.scopes[scope_index].query_index + 1,
+            });
+        }
+        cmd_list.end_label();
+    }
+
+    void GpuProfiler::resolve_finished_frames()
+    {
+        u64 const gpu_timeline_value = this->gpu_timeline.value();
+        // Resolve in submission order, so that the last resolved frame is always the newest one.
+        u32 const slot_count = this->info.frames_in_flight;
+        for (u32 i = 0; i < slot_count; ++i)
+        {
+            u32 const slot_index = (this->next_slot + i) % slot_count;
+            FrameSlot const & slot = this->frame_slots[slot_index];
+            if (slot.pending && slot.timeline_value <= gpu_timeline_value)
+            {
+                this->resolve_frame(slot_index);
+            }
+        }
+    }
+
+    void GpuProfiler::resolve_frame(u32 slot_index)
+    {
+        FrameSlot & slot = this->frame_slots[slot_index];
+        slot.pending = false;
+        u32 const query_count = static_cast<u32>(slot.scopes.size()) * 2;
+        if (query_count != 0)
+        {
+            slot.query_pool.get_query_results(0, query_count, this->query_results);
+        }
+
+        this->resolved_frame.frame_index = slot.frame_index;
+        this->resolved_frame.scopes.clear();
+        this->resolved_frame.scopes.reserve(slot.scopes.size());
+        for (auto & recorded_scope : slot.scopes)
+        {
+            // Results come in pairs of (timestamp, availability).
+            u64 const * begin_result = &this->query_results[static_cast<usize>(recorded_scope.query_index) * 2];
+            u64 const * end_result = begin_result + 2;
+            bool const available = begin_result[1] != 0 && end_result[1] != 0 && end_result[0] >= begin_result[0];
+            f64 const duration_ms = available ? static_cast<f64>(end_result[0] - begin_result[0]) * this->timestamp_period_ns / 1000000.0 : 0.0;
+
+            ScopeHistory & history = this->scope_histories[recorded_scope.path];
+            if (available)
+            {
+                history.durations_ms.push_back(duration_ms);
+                if (history.durations_ms.size() > this->info.history_length)
+                {
+                    history.durations_ms.pop_front();
+                }
+                this->sorted_durations.assign(history.durations_ms.begin(), history.durations_ms.end());
+                std::sort(this->sorted_durations.begin(), this->sorted_durations.end());
+                f64 sum = 0.0;
+                for (f64 const duration : this->sorted_durations)
+                {
+                    sum += duration;
+                }
+                auto const percentile = [&](f64 p) -> f64
+                {
+                    // Nearest rank percentile.
+                    auto const rank = static_cast<usize>(std::ceil(p * static_cast<f64>(this->sorted_durations.size())));
+                    return this->sorted_durations[std::max(rank, usize{1}) - 1];
+                };
+                history.statistics = GpuProfilerScopeStatistics{
+                    .average_ms = sum / static_cast<f64>(this->sorted_durations.size()),
+                    .min_ms = this->sorted_durations.front(),
+                    .max_ms = this->sorted_durations.back(),
+                    .p50_ms = percentile(0.50),
+                    .p95_ms = percentile(0.95),
+                    .p99_ms = percentile(0.99),
+                    .sample_count = static_cast<u32>(this->sorted_durations.size()),
+                };
+            }
+
+            this->resolved_frame.scopes.push_back(GpuProfilerScope{
+                .name = std::move(recorded_scope.name),
+                .path = std::move(recorded_scope.path),
+                .parent_index = recorded_scope.parent_index,
+                .depth = recorded_scope.depth,
+                .duration_ms = duration_ms,
+                .statistics = history.statistics,
+            });
+        }
+        slot.scopes.clear();
+    }
+
+    auto GpuProfiler::timeline_value() const -> u64
+    {
+        return this->current_timeline_value;
+    }
+
+    auto GpuProfiler::get_timeline_semaphore() -> TimelineSemaphore
+    {
+        return this->gpu_timeline;
+    }
+
+    auto GpuProfiler::get_info() const -> GpuProfilerInfo const &
+    {
+        return this->info;
+    }
+
+    auto GpuProfiler::last_frame() const -> GpuProfilerFrame const &
+    {
+        return this->resolved_frame;
+    }
+
+    auto GpuProfiler::scope_statistics(std::string_view path) const -> std::optional<GpuProfilerScopeStatistics>
+    {
+        auto iter = this->scope_histories.find(std::string(path));
+        if (iter == this->scope_histories.end())
+        {
+            return std::nullopt;
+        }
+        return iter->second.statistics;
+    }
+
+    auto GpuProfiler::dropped_frame_count() const -> u64
+    {
+        return this->dropped_frames;
+    }
+} // namespace daxa
+
+#endif
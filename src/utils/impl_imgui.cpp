@@ -1181,14 +1181,14 @@ namespace daxa
     void ImplImGuiRenderer::recreate_vbuffer(usize vbuffer_new_size)
     {
         vbuffer = info.device.create_buffer({
-            .size = static_cast<u32>(vbuffer_new_size),
+            .size = vbuffer_new_size,
             .name = std::string("dear ImGui vertex buffer"),
         });
     }
     void ImplImGuiRenderer::recreate_ibuffer(usize ibuffer_new_size)
     {
         ibuffer = info.device.create_buffer({
-            .size = static_cast<u32>(ibuffer_new_size),
+            .size = ibuffer_new_size,
             .name = std::string("dear ImGui index buffer"),
         });
     }
@@ -1217,7 +1217,7 @@ namespace daxa
             }
 
             auto staging_vbuffer = info.device.create_buffer({
-                .size = static_cast<u32>(vbuffer_needed_size),
+                .size = vbuffer_needed_size,
                 .allocate_info = AutoAllocInfo{daxa::MemoryFlagBits::HOST_ACCESS_RANDOM},
                 .name = std::string("dear ImGui vertex staging buffer ") + std::to_string(frame_count),
             });
@@ -1230,7 +1230,7 @@ namespace daxa
             }
             cmd_list.destroy_buffer_deferred(staging_vbuffer);
             auto staging_ibuffer = info.device.create_buffer({
-                .size = static_cast<u32>(ibuffer_needed_size),
+                .size = ibuffer_needed_size,
                 .allocate_info = AutoAllocInfo{daxa::MemoryFlagBits::HOST_ACCESS_RANDOM},
                 .name = std::string("dear ImGui index staging buffer ") + std::to_string(frame_count),
             });
@@ -1376,7 +1376,7 @@ namespace daxa
         });
 
         auto texture_staging_buffer = this->info.device.create_buffer({
-            .size = static_cast<u32>(upload_size),
+            .size = upload_size,
             .allocate_info = AutoAllocInfo{daxa::MemoryFlagBits::HOST_ACCESS_RANDOM},
         });
 
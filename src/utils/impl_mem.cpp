@@ -1,24 +1,36 @@
 #if DAXA_BUILT_WITH_UTILS_MEM
 
 #include <daxa/utils/mem.hpp>
+#include <daxa/utils/mem.inl>
+#include <daxa/trace.hpp>
+#include <bit>
+#include <cstring>
+#include <algorithm>
 #include <utility>
 
 namespace daxa
 {
+    static auto create_transfer_memory_pool_buffer(TransferMemoryPoolInfo const & info, usize capacity) -> BufferId
+    {
+        return info.device.create_buffer({
+            .size = capacity,
+            .allocate_info = AutoAllocInfo{daxa::MemoryFlagBits::HOST_ACCESS_SEQUENTIAL_WRITE | (info.use_bar_memory ? daxa::MemoryFlagBits::DEDICATED_MEMORY : daxa::MemoryFlagBits::NONE)},
+            .name = std::string("TransferMemoryPool") + info.name,
+        });
+    }
+
     TransferMemoryPool::TransferMemoryPool(TransferMemoryPoolInfo a_info)
         : info{std::move(a_info)},
           gpu_timeline{this->info.device.create_timeline_semaphore({
               .initial_value = {},
               .name = std::string("TransferMemoryPool") + this->info.name,
           })},
-          buffer{this->info.device.create_buffer({
-              .size = this->info.capacity,
-              .allocate_info = AutoAllocInfo{ daxa::MemoryFlagBits::HOST_ACCESS_SEQUENTIAL_WRITE | (a_info.use_bar_memory ? daxa::MemoryFlagBits::DEDICATED_MEMORY : daxa::MemoryFlagBits::NONE) },
-              .name = std::string("TransferMemoryPool") + this->info.name,
-          })},
+          buffer{create_transfer_memory_pool_buffer(this->info, this->info.capacity)},
           buffer_device_address{this->info.device.get_device_address(this->buffer)},
-          buffer_host_address{this->info.device.get_host_address(this->buffer)}
+          buffer_host_address{this->info.device.get_host_address(this->buffer)},
+          capacity{this->info.capacity}
     {
+        DAXA_DBG_ASSERT_TRUE_M(this->info.max_capacity == 0 || this->info.max_capacity >= this->info.capacity, "max capacity must be zero or at least the initial capacity");
     }
     
     TransferMemoryPool::TransferMemoryPool(TransferMemoryPool && other)
@@ -27,11 +39,16 @@ namespace daxa
         std::swap(this->gpu_timeline, other.gpu_timeline);
         std::swap(this->current_timeline_value, other.current_timeline_value); 
         std::swap(this->live_allocations, other.live_allocations); 
+        std::swap(this->retired_blocks, other.retired_blocks); 
         std::swap(this->buffer, other.buffer); 
         std::swap(this->buffer_device_address, other.buffer_device_address); 
         std::swap(this->buffer_host_address, other.buffer_host_address); 
+        std::swap(this->capacity, other.capacity); 
         std::swap(this->claimed_start, other.claimed_start); 
         std::swap(this->claimed_size, other.claimed_size); 
+        std::swap(this->retired_claimed_size, other.retired_claimed_size); 
+        std::swap(this->high_water_mark, other.high_water_mark); 
+        std::swap(this->grow_count, other.grow_count); 
     }
 
     TransferMemoryPool& TransferMemoryPool::operator=(TransferMemoryPool && other)
@@ -40,15 +57,25 @@ namespace daxa
         {
             this->info.device.destroy_buffer(this->buffer);
         }
+        for (auto const & retired_block : this->retired_blocks)
+        {
+            this->info.device.destroy_buffer(retired_block.buffer);
+        }
+        this->retired_blocks.clear();
         std::swap(this->info, other.info);
         std::swap(this->gpu_timeline, other.gpu_timeline);
         std::swap(this->current_timeline_value, other.current_timeline_value); 
         std::swap(this->live_allocations, other.live_allocations); 
+        std::swap(this->retired_blocks, other.retired_blocks); 
         std::swap(this->buffer, other.buffer); 
         std::swap(this->buffer_device_address, other.buffer_device_address); 
         std::swap(this->buffer_host_address, other.buffer_host_address); 
+        std::swap(this->capacity, other.capacity); 
         std::swap(this->claimed_start, other.claimed_start); 
         std::swap(this->claimed_size, other.claimed_size); 
+        std::swap(this->retired_claimed_size, other.retired_claimed_size); 
+        std::swap(this->high_water_mark, other.high_water_mark); 
+        std::swap(this->grow_count, other.grow_count); 
         return *this;
     }
 
@@ -58,29 +85,41 @@ namespace daxa
         {
             this->info.device.destroy_buffer(this->buffer);
         }
+        // Buffer destruction is deferred by the device until the gpu finished using them.
+        for (auto const & retired_block : this->retired_blocks)
+        {
+            this->info.device.destroy_buffer(retired_block.buffer);
+        }
     }
 
-    auto TransferMemoryPool::allocate(u32 allocation_size, u32 alignment_requirement) -> std::optional<TransferMemoryPool::Allocation>
+    auto TransferMemoryPool::allocate(usize allocation_size, usize alignment_requirement) -> std::optional<TransferMemoryPool::Allocation>
     {
-        u32 const tail_alloc_offset = (this->claimed_start + this->claimed_size) % this->info.capacity;
         auto upalign_offset = [](auto value, auto alignment){
             return (value + alignment - 1) / alignment * alignment;
         };
-        u32 const tail_alloc_offset_aligned = upalign_offset(tail_alloc_offset, alignment_requirement);
-        u32 const tail_alloc_align_padding = tail_alloc_offset_aligned - tail_alloc_offset;
+        usize tail_alloc_offset = {};
+        usize tail_alloc_offset_aligned = {};
+        usize tail_alloc_align_padding = {};
+        auto calc_tail_offsets = [&]()
+        {
+            tail_alloc_offset = (this->claimed_start + this->claimed_size) % this->capacity;
+            tail_alloc_offset_aligned = upalign_offset(tail_alloc_offset, alignment_requirement);
+            tail_alloc_align_padding = tail_alloc_offset_aligned - tail_alloc_offset;
+        };
+        calc_tail_offsets();
         // Two allocations are possible:
         // Tail allocation is when the allocation is placed directly at the end of all other allocations.
         // Zero offset allocation is possible when there is not enough space left at the tail BUT there is enough space from 0 up to the start of the other allocations.
         auto calc_tail_allocation_possible = [&]()
         {
-            u32 const tail = tail_alloc_offset_aligned;
-            bool const wrapped = this->claimed_start + this->claimed_size > this->info.capacity;
-            u32 const end = wrapped ? this->claimed_start : this->info.capacity;
+            usize const tail = tail_alloc_offset_aligned;
+            bool const wrapped = this->claimed_start + this->claimed_size > this->capacity;
+            usize const end = wrapped ? this->claimed_start : this->capacity;
             return tail + allocation_size <= end;
         };
         auto calc_zero_offset_allocation_possible = [&]()
         {
-            return this->claimed_start + this->claimed_size <= this->info.capacity && allocation_size < this->claimed_start;
+            return this->claimed_start + this->claimed_size <= this->capacity && allocation_size < this->claimed_start;
         };
         // Firstly, test if there is enough continuous space left to allocate.
         bool tail_allocation_possible = calc_tail_allocation_possible();
@@ -94,13 +133,19 @@ namespace daxa
             zero_offset_allocation_possible = calc_zero_offset_allocation_possible();
             if (!tail_allocation_possible && !zero_offset_allocation_possible)
             {
-                return std::nullopt;
+                if (!this->info.allow_growth || !this->grow(allocation_size, alignment_requirement))
+                {
+                    return std::nullopt;
+                }
+                // The new block is empty, the allocation is always placed at offset 0.
+                calc_tail_offsets();
+                tail_allocation_possible = true;
             }
         }
         current_timeline_value += 1;
-        u32 returned_allocation_offset = {};
-        u32 actual_allocation_offset = {};
-        u32 actual_allocation_size = {};
+        usize returned_allocation_offset = {};
+        usize actual_allocation_offset = {};
+        usize actual_allocation_size = {};
         if (tail_allocation_possible)
         {
             actual_allocation_size = allocation_size + tail_alloc_align_padding;
@@ -109,12 +154,13 @@ namespace daxa
         }
         else // Zero offset allocation.
         {
-            u32 const left_tail_space = this->info.capacity - (this->claimed_start + this->claimed_size);
+            usize const left_tail_space = this->capacity - (this->claimed_start + this->claimed_size);
             actual_allocation_size = allocation_size + left_tail_space;
             returned_allocation_offset = {};
             actual_allocation_offset = {};
         }
         this->claimed_size += actual_allocation_size;
+        this->high_water_mark = std::max(this->high_water_mark, this->claimed_size + this->retired_claimed_size);
         live_allocations.push_back(TrackedAllocation{
             .timeline_index = this->current_timeline_value,
             .offset = actual_allocation_offset,
@@ -123,12 +169,50 @@ namespace daxa
         return Allocation{
             .device_address = this->buffer_device_address + returned_allocation_offset,
             .host_address = reinterpret_cast<void *>(reinterpret_cast<u8 *>(this->buffer_host_address) + returned_allocation_offset),
+            .buffer = this->buffer,
             .buffer_offset = returned_allocation_offset,
             .size = allocation_size,
             .timeline_index = this->current_timeline_value,
         };
     }
 
+    auto TransferMemoryPool::grow(usize allocation_size, usize alignment_requirement) -> bool
+    {
+        usize new_capacity = std::max(this->capacity * 2, allocation_size + alignment_requirement);
+        if (this->info.max_capacity != 0)
+        {
+            new_capacity = std::min(new_capacity, this->info.max_capacity);
+            // Once the max capacity is reached the pool stops growing, instead of chaining more blocks of the same size.
+            if (new_capacity < allocation_size || new_capacity <= this->capacity)
+            {
+                return false;
+            }
+        }
+        // All live allocations of the current block are freed together once the gpu reached the last one.
+        if (!this->live_allocations.empty())
+        {
+            this->retired_blocks.push_back(RetiredBlock{
+                .buffer = this->buffer,
+                .claimed_size = this->claimed_size,
+                .last_timeline_index = this->live_allocations.back().timeline_index,
+            });
+            this->retired_claimed_size += this->claimed_size;
+        }
+        else
+        {
+            this->info.device.destroy_buffer(this->buffer);
+        }
+        this->buffer = create_transfer_memory_pool_buffer(this->info, new_capacity);
+        this->buffer_device_address = this->info.device.get_device_address(this->buffer);
+        this->buffer_host_address = this->info.device.get_host_address(this->buffer);
+        this->capacity = new_capacity;
+        this->live_allocations.clear();
+        this->claimed_start = {};
+        this->claimed_size = {};
+        this->grow_count += 1;
+        return true;
+    }
+
     auto TransferMemoryPool::timeline_value() const -> usize
     {
         return this->current_timeline_value;
@@ -139,10 +223,16 @@ namespace daxa
         auto const current_gpu_timeline_value = this->gpu_timeline.value();
         while (!live_allocations.empty() && live_allocations.front().timeline_index <= current_gpu_timeline_value)
         {
-            this->claimed_start = (this->claimed_start + live_allocations.front().size) % this->info.capacity;
+            this->claimed_start = (this->claimed_start + live_allocations.front().size) % this->capacity;
             this->claimed_size -= live_allocations.front().size;
             live_allocations.pop_front();
         }
+        while (!retired_blocks.empty() && retired_blocks.front().last_timeline_index <= current_gpu_timeline_value)
+        {
+            this->info.device.destroy_buffer(retired_blocks.front().buffer);
+            this->retired_claimed_size -= retired_blocks.front().claimed_size;
+            retired_blocks.pop_front();
+        }
     }
 
     auto TransferMemoryPool::get_timeline_semaphore() -> TimelineSemaphore
@@ -159,6 +249,886 @@ namespace daxa
     {
         return this->buffer;
     }
+
+    auto TransferMemoryPool::statistics() const -> TransferMemoryPoolStatistics
+    {
+        return TransferMemoryPoolStatistics{
+            .capacity = this->capacity,
+            .claimed_size = this->claimed_size + this->retired_claimed_size,
+            .high_water_mark = this->high_water_mark,
+            .block_count = static_cast<u32>(this->retired_blocks.size() + 1),
+            .grow_count = this->grow_count,
+        };
+    }
+
+    ConcurrentTransferMemoryPool::ConcurrentTransferMemoryPool(ConcurrentTransferMemoryPoolInfo a_info)
+        : info{std::move(a_info)},
+          gpu_timeline{this->info.device.create_timeline_semaphore({
+              .initial_value = {},
+              .name = std::string("ConcurrentTransferMemoryPool") + this->info.name,
+          })},
+          buffer{this->info.device.create_buffer({
+              .size = this->info.capacity,
+              .allocate_info = AutoAllocInfo{daxa::MemoryFlagBits::HOST_ACCESS_SEQUENTIAL_WRITE | (this->info.use_bar_memory ? daxa::MemoryFlagBits::DEDICATED_MEMORY : daxa::MemoryFlagBits::NONE)},
+              .name = std::string("ConcurrentTransferMemoryPool") + this->info.name,
+          })},
+          buffer_device_address{this->info.device.get_device_address(this->buffer)},
+          buffer_host_address{this->info.device.get_host_address(this->buffer)}
+    {
+    }
+
+    ConcurrentTransferMemoryPool::ConcurrentTransferMemoryPool(ConcurrentTransferMemoryPool && other)
+    {
+        std::swap(this->info, other.info);
+        std::swap(this->gpu_timeline, other.gpu_timeline);
+        this->head.store(other.head.exchange(this->head.load()));
+        this->tail.store(other.tail.exchange(this->tail.load()));
+        this->current_timeline_value.store(other.current_timeline_value.exchange(this->current_timeline_value.load()));
+        std::swap(this->live_batches, other.live_batches);
+        std::swap(this->buffer, other.buffer);
+        std::swap(this->buffer_device_address, other.buffer_device_address);
+        std::swap(this->buffer_host_address, other.buffer_host_address);
+    }
+
+    ConcurrentTransferMemoryPool & ConcurrentTransferMemoryPool::operator=(ConcurrentTransferMemoryPool && other)
+    {
+        if (!this->buffer.is_empty())
+        {
+            this->info.device.destroy_buffer(this->buffer);
+        }
+        std::swap(this->info, other.info);
+        std::swap(this->gpu_timeline, other.gpu_timeline);
+        this->head.store(other.head.exchange(this->head.load()));
+        this->tail.store(other.tail.exchange(this->tail.load()));
+        this->current_timeline_value.store(other.current_timeline_value.exchange(this->current_timeline_value.load()));
+        std::swap(this->live_batches, other.live_batches);
+        std::swap(this->buffer, other.buffer);
+        std::swap(this->buffer_device_address, other.buffer_device_address);
+        std::swap(this->buffer_host_address, other.buffer_host_address);
+        return *this;
+    }
+
+    ConcurrentTransferMemoryPool::~ConcurrentTransferMemoryPool()
+    {
+        if (!this->buffer.is_empty())
+        {
+            this->info.device.destroy_buffer(this->buffer);
+        }
+    }
+
+    auto ConcurrentTransferMemoryPool::allocate(usize allocation_size, usize alignment_requirement) -> std::optional<ConcurrentTransferMemoryPool::Allocation>
+    {
+        u64 const capacity = this->info.capacity;
+        // The first attempt only uses the already reclaimed space.
+        // When that fails, all finished batches are reclaimed and the allocation is tried once more.
+        for (u32 attempt = 0; attempt < 2; ++attempt)
+        {
+            u64 old_head = this->head.load(std::memory_order_relaxed);
+            while (true)
+            {
+                u64 const head_offset = old_head % capacity;
+                u64 const head_offset_aligned = (head_offset + alignment_requirement - 1) / alignment_requirement * alignment_requirement;
+                u64 allocation_start = old_head + (head_offset_aligned - head_offset);
+                // Allocations never wrap around the end of the buffer.
+                // When the tail space is too small, the space is skipped and the allocation is placed at offset zero.
+                if (allocation_start % capacity + allocation_size > capacity)
+                {
+                    allocation_start = old_head + (capacity - head_offset);
+                }
+                u64 const new_head = allocation_start + allocation_size;
+                if (new_head - this->tail.load(std::memory_order_acquire) > capacity)
+                {
+                    break;
+                }
+                // On failure old_head is updated to the head another thread published and the allocation is recalculated.
+                if (this->head.compare_exchange_weak(old_head, new_head, std::memory_order_acq_rel, std::memory_order_relaxed))
+                {
+                    usize const buffer_offset = static_cast<usize>(allocation_start % capacity);
+                    return Allocation{
+                        .device_address = this->buffer_device_address + buffer_offset,
+                        .host_address = reinterpret_cast<void *>(reinterpret_cast<u8 *>(this->buffer_host_address) + buffer_offset),
+                        .buffer_offset = buffer_offset,
+                        .size = allocation_size,
+                        .timeline_index = this->current_timeline_value.load(std::memory_order_relaxed),
+                    };
+                }
+            }
+            if (attempt == 0)
+            {
+                this->reclaim_unused_memory();
+            }
+        }
+        return std::nullopt;
+    }
+
+    auto ConcurrentTransferMemoryPool::end_batch() -> u64
+    {
+        std::lock_guard const lock{this->batches_mtx};
+        u64 const batch_timeline_value = this->current_timeline_value.fetch_add(1);
+        this->live_batches.push_back(TrackedBatch{
+            .timeline_index = batch_timeline_value,
+            .head = this->head.load(),
+        });
+        return batch_timeline_value;
+    }
+
+    void ConcurrentTransferMemoryPool::reclaim_unused_memory()
+    {
+        std::lock_guard const lock{this->batches_mtx};
+        auto const current_gpu_timeline_value = this->gpu_timeline.value();
+        u64 new_tail = this->tail.load(std::memory_order_relaxed);
+        while (!this->live_batches.empty() && this->live_batches.front().timeline_index <= current_gpu_timeline_value)
+        {
+            new_tail = this->live_batches.front().head;
+            this->live_batches.pop_front();
+        }
+        this->tail.store(new_tail, std::memory_order_release);
+    }
+
+    auto ConcurrentTransferMemoryPool::timeline_value() const -> u64
+    {
+        return this->current_timeline_value.load();
+    }
+
+    auto ConcurrentTransferMemoryPool::get_timeline_semaphore() -> TimelineSemaphore
+    {
+        return this->gpu_timeline;
+    }
+
+    auto ConcurrentTransferMemoryPool::get_info() const -> ConcurrentTransferMemoryPoolInfo const &
+    {
+        return this->info;
+    }
+
+    auto ConcurrentTransferMemoryPool::get_buffer() const -> daxa::BufferId
+    {
+        return this->buffer;
+    }
+
+    ReadbackMemoryPool::ReadbackMemoryPool(ReadbackMemoryPoolInfo a_info)
+        : info{std::move(a_info)},
+          gpu_timeline{this->info.device.create_timeline_semaphore({
+              .initial_value = {},
+              .name = std::string("ReadbackMemoryPool") + this->info.name,
+          })},
+          buffer{this->info.device.create_buffer({
+              .size = this->info.capacity,
+              .allocate_info = AutoAllocInfo{daxa::MemoryFlagBits::HOST_ACCESS_RANDOM},
+              .name = std::string("ReadbackMemoryPool") + this->info.name,
+          })},
+          buffer_device_address{this->info.device.get_device_address(this->buffer)},
+          buffer_host_address{this->info.device.get_host_address(this->buffer)}
+    {
+    }
+
+    ReadbackMemoryPool::ReadbackMemoryPool(ReadbackMemoryPool && other)
+    {
+        std::swap(this->info, other.info);
+        std::swap(this->gpu_timeline, other.gpu_timeline);
+        std::swap(this->current_timeline_value, other.current_timeline_value);
+        std::swap(this->live_allocations, other.live_allocations);
+        std::swap(this->buffer, other.buffer);
+        std::swap(this->buffer_device_address, other.buffer_device_address);
+        std::swap(this->buffer_host_address, other.buffer_host_address);
+        std::swap(this->claimed_start, other.claimed_start);
+        std::swap(this->claimed_size, other.claimed_size);
+    }
+
+    ReadbackMemoryPool & ReadbackMemoryPool::operator=(ReadbackMemoryPool && other)
+    {
+        if (!this->buffer.is_empty())
+        {
+            this->info.device.destroy_buffer(this->buffer);
+        }
+        std::swap(this->info, other.info);
+        std::swap(this->gpu_timeline, other.gpu_timeline);
+        std::swap(this->current_timeline_value, other.current_timeline_value);
+        std::swap(this->live_allocations, other.live_allocations);
+        std::swap(this->buffer, other.buffer);
+        std::swap(this->buffer_device_address, other.buffer_device_address);
+        std::swap(this->buffer_host_address, other.buffer_host_address);
+        std::swap(this->claimed_start, other.claimed_start);
+        std::swap(this->claimed_size, other.claimed_size);
+        return *this;
+    }
+
+    ReadbackMemoryPool::~ReadbackMemoryPool()
+    {
+        if (!this->buffer.is_empty())
+        {
+            this->info.device.destroy_buffer(this->buffer);
+        }
+    }
+
+    auto ReadbackMemoryPool::allocate(usize allocation_size, usize alignment_requirement) -> std::optional<ReadbackMemoryPool::Allocation>
+    {
+        // Mapped pointers are only valid until the next allocation, so reclaiming here is always safe.
+        this->reclaim_unused_memory();
+        usize const tail_alloc_offset = (this->claimed_start + this->claimed_size) % this->info.capacity;
+        usize const tail_alloc_offset_aligned = (tail_alloc_offset + alignment_requirement - 1) / alignment_requirement * alignment_requirement;
+        usize const tail_alloc_align_padding = tail_alloc_offset_aligned - tail_alloc_offset;
+        bool const wrapped = this->claimed_start + this->claimed_size > this->info.capacity;
+        usize const tail_end = wrapped ? this->claimed_start : this->info.capacity;
+        // Same as in the TransferMemoryPool, the allocation is either placed at the tail or at offset zero when the tail space is too small.
+        bool const tail_allocation_possible = tail_alloc_offset_aligned + allocation_size <= tail_end;
+        bool const zero_offset_allocation_possible = !wrapped && allocation_size < this->claimed_start;
+        if (!tail_allocation_possible && !zero_offset_allocation_possible)
+        {
+            return std::nullopt;
+        }
+        current_timeline_value += 1;
+        usize returned_allocation_offset = {};
+        usize actual_allocation_offset = {};
+        usize actual_allocation_size = {};
+        if (tail_allocation_possible)
+        {
+            actual_allocation_size = allocation_size + tail_alloc_align_padding;
+            returned_allocation_offset = tail_alloc_offset_aligned;
+            actual_allocation_offset = tail_alloc_offset;
+        }
+        else // Zero offset allocation.
+        {
+            usize const left_tail_space = this->info.capacity - (this->claimed_start + this->claimed_size);
+            actual_allocation_size = allocation_size + left_tail_space;
+        }
+        this->claimed_size += actual_allocation_size;
+        live_allocations.push_back(TrackedAllocation{
+            .timeline_index = this->current_timeline_value,
+            .offset = actual_allocation_offset,
+            .size = actual_allocation_size,
+            .released = false,
+        });
+        return Allocation{
+            .device_address = this->buffer_device_address + returned_allocation_offset,
+            .buffer_offset = returned_allocation_offset,
+            .size = allocation_size,
+            .timeline_index = this->current_timeline_value,
+        };
+    }
+
+    auto ReadbackMemoryPool::try_map(Allocation const & allocation) -> void const *
+    {
+        if (allocation.timeline_index > this->gpu_timeline.value())
+        {
+            return nullptr;
+        }
+        // Live allocations are sorted by their timeline index.
+        auto iter = std::lower_bound(
+            this->live_allocations.begin(), this->live_allocations.end(), allocation.timeline_index,
+            [](TrackedAllocation const & tracked, u64 timeline_index)
+            { return tracked.timeline_index < timeline_index; });
+        DAXA_DBG_ASSERT_TRUE_M(iter != this->live_allocations.end() && iter->timeline_index == allocation.timeline_index, "allocation was already reclaimed, it must be mapped before the next allocation after its first successful mapping");
+        iter->released = true;
+        return reinterpret_cast<void const *>(reinterpret_cast<u8 const *>(this->buffer_host_address) + allocation.buffer_offset);
+    }
+
+    void ReadbackMemoryPool::discard(Allocation const & allocation)
+    {
+        auto iter = std::lower_bound(
+            this->live_allocations.begin(), this->live_allocations.end(), allocation.timeline_index,
+            [](TrackedAllocation const & tracked, u64 timeline_index)
+            { return tracked.timeline_index < timeline_index; });
+        // Mapped allocations may already be reclaimed.
+        if (iter != this->live_allocations.end() && iter->timeline_index == allocation.timeline_index)
+        {
+            iter->released = true;
+        }
+    }
+
+    void ReadbackMemoryPool::reclaim_unused_memory()
+    {
+        auto const current_gpu_timeline_value = this->gpu_timeline.value();
+        while (!live_allocations.empty() && live_allocations.front().released && live_allocations.front().timeline_index <= current_gpu_timeline_value)
+        {
+            this->claimed_start = (this->claimed_start + live_allocations.front().size) % this->info.capacity;
+            this->claimed_size -= live_allocations.front().size;
+            live_allocations.pop_front();
+        }
+    }
+
+    auto ReadbackMemoryPool::timeline_value() const -> usize
+    {
+        return this->current_timeline_value;
+    }
+
+    auto ReadbackMemoryPool::get_timeline_semaphore() -> TimelineSemaphore
+    {
+        return this->gpu_timeline;
+    }
+
+    auto ReadbackMemoryPool::get_info() const -> ReadbackMemoryPoolInfo const &
+    {
+        return this->info;
+    }
+
+    auto ReadbackMemoryPool::get_buffer() const -> daxa::BufferId
+    {
+        return this->buffer;
+    }
+
+    static auto frame_linear_allocator_timeline(FrameLinearAllocatorInfo const & info) -> TimelineSemaphore
+    {
+        if (info.swapchain.is_valid())
+        {
+            return info.swapchain.get_gpu_timeline_semaphore();
+        }
+        if (info.gpu_timeline.is_valid())
+        {
+            return info.gpu_timeline;
+        }
+        return info.device.create_timeline_semaphore({
+            .initial_value = {},
+            .name = std::string("FrameLinearAllocator") + info.name,
+        });
+    }
+
+    FrameLinearAllocator::FrameLinearAllocator(FrameLinearAllocatorInfo a_info)
+        : info{std::move(a_info)},
+          gpu_timeline{frame_linear_allocator_timeline(this->info)}
+    {
+        if (this->info.swapchain.is_valid())
+        {
+            // acquire_next_image only waits for the frame before the last max_allowed_frames_in_flight frames.
+            // With one more region, the region of a new frame is always retired after acquiring.
+            this->info.frames_in_flight = this->info.swapchain.info().max_allowed_frames_in_flight + 1;
+            this->current_frame_value = this->info.swapchain.get_cpu_timeline_value();
+        }
+        DAXA_DBG_ASSERT_TRUE_M(this->info.frames_in_flight > 0, "frames in flight must be greater than zero");
+        this->buffer = this->info.device.create_buffer({
+            .size = this->info.frame_capacity * this->info.frames_in_flight,
+            .allocate_info = AutoAllocInfo{daxa::MemoryFlagBits::HOST_ACCESS_SEQUENTIAL_WRITE | (this->info.use_bar_memory ? daxa::MemoryFlagBits::DEDICATED_MEMORY : daxa::MemoryFlagBits::NONE)},
+            .name = std::string("FrameLinearAllocator") + this->info.name,
+        });
+        this->buffer_device_address = this->info.device.get_device_address(this->buffer);
+        this->buffer_host_address = this->info.device.get_host_address(this->buffer);
+        this->region_offset = (this->current_frame_value % this->info.frames_in_flight) * this->info.frame_capacity;
+    }
+
+    FrameLinearAllocator::FrameLinearAllocator(FrameLinearAllocator && other)
+    {
+        std::swap(this->info, other.info);
+        std::swap(this->gpu_timeline, other.gpu_timeline);
+        std::swap(this->current_frame_value, other.current_frame_value);
+        std::swap(this->region_offset, other.region_offset);
+        std::swap(this->region_head, other.region_head);
+        std::swap(this->buffer, other.buffer);
+        std::swap(this->buffer_device_address, other.buffer_device_address);
+        std::swap(this->buffer_host_address, other.buffer_host_address);
+    }
+
+    FrameLinearAllocator & FrameLinearAllocator::operator=(FrameLinearAllocator && other)
+    {
+        if (!this->buffer.is_empty())
+        {
+            this->info.device.destroy_buffer(this->buffer);
+        }
+        std::swap(this->info, other.info);
+        std::swap(this->gpu_timeline, other.gpu_timeline);
+        std::swap(this->current_frame_value, other.current_frame_value);
+        std::swap(this->region_offset, other.region_offset);
+        std::swap(this->region_head, other.region_head);
+        std::swap(this->buffer, other.buffer);
+        std::swap(this->buffer_device_address, other.buffer_device_address);
+        std::swap(this->buffer_host_address, other.buffer_host_address);
+        return *this;
+    }
+
+    FrameLinearAllocator::~FrameLinearAllocator()
+    {
+        if (!this->buffer.is_empty())
+        {
+            this->info.device.destroy_buffer(this->buffer);
+        }
+    }
+
+    void FrameLinearAllocator::begin_frame()
+    {
+        if (this->info.swapchain.is_valid())
+        {
+            this->current_frame_value = this->info.swapchain.get_cpu_timeline_value();
+        }
+        else
+        {
+            this->current_frame_value += 1;
+        }
+        // The region was last used by the frame frames_in_flight frames ago.
+        u64 const frames_in_flight = this->info.frames_in_flight;
+        if (this->current_frame_value > frames_in_flight)
+        {
+            u64 const retired_frame_value = this->current_frame_value - frames_in_flight;
+            if (this->gpu_timeline.value() < retired_frame_value)
+            {
+                this->gpu_timeline.wait_for_value(retired_frame_value);
+            }
+        }
+        this->region_offset = (this->current_frame_value % frames_in_flight) * this->info.frame_capacity;
+        this->region_head = {};
+    }
+
+    auto FrameLinearAllocator::allocate(usize allocation_size, usize alignment_requirement) -> std::optional<FrameLinearAllocator::Allocation>
+    {
+        usize const head = this->region_offset + this->region_head;
+        usize const aligned_head = (head + alignment_requirement - 1) / alignment_requirement * alignment_requirement;
+        if (aligned_head + allocation_size > this->region_offset + this->info.frame_capacity)
+        {
+            return std::nullopt;
+        }
+        this->region_head = aligned_head + allocation_size - this->region_offset;
+        return Allocation{
+            .device_address = this->buffer_device_address + aligned_head,
+            .host_address = reinterpret_cast<void *>(reinterpret_cast<u8 *>(this->buffer_host_address) + aligned_head),
+            .buffer_offset = aligned_head,
+            .size = allocation_size,
+        };
+    }
+
+    auto FrameLinearAllocator::timeline_value() const -> u64
+    {
+        return this->current_frame_value;
+    }
+
+    auto FrameLinearAllocator::get_timeline_semaphore() -> TimelineSemaphore
+    {
+        return this->gpu_timeline;
+    }
+
+    auto FrameLinearAllocator::used_size() const -> usize
+    {
+        return this->region_head;
+    }
+
+    auto FrameLinearAllocator::get_info() const -> FrameLinearAllocatorInfo const &
+    {
+        return this->info;
+    }
+
+    auto FrameLinearAllocator::get_buffer() const -> daxa::BufferId
+    {
+        return this->buffer;
+    }
+
+    // Destination range of staged data, shared by the UploadBatcher and the GpuMirrorBuffer.
+    struct StagedRange
+    {
+        BufferId buffer = {};
+        usize dst_offset = {};
+        usize size = {};
+        usize staging_offset = {};
+        bool scatter = {};
+    };
+
+    struct StagedRangesLayout
+    {
+        usize staging_size = {};
+        usize scatter_count = {};
+    };
+
+    // Decides which ranges are scattered and assigns the staging offsets.
+    // Scatter commands are placed at the start of the staging allocation, followed by the packed range data.
+    static auto layout_staged_ranges(std::span<StagedRange> ranges, bool scatter_enabled, usize scatter_max_size, usize scatter_min_count) -> StagedRangesLayout
+    {
+        // Small, word aligned ranges are scattered by the compute pipeline when there are enough of them.
+        auto const is_scatter_candidate = [&](StagedRange const & range)
+        {
+            return range.size <= scatter_max_size && range.size % 4 == 0 && range.dst_offset % 4 == 0;
+        };
+        usize scatter_count = {};
+        if (scatter_enabled)
+        {
+            scatter_count = static_cast<usize>(std::count_if(ranges.begin(), ranges.end(), is_scatter_candidate));
+            if (scatter_count < scatter_min_count)
+            {
+                scatter_count = {};
+            }
+        }
+        usize staging_size = scatter_count * sizeof(UploadScatterCommand);
+        for (auto & range : ranges)
+        {
+            range.scatter = scatter_count != 0 && is_scatter_candidate(range);
+            staging_size = (staging_size + 3) / 4 * 4;
+            range.staging_offset = staging_size;
+            staging_size += range.size;
+        }
+        return StagedRangesLayout{.staging_size = staging_size, .scatter_count = scatter_count};
+    }
+
+    // Records the copies and the scatter dispatch for ranges sorted by buffer, whose data is already written to the staging allocation.
+    // Returns the access of the recorded writes.
+    static auto record_staged_ranges(
+        CommandList & cmd_list,
+        Device & device,
+        ComputePipeline const * scatter_pipeline,
+        TransferMemoryPool::Allocation const & staging_alloc,
+        std::span<StagedRange const> ranges,
+        StagedRangesLayout const & layout) -> Access
+    {
+        Access src_access = AccessConsts::NONE;
+        std::vector<BufferCopyRegion> regions = {};
+        for (usize range_index = 0; range_index < ranges.size();)
+        {
+            BufferId const buffer = ranges[range_index].buffer;
+            regions.clear();
+            for (; range_index < ranges.size() && ranges[range_index].buffer == buffer; ++range_index)
+            {
+                StagedRange const & range = ranges[range_index];
+                if (!range.scatter)
+                {
+                    regions.push_back(BufferCopyRegion{
+                        .src_offset = staging_alloc.buffer_offset + range.staging_offset,
+                        .dst_offset = range.dst_offset,
+                        .size = range.size,
+                    });
+                }
+            }
+            if (!regions.empty())
+            {
+                cmd_list.copy_buffer_to_buffer_regions({
+                    .src_buffer = staging_alloc.buffer,
+                    .dst_buffer = buffer,
+                    .regions = regions,
+                });
+                src_access = src_access | AccessConsts::TRANSFER_WRITE;
+            }
+        }
+        if (layout.scatter_count != 0)
+        {
+            auto * commands = reinterpret_cast<UploadScatterCommand *>(staging_alloc.host_address);
+            usize command_index = {};
+            for (auto const & range : ranges)
+            {
+                if (range.scatter)
+                {
+                    commands[command_index++] = UploadScatterCommand{
+                        .dst_address = device.get_device_address(range.buffer) + range.dst_offset,
+                        .src_address = staging_alloc.device_address + range.staging_offset,
+                        .word_count = static_cast<u32>(range.size / 4),
+                        .padding = {},
+                    };
+                }
+            }
+            cmd_list.set_pipeline(*scatter_pipeline);
+            cmd_list.push_constant(UploadScatterPush{
+                .commands = staging_alloc.device_address,
+                .command_count = static_cast<u32>(layout.scatter_count),
+            });
+            cmd_list.dispatch(static_cast<u32>((layout.scatter_count + DAXA_UPLOAD_SCATTER_WORKGROUP_SIZE - 1) / DAXA_UPLOAD_SCATTER_WORKGROUP_SIZE));
+            src_access = src_access | AccessConsts::COMPUTE_SHADER_WRITE;
+        }
+        return src_access;
+    }
+
+    UploadBatcher::UploadBatcher(UploadBatcherInfo a_info)
+        : info{std::move(a_info)}
+    {
+    }
+
+    void UploadBatcher::write(BufferId buffer, usize offset, void const * data, usize size)
+    {
+        if (size == 0)
+        {
+            return;
+        }
+        std::lock_guard const lock{this->mtx};
+        usize const data_offset = this->pending_data.size();
+        this->pending_data.resize(data_offset + size);
+        std::memcpy(this->pending_data.data() + data_offset, data, size);
+        this->pending_writes.push_back(PendingWrite{
+            .buffer = buffer,
+            .offset = offset,
+            .size = size,
+            .data_offset = data_offset,
+        });
+    }
+
+    auto UploadBatcher::record(CommandList & cmd_list, TransferMemoryPool & staging_memory, Access dst_access) -> bool
+    {
+        DAXA_TRACE_SCOPE("UploadBatcher::record");
+        std::vector<PendingWrite> writes = {};
+        std::vector<u8> data = {};
+        {
+            std::lock_guard const lock{this->mtx};
+            std::swap(writes, this->pending_writes);
+            std::swap(data, this->pending_data);
+        }
+        if (writes.empty())
+        {
+            return true;
+        }
+
+        // Writes are merged into ranges of touching or overlapping destination memory.
+        std::vector<usize> sorted_writes(writes.size());
+        for (usize i = 0; i < writes.size(); ++i)
+        {
+            sorted_writes[i] = i;
+        }
+        std::sort(sorted_writes.begin(), sorted_writes.end(), [&](usize a, usize b)
+                  { return std::pair{writes[a].buffer, writes[a].offset} < std::pair{writes[b].buffer, writes[b].offset}; });
+        std::vector<StagedRange> ranges = {};
+        std::vector<usize> write_range_indices(writes.size());
+        for (usize const write_index : sorted_writes)
+        {
+            PendingWrite const & write = writes[write_index];
+            bool const merges = !ranges.empty() &&
+                                ranges.back().buffer == write.buffer &&
+                                write.offset <= ranges.back().dst_offset + ranges.back().size;
+            if (merges)
+            {
+                StagedRange & range = ranges.back();
+                range.size = std::max(range.size, write.offset + write.size - range.dst_offset);
+            }
+            else
+            {
+                ranges.push_back(StagedRange{.buffer = write.buffer, .dst_offset = write.offset, .size = write.size});
+            }
+            write_range_indices[write_index] = ranges.size() - 1;
+        }
+
+        StagedRangesLayout const layout = layout_staged_ranges(ranges, this->info.scatter_pipeline != nullptr, this->info.scatter_max_size, this->info.scatter_min_count);
+        auto staging_alloc = staging_memory.allocate(layout.staging_size, alignof(UploadScatterCommand));
+        if (!staging_alloc.has_value())
+        {
+            // Put the writes back in front of writes that were made while recording.
+            std::lock_guard const lock{this->mtx};
+            usize const data_shift = data.size();
+            for (auto & write : this->pending_writes)
+            {
+                write.data_offset += data_shift;
+            }
+            writes.insert(writes.end(), this->pending_writes.begin(), this->pending_writes.end());
+            data.insert(data.end(), this->pending_data.begin(), this->pending_data.end());
+            std::swap(writes, this->pending_writes);
+            std::swap(data, this->pending_data);
+            return false;
+        }
+        u8 * staging_host_address = reinterpret_cast<u8 *>(staging_alloc->host_address);
+        // Copied in the order the writes were made, so later writes to overlapping memory win.
+        for (usize write_index = 0; write_index < writes.size(); ++write_index)
+        {
+            PendingWrite const & write = writes[write_index];
+            StagedRange const & range = ranges[write_range_indices[write_index]];
+            std::memcpy(staging_host_address + range.staging_offset + (write.offset - range.dst_offset), data.data() + write.data_offset, write.size);
+        }
+
+        // The destinations were last used with dst_access by earlier commands, those must finish before they are overwritten.
+        cmd_list.pipeline_barrier({
+            .src_access = dst_access,
+            .dst_access = AccessConsts::TRANSFER_WRITE | AccessConsts::COMPUTE_SHADER_WRITE,
+        });
+        Access const src_access = record_staged_ranges(cmd_list, this->info.device, this->info.scatter_pipeline.get(), staging_alloc.value(), ranges, layout);
+        cmd_list.pipeline_barrier({
+            .src_access = src_access,
+            .dst_access = dst_access,
+        });
+        return true;
+    }
+
+    auto UploadBatcher::pending_write_count() -> usize
+    {
+        std::lock_guard const lock{this->mtx};
+        return this->pending_writes.size();
+    }
+
+    auto UploadBatcher::get_info() const -> UploadBatcherInfo const &
+    {
+        return this->info;
+    }
+
+    // Sets or clears the bits of count chunks starting at first_chunk, returns how many bits changed.
+    static auto set_dirty_chunk_bits(std::vector<u64> & words, usize first_chunk, usize count, bool dirty) -> usize
+    {
+        usize changed = {};
+        usize const end_chunk = first_chunk + count;
+        for (usize chunk = first_chunk; chunk < end_chunk;)
+        {
+            usize const word = chunk / 64;
+            usize const bit = chunk % 64;
+            usize const bits = std::min<usize>(64 - bit, end_chunk - chunk);
+            u64 const mask = (bits == 64 ? ~u64{0} : ((u64{1} << bits) - 1)) << bit;
+            if (dirty)
+            {
+                changed += static_cast<usize>(std::popcount(mask & ~words[word]));
+                words[word] |= mask;
+            }
+            else
+            {
+                changed += static_cast<usize>(std::popcount(mask & words[word]));
+                words[word] &= ~mask;
+            }
+            chunk += bits;
+        }
+        return changed;
+    }
+
+    // Dirty chunk runs are split into ranges of at most this size, so that partial uploads can make progress with small staging pools.
+    static constexpr usize GPU_MIRROR_MAX_RANGE_SIZE = 1 << 20;
+
+    GpuMirrorBuffer::GpuMirrorBuffer(GpuMirrorBufferInfo a_info)
+        : info{std::move(a_info)},
+          buffer{this->info.device.create_buffer({
+              .size = this->info.size,
+              .name = std::string("GpuMirrorBuffer") + this->info.name,
+          })},
+          shadow_data(this->info.size)
+    {
+        DAXA_DBG_ASSERT_TRUE_M(this->info.dirty_granularity > 0, "dirty granularity must be greater than zero");
+        usize const chunk_count = (this->info.size + this->info.dirty_granularity - 1) / this->info.dirty_granularity;
+        this->dirty_chunks.resize((chunk_count + 63) / 64);
+        // The gpu buffer starts with undefined content, the zero initialized shadow copy is uploaded as a whole on the first update.
+        this->dirty_chunk_count = set_dirty_chunk_bits(this->dirty_chunks, 0, chunk_count, true);
+    }
+
+    GpuMirrorBuffer::GpuMirrorBuffer(GpuMirrorBuffer && other)
+    {
+        std::swap(this->info, other.info);
+        std::swap(this->buffer, other.buffer);
+        std::swap(this->shadow_data, other.shadow_data);
+        std::swap(this->dirty_chunks, other.dirty_chunks);
+        std::swap(this->dirty_chunk_count, other.dirty_chunk_count);
+    }
+
+    GpuMirrorBuffer & GpuMirrorBuffer::operator=(GpuMirrorBuffer && other)
+    {
+        if (!this->buffer.is_empty())
+        {
+            this->info.device.destroy_buffer(this->buffer);
+        }
+        std::swap(this->info, other.info);
+        std::swap(this->buffer, other.buffer);
+        std::swap(this->shadow_data, other.shadow_data);
+        std::swap(this->dirty_chunks, other.dirty_chunks);
+        std::swap(this->dirty_chunk_count, other.dirty_chunk_count);
+        return *this;
+    }
+
+    GpuMirrorBuffer::~GpuMirrorBuffer()
+    {
+        if (!this->buffer.is_empty())
+        {
+            this->info.device.destroy_buffer(this->buffer);
+        }
+    }
+
+    void GpuMirrorBuffer::write(usize offset, void const * data, usize size)
+    {
+        std::memcpy(this->write_ptr(offset, size), data, size);
+    }
+
+    auto GpuMirrorBuffer::write_ptr(usize offset, usize size) -> void *
+    {
+        this->mark_dirty(offset, size);
+        return this->shadow_data.data() + offset;
+    }
+
+    void GpuMirrorBuffer::mark_dirty(usize offset, usize size)
+    {
+        DAXA_DBG_ASSERT_TRUE_M(offset + size <= this->info.size, "range is out of bounds of the mirror buffer");
+        if (size == 0)
+        {
+            return;
+        }
+        usize const first_chunk = offset / this->info.dirty_granularity;
+        usize const last_chunk = (offset + size - 1) / this->info.dirty_granularity;
+        this->dirty_chunk_count += set_dirty_chunk_bits(this->dirty_chunks, first_chunk, last_chunk - first_chunk + 1, true);
+    }
+
+    auto GpuMirrorBuffer::record_updates(CommandList & cmd_list, TransferMemoryPool & staging_memory, Access dst_access) -> bool
+    {
+        DAXA_TRACE_SCOPE("GpuMirrorBuffer::record_updates");
+        if (this->dirty_chunk_count == 0)
+        {
+            return true;
+        }
+        usize const granularity = this->info.dirty_granularity;
+        usize const max_range_chunks = std::max<usize>(1, GPU_MIRROR_MAX_RANGE_SIZE / granularity);
+        std::vector<StagedRange> ranges = {};
+        for (usize word = 0; word < this->dirty_chunks.size(); ++word)
+        {
+            u64 bits = this->dirty_chunks[word];
+            while (bits != 0)
+            {
+                usize const chunk = word * 64 + static_cast<usize>(std::countr_zero(bits));
+                bits &= bits - 1;
+                bool const extends = !ranges.empty() &&
+                                     ranges.back().dst_offset + ranges.back().size == chunk * granularity &&
+                                     ranges.back().size < max_range_chunks * granularity;
+                usize const chunk_size = std::min(granularity, this->info.size - chunk * granularity);
+                if (extends)
+                {
+                    ranges.back().size += chunk_size;
+                }
+                else
+                {
+                    ranges.push_back(StagedRange{.buffer = this->buffer, .dst_offset = chunk * granularity, .size = chunk_size});
+                }
+            }
+        }
+
+        // When the staging memory can not fit all ranges, fewer ranges are uploaded this time.
+        usize range_count = ranges.size();
+        std::optional<TransferMemoryPool::Allocation> staging_alloc = {};
+        StagedRangesLayout layout = {};
+        while (range_count > 0)
+        {
+            layout = layout_staged_ranges(std::span{ranges.data(), range_count}, this->info.scatter_pipeline != nullptr, granularity, this->info.scatter_min_count);
+            staging_alloc = staging_memory.allocate(layout.staging_size, alignof(UploadScatterCommand));
+            if (staging_alloc.has_value())
+            {
+                break;
+            }
+            range_count /= 2;
+        }
+        if (!staging_alloc.has_value())
+        {
+            return false;
+        }
+        auto uploaded_ranges = std::span{ranges.data(), range_count};
+        u8 * staging_host_address = reinterpret_cast<u8 *>(staging_alloc->host_address);
+        for (auto const & range : uploaded_ranges)
+        {
+            std::memcpy(staging_host_address + range.staging_offset, this->shadow_data.data() + range.dst_offset, range.size);
+            usize const range_chunks = (range.size + granularity - 1) / granularity;
+            this->dirty_chunk_count -= set_dirty_chunk_bits(this->dirty_chunks, range.dst_offset / granularity, range_chunks, false);
+        }
+        // The buffer is read by earlier frames, those reads must finish before it is overwritten.
+        cmd_list.pipeline_barrier({
+            .src_access = AccessConsts::READ,
+            .dst_access = AccessConsts::TRANSFER_WRITE | AccessConsts::COMPUTE_SHADER_WRITE,
+        });
+        Access const src_access = record_staged_ranges(cmd_list, this->info.device, this->info.scatter_pipeline.get(), staging_alloc.value(), uploaded_ranges, layout);
+        cmd_list.pipeline_barrier({
+            .src_access = src_access,
+            .dst_access = dst_access,
+        });
+        return this->dirty_chunk_count == 0;
+    }
+
+    auto GpuMirrorBuffer::dirty_size() const -> usize
+    {
+        usize const granularity = this->info.dirty_granularity;
+        usize size = this->dirty_chunk_count * granularity;
+        // The last chunk may be smaller than the granularity.
+        usize const last_chunk = (this->info.size + granularity - 1) / granularity - 1;
+        if (this->info.size != 0 && (this->dirty_chunks[last_chunk / 64] & (u64{1} << (last_chunk % 64))) != 0)
+        {
+            size -= last_chunk * granularity + granularity - this->info.size;
+        }
+        return size;
+    }
+
+    auto GpuMirrorBuffer::shadow() const -> std::span<u8 const>
+    {
+        return std::span{this->shadow_data.data(), this->shadow_data.size()};
+    }
+
+    auto GpuMirrorBuffer::get_info() const -> GpuMirrorBufferInfo const &
+    {
+        return this->info;
+    }
+
+    auto GpuMirrorBuffer::get_buffer() const -> daxa::BufferId
+    {
+        return this->buffer;
+    }
 } // namespace daxa
 
 #endif
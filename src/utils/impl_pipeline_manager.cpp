@@ -124,49 +124,324 @@ static constexpr TBuiltInResource DAXA_DEFAULT_BUILTIN_RESOURCE = {
 };
 #endif
 
-#include <regex>
+#include <random>
+#include <string_view>
 #include <thread>
 #include <utility>
 
-static const std::regex PRAGMA_ONCE_REGEX = std::regex(R"regex(\s*#\s*pragma\s+once\s*)regex");
-static const std::regex REPLACE_REGEX = std::regex(R"regex(\W)regex");
+#if defined(__linux__)
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Returns true for lines that only contain `#pragma once`, with optional whitespace around the tokens.
+static auto is_pragma_once_line(std::string_view line) -> bool
+{
+    auto is_space = [](char c)
+    { return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f'; };
+    daxa::usize i = 0;
+    auto skip_spaces = [&]()
+    {
+        daxa::usize const start = i;
+        while (i < line.size() && is_space(line[i]))
+        {
+            ++i;
+        }
+        return i - start;
+    };
+    auto consume = [&](std::string_view token)
+    {
+        if (line.substr(i, token.size()) != token)
+        {
+            return false;
+        }
+        i += token.size();
+        return true;
+    };
+    skip_spaces();
+    if (!consume("#"))
+    {
+        return false;
+    }
+    skip_spaces();
+    if (!consume("pragma") || skip_spaces() == 0 || !consume("once"))
+    {
+        return false;
+    }
+    skip_spaces();
+    return i == line.size();
+}
+
+// Replaces `#pragma once` with an include guard named after the absolute path of the file, in a single pass over the source.
+// Files that already use classic include guards are left untouched.
 static void shader_preprocess(std::string & file_str, std::filesystem::path const & path)
 {
-    std::smatch matches = {};
-    std::string line = {};
-    std::stringstream file_ss{file_str};
-    std::stringstream result_ss = {};
-    bool has_pragma_once = false;
-    auto abs_path_str = path.string();
-    if (std::filesystem::exists(path))
+    // Most files have no `#pragma once` at all, they only need the trailing newline every line gets.
+    if (file_str.find("pragma") == std::string::npos)
     {
-        abs_path_str = std::filesystem::absolute(path).string();
+        if (!file_str.empty() && file_str.back() != '\n')
+        {
+            file_str += '\n';
+        }
+        return;
     }
-    while (std::getline(file_ss, line))
+    std::string guard_name = {};
+    auto build_guard_name = [&]()
     {
-        if (std::regex_match(line, matches, PRAGMA_ONCE_REGEX))
+        auto abs_path_str = path.string();
+        if (std::filesystem::exists(path))
+        {
+            abs_path_str = std::filesystem::absolute(path).string();
+        }
+        for (char const c : abs_path_str)
         {
-            result_ss << "#if !defined(";
-            std::regex_replace(std::ostreambuf_iterator<char>(result_ss), abs_path_str.begin(), abs_path_str.end(), REPLACE_REGEX, "");
-            result_ss << ")\n";
+            if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_')
+            {
+                guard_name += c;
+            }
+        }
+    };
+    std::string result = {};
+    result.reserve(file_str.size() + 64);
+    bool has_pragma_once = false;
+    daxa::usize line_begin = 0;
+    while (line_begin < file_str.size())
+    {
+        daxa::usize line_end = file_str.find('\n', line_begin);
+        if (line_end == std::string::npos)
+        {
+            line_end = file_str.size();
+        }
+        auto const line = std::string_view{file_str}.substr(line_begin, line_end - line_begin);
+        if (is_pragma_once_line(line))
+        {
+            if (!has_pragma_once)
+            {
+                build_guard_name();
+            }
+            result += "#if !defined(";
+            result += guard_name;
+            result += ")\n";
             has_pragma_once = true;
         }
         else
         {
-            result_ss << line << "\n";
+            result += line;
+            result += '\n';
         }
+        line_begin = line_end + 1;
     }
     if (has_pragma_once)
     {
-        result_ss << "\n#define ";
-        std::regex_replace(std::ostreambuf_iterator<char>(result_ss), abs_path_str.begin(), abs_path_str.end(), REPLACE_REGEX, "");
-        result_ss << "\n#endif\n";
+        result += "\n#define ";
+        result += guard_name;
+        result += "\n#endif\n";
     }
-    file_str = result_ss.str();
+    file_str = std::move(result);
 }
 
 namespace daxa
 {
+    static constexpr u32 SPIRV_CACHE_MAGIC = 0x44535043; // "DSPC"
+    // Must be increased whenever the way shaders are compiled changes without that being part of the cache key.
+    static constexpr u32 SPIRV_CACHE_VERSION = 2;
+
+    // The header is followed by the full key and the spirv words.
+    // The file name is only a hash of the key, so the stored key is compared on load to rule out collisions.
+    struct SpirvCacheFileHeader
+    {
+        u32 magic = SPIRV_CACHE_MAGIC;
+        u32 version = SPIRV_CACHE_VERSION;
+        u64 key_size = {};
+        u64 word_count = {};
+    };
+
+    static auto fnv1a_64(std::string_view str, u64 hash = 0xcbf29ce484222325ull) -> u64
+    {
+        for (char const c : str)
+        {
+            hash ^= static_cast<u8>(c);
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    static auto spirv_cache_file_path(std::filesystem::path const & cache_path, u64 key) -> std::filesystem::path
+    {
+        return cache_path / fmt::format("{:016x}.spv", key);
+    }
+
+    // Paths are compared lexically, so watched, observed and queried paths are all made absolute the same way.
+    static auto normalized_shader_path(std::filesystem::path const & path) -> std::filesystem::path
+    {
+        std::error_code error = {};
+        auto absolute_path = std::filesystem::absolute(path, error);
+        return (error ? path : absolute_path).lexically_normal();
+    }
+
+    // Watches the folders of shader files with inotify and records the files that were written.
+    // Folders are watched instead of files, as many editors save by writing a new file and renaming it over the old one.
+    struct ShaderFileWatcher
+    {
+#if defined(__linux__)
+        int inotify_fd = -1;
+        int stop_fd = -1;
+        std::thread thread = {};
+#endif
+        std::mutex mtx = {};
+        std::set<std::filesystem::path> watched_folder_paths = {};
+        std::unordered_map<int, std::filesystem::path> watched_folders = {};
+        std::set<std::filesystem::path> changed_files = {};
+        // Set when the kernel dropped events. The changed files are unknown then and all files need to be checked.
+        bool overflowed = false;
+        std::atomic<bool> has_changes = false;
+
+        ShaderFileWatcher()
+        {
+#if defined(__linux__)
+            this->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            this->stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (this->is_valid())
+            {
+                this->thread = std::thread{[this]()
+                                           { this->run(); }};
+            }
+#endif
+        }
+
+        ShaderFileWatcher(ShaderFileWatcher const &) = delete;
+        ShaderFileWatcher & operator=(ShaderFileWatcher const &) = delete;
+
+        ~ShaderFileWatcher()
+        {
+#if defined(__linux__)
+            if (this->thread.joinable())
+            {
+                u64 const stop = 1;
+                [[maybe_unused]] auto const written = write(this->stop_fd, &stop, sizeof(u64));
+                this->thread.join();
+            }
+            if (this->inotify_fd >= 0)
+            {
+                close(this->inotify_fd);
+            }
+            if (this->stop_fd >= 0)
+            {
+                close(this->stop_fd);
+            }
+#endif
+        }
+
+        [[nodiscard]] auto is_valid() const -> bool
+        {
+#if defined(__linux__)
+            return this->inotify_fd >= 0 && this->stop_fd >= 0;
+#else
+            return false;
+#endif
+        }
+
+        // Expects a path made by normalized_shader_path.
+        void watch_file(std::filesystem::path const & path)
+        {
+            auto folder = path.parent_path();
+            auto lock = std::lock_guard{this->mtx};
+            if (this->watched_folder_paths.contains(folder))
+            {
+                return;
+            }
+            this->watched_folder_paths.insert(folder);
+#if defined(__linux__)
+            int const watch_descriptor = inotify_add_watch(this->inotify_fd, folder.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+            if (watch_descriptor >= 0)
+            {
+                this->watched_folders[watch_descriptor] = std::move(folder);
+            }
+#endif
+        }
+
+        // Records a change the watcher itself could not see, because the file was written before its folder was watched.
+        void mark_changed(std::filesystem::path const & path)
+        {
+            auto lock = std::lock_guard{this->mtx};
+            this->changed_files.insert(path);
+            this->has_changes.store(true, std::memory_order_release);
+        }
+
+        // Returns the files changed since the last call, or nothing when events were lost.
+        auto take_changes() -> std::optional<std::set<std::filesystem::path>>
+        {
+            auto lock = std::lock_guard{this->mtx};
+            this->has_changes.store(false, std::memory_order_relaxed);
+            auto ret = std::optional<std::set<std::filesystem::path>>{std::move(this->changed_files)};
+            if (this->overflowed)
+            {
+                ret = std::nullopt;
+            }
+            this->changed_files = {};
+            this->overflowed = false;
+            return ret;
+        }
+
+#if defined(__linux__)
+        void run()
+        {
+            alignas(inotify_event) std::array<char, 4096> buffer = {};
+            auto poll_fds = std::array{
+                pollfd{.fd = this->inotify_fd, .events = POLLIN, .revents = 0},
+                pollfd{.fd = this->stop_fd, .events = POLLIN, .revents = 0},
+            };
+            while (true)
+            {
+                if (poll(poll_fds.data(), static_cast<nfds_t>(poll_fds.size()), -1) < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    return;
+                }
+                if ((poll_fds[1].revents & POLLIN) != 0)
+                {
+                    return;
+                }
+                if ((poll_fds[0].revents & POLLIN) == 0)
+                {
+                    continue;
+                }
+                isize const size = read(this->inotify_fd, buffer.data(), buffer.size());
+                if (size <= 0)
+                {
+                    continue;
+                }
+                auto lock = std::lock_guard{this->mtx};
+                for (isize offset = 0; offset < size;)
+                {
+                    inotify_event event = {};
+                    std::memcpy(&event, buffer.data() + offset, sizeof(inotify_event));
+                    char const * name = buffer.data() + offset + sizeof(inotify_event);
+                    offset += static_cast<isize>(sizeof(inotify_event) + event.len);
+                    if ((event.mask & IN_Q_OVERFLOW) != 0)
+                    {
+                        this->overflowed = true;
+                        continue;
+                    }
+                    auto folder_iter = this->watched_folders.find(event.wd);
+                    if (event.len == 0 || folder_iter == this->watched_folders.end())
+                    {
+                        continue;
+                    }
+                    this->changed_files.insert(folder_iter->second / name);
+                }
+                this->has_changes.store(true, std::memory_order_release);
+            }
+        }
+#endif
+    };
+
 #if DAXA_BUILT_WITH_UTILS_PIPELINE_MANAGER_GLSLANG
     class GlslangFileIncluder : public glslang::TShader::Includer
     {
@@ -176,19 +451,20 @@ namespace daxa
         constexpr static inline usize MAX_INCLUSION_DEPTH = 100;
 
         ImplPipelineManager * impl_pipeline_manager = nullptr;
+        ImplPipelineManager::ShaderCompileContext * context = nullptr;
 
         [[nodiscard]] auto process_include(daxa::Result<daxa::ShaderCode> const & shader_code_result, std::filesystem::path const & full_path) const -> IncludeResult *
         {
             auto search_pred = [&](std::filesystem::path const & p)
             { return p == full_path; };
             if (std::find_if(
-                    impl_pipeline_manager->current_seen_shader_files.begin(),
-                    impl_pipeline_manager->current_seen_shader_files.end(),
-                    search_pred) != impl_pipeline_manager->current_seen_shader_files.end())
+                    context->seen_shader_files.begin(),
+                    context->seen_shader_files.end(),
+                    search_pred) != context->seen_shader_files.end())
             {
                 return nullptr;
             }
-            impl_pipeline_manager->current_observed_hotload_files->insert({full_path, std::chrono::file_clock::now()});
+            context->observed_hotload_files.insert({full_path, std::chrono::file_clock::now()});
 
             std::string headerName = {};
             char const * headerData = nullptr;
@@ -229,17 +505,17 @@ namespace daxa
                 return nullptr;
             }
             auto header_name_str = std::string{header_name};
-            if (impl_pipeline_manager->virtual_files.contains(header_name_str))
+            if (context->virtual_files->contains(header_name_str))
             {
-                return process_include(Result{ShaderCode{impl_pipeline_manager->virtual_files.at(header_name_str).contents}}, header_name_str);
+                return process_include(Result{ShaderCode{context->virtual_files->at(header_name_str).contents}}, header_name_str);
             }
-            auto result = impl_pipeline_manager->full_path_to_file(includer_name);
+            auto result = impl_pipeline_manager->full_path_to_file(*context, includer_name);
             if (result.is_err())
             {
                 return nullptr;
             }
             auto full_path = result.value().parent_path() / header_name;
-            auto shader_code_result = impl_pipeline_manager->load_shader_source_from_file(full_path);
+            auto shader_code_result = impl_pipeline_manager->load_shader_source_from_file(*context, full_path);
             return process_include(shader_code_result, full_path);
         }
 
@@ -251,17 +527,17 @@ namespace daxa
                 return nullptr;
             }
             auto header_name_str = std::string{header_name};
-            if (impl_pipeline_manager->virtual_files.contains(header_name_str))
+            if (context->virtual_files->contains(header_name_str))
             {
-                return process_include(Result{ShaderCode{impl_pipeline_manager->virtual_files.at(header_name_str).contents}}, header_name_str);
+                return process_include(Result{ShaderCode{context->virtual_files->at(header_name_str).contents}}, header_name_str);
             }
-            auto result = impl_pipeline_manager->full_path_to_file(header_name);
+            auto result = impl_pipeline_manager->full_path_to_file(*context, header_name);
             if (result.is_err())
             {
                 return nullptr;
             }
             auto full_path = result.value();
-            auto shader_code_result = impl_pipeline_manager->load_shader_source_from_file(full_path);
+            auto shader_code_result = impl_pipeline_manager->load_shader_source_from_file(*context, full_path);
             return process_include(shader_code_result, full_path);
         }
 
@@ -283,6 +559,7 @@ namespace daxa
     {
         IDxcIncludeHandler * default_includer{};
         ImplPipelineManager * impl_pipeline_manager{};
+        ImplPipelineManager::ShaderCompileContext * context{};
 
         virtual ~DxcCustomIncluder() = default;
         auto LoadSource(LPCWSTR filename, IDxcBlob ** include_source) -> HRESULT override
@@ -293,12 +570,12 @@ namespace daxa
                 filename += 2;
             }
             auto header_name_str = std::filesystem::path{filename}.string();
-            if (impl_pipeline_manager->virtual_files.contains(header_name_str))
+            if (context->virtual_files->contains(header_name_str))
             {
                 auto search_pred = [&](std::filesystem::path const & p)
                 { return p == header_name_str; };
-                if (std::find_if(impl_pipeline_manager->current_seen_shader_files.begin(),
-                                 impl_pipeline_manager->current_seen_shader_files.end(), search_pred) != impl_pipeline_manager->current_seen_shader_files.end())
+                if (std::find_if(context->seen_shader_files.begin(),
+                                 context->seen_shader_files.end(), search_pred) != context->seen_shader_files.end())
                 {
                     // Return empty string blob if this file has been included before
                     static char const * const null_str = " ";
@@ -308,14 +585,14 @@ namespace daxa
                 }
                 else
                 {
-                    impl_pipeline_manager->current_observed_hotload_files->insert({header_name_str, std::chrono::file_clock::now()});
-                    auto & str = impl_pipeline_manager->virtual_files.at(header_name_str).contents;
+                    context->observed_hotload_files.insert({header_name_str, std::chrono::file_clock::now()});
+                    auto & str = context->virtual_files->at(header_name_str).contents;
                     impl_pipeline_manager->dxc_backend.dxc_utils->CreateBlob(str.c_str(), static_cast<u32>(str.size()), CP_UTF8, &dxc_blob_encoding);
                     *include_source = dxc_blob_encoding.Detach();
                     return S_OK;
                 }
             }
-            auto result = impl_pipeline_manager->full_path_to_file(filename);
+            auto result = impl_pipeline_manager->full_path_to_file(*context, filename);
             if (result.is_err())
             {
                 *include_source = nullptr;
@@ -324,8 +601,8 @@ namespace daxa
             auto full_path = result.value();
             auto search_pred = [&](std::filesystem::path const & p)
             { return p == full_path; };
-            if (std::find_if(impl_pipeline_manager->current_seen_shader_files.begin(),
-                             impl_pipeline_manager->current_seen_shader_files.end(), search_pred) != impl_pipeline_manager->current_seen_shader_files.end())
+            if (std::find_if(context->seen_shader_files.begin(),
+                             context->seen_shader_files.end(), search_pred) != context->seen_shader_files.end())
             {
                 // Return empty string blob if this file has been included before
                 static char const * const null_str = " ";
@@ -335,9 +612,9 @@ namespace daxa
             }
             else
             {
-                impl_pipeline_manager->current_observed_hotload_files->insert({full_path, std::chrono::file_clock::now()});
+                context->observed_hotload_files.insert({full_path, std::chrono::file_clock::now()});
             }
-            auto str_result = impl_pipeline_manager->load_shader_source_from_file(full_path);
+            auto str_result = impl_pipeline_manager->load_shader_source_from_file(*context, full_path);
             if (str_result.is_err())
             {
                 *include_source = nullptr;
@@ -403,6 +680,18 @@ namespace daxa
         return impl.add_raster_pipeline(info);
     }
 
+    auto PipelineManager::add_compute_pipelines(std::span<ComputePipelineCompileInfo const> infos) -> std::vector<Result<std::shared_ptr<ComputePipeline>>>
+    {
+        auto & impl = *reinterpret_cast<ImplPipelineManager *>(this->object);
+        return impl.add_compute_pipelines(infos);
+    }
+
+    auto PipelineManager::add_raster_pipelines(std::span<RasterPipelineCompileInfo const> infos) -> std::vector<Result<std::shared_ptr<RasterPipeline>>>
+    {
+        auto & impl = *reinterpret_cast<ImplPipelineManager *>(this->object);
+        return impl.add_raster_pipelines(infos);
+    }
+
     void PipelineManager::remove_compute_pipeline(std::shared_ptr<ComputePipeline> const & pipeline)
     {
         auto & impl = *reinterpret_cast<ImplPipelineManager *>(this->object);
@@ -427,6 +716,35 @@ namespace daxa
         return impl.reload_all();
     }
 
+    auto PipelineManager::apply_background_reloads() -> bool
+    {
+        auto & impl = *reinterpret_cast<ImplPipelineManager *>(this->object);
+        return impl.apply_background_reloads();
+    }
+
+    auto PipelineManager::pop_reload_errors() -> std::vector<PipelineReloadError>
+    {
+        auto & impl = *reinterpret_cast<ImplPipelineManager *>(this->object);
+        return impl.pop_reload_errors();
+    }
+
+    auto PipelineManager::pipelines_depending_on(std::filesystem::path const & file) -> PipelineDependents
+    {
+        auto & impl = *reinterpret_cast<ImplPipelineManager *>(this->object);
+        return impl.pipelines_depending_on(file);
+    }
+
+    auto PipelineManager::spirv_cache_hit_count() -> u64
+    {
+        auto & impl = *reinterpret_cast<ImplPipelineManager *>(this->object);
+        return impl.spirv_cache_hits.load(std::memory_order_relaxed);
+    }
+
+    void preprocess_shader_source(std::string & source, std::filesystem::path const & path)
+    {
+        shader_preprocess(source, path);
+    }
+
     static std::mutex glslang_init_mtx;
     static i32 pipeline_manager_count = 0;
 
@@ -447,6 +765,23 @@ namespace daxa
         {
             this->info.shader_compile_options.enable_debug_info = {false};
         }
+#if DAXA_THREADSAFETY
+        if (this->info.compile_thread_count == 0)
+        {
+            this->info.compile_thread_count = std::max(1u, std::thread::hardware_concurrency());
+        }
+#else
+        // Pipeline creation on the device is not thread-safe without DAXA_THREADSAFETY.
+        this->info.compile_thread_count = 1;
+#endif
+        if (this->info.enable_file_watcher)
+        {
+            this->file_watcher = std::make_unique<ShaderFileWatcher>();
+            if (!this->file_watcher->is_valid())
+            {
+                this->file_watcher.reset();
+            }
+        }
 
 #if DAXA_BUILT_WITH_UTILS_PIPELINE_MANAGER_GLSLANG
         {
@@ -471,10 +806,28 @@ namespace daxa
             this->dxc_backend.dxc_utils->CreateDefaultIncludeHandler(&dynamic_cast<DxcCustomIncluder &>(*this->dxc_backend.dxc_includer).default_includer);
         }
 #endif
+
+#if DAXA_THREADSAFETY
+        // Started last, as it compiles with the backends initialized above.
+        if (this->info.enable_background_reload)
+        {
+            this->background_reload_thread = std::thread{[this]()
+                                                         { this->background_reload_loop(); }};
+        }
+#endif
     }
 
     ImplPipelineManager::~ImplPipelineManager()
     {
+        if (this->background_reload_thread.joinable())
+        {
+            {
+                auto lock = std::lock_guard{this->background_reload_mtx};
+                this->background_reload_stop = true;
+            }
+            this->background_reload_cv.notify_all();
+            this->background_reload_thread.join();
+        }
 #if DAXA_BUILT_WITH_UTILS_PIPELINE_MANAGER_GLSLANG
         {
             auto lock = std::lock_guard{glslang_init_mtx};
@@ -487,7 +840,7 @@ namespace daxa
 #endif
     }
 
-    auto ImplPipelineManager::create_compute_pipeline(ComputePipelineCompileInfo const & a_info) -> Result<ComputePipelineState>
+    auto ImplPipelineManager::create_compute_pipeline(ComputePipelineCompileInfo const & a_info, VirtualFileSet const & virtual_file_set) -> Result<ComputePipelineState>
     {
         auto modified_info = a_info;
         modified_info.shader_info.compile_options.inherit(this->info.shader_compile_options);
@@ -502,11 +855,11 @@ namespace daxa
         auto pipe_result = ComputePipelineState{
             .pipeline_ptr = std::make_shared<ComputePipeline>(),
             .info = modified_info,
-            .last_hotload_time = std::chrono::file_clock::now(),
             .observed_hotload_files = {},
         };
-        this->current_observed_hotload_files = &pipe_result.observed_hotload_files;
-        auto spirv_result = get_spirv(pipe_result.info.shader_info, pipe_result.info.name, ShaderStage::COMP);
+        auto context = ShaderCompileContext{.virtual_files = &virtual_file_set};
+        auto spirv_result = get_spirv(context, pipe_result.info.shader_info, pipe_result.info.name, ShaderStage::COMP);
+        pipe_result.observed_hotload_files = std::move(context.observed_hotload_files);
         if (spirv_result.is_err())
         {
             if (this->info.register_null_pipelines_when_first_compile_fails)
@@ -524,6 +877,7 @@ namespace daxa
             .shader_info = {
                 .byte_code = spirv_result.value(),
                 .entry_point = a_info.shader_info.compile_options.entry_point,
+                .specialization_constants = a_info.shader_info.specialization_constants,
             },
             .push_constant_size = modified_info.push_constant_size,
             .name = modified_info.name,
@@ -531,7 +885,7 @@ namespace daxa
         return Result<ComputePipelineState>(std::move(pipe_result));
     }
 
-    auto ImplPipelineManager::create_raster_pipeline(RasterPipelineCompileInfo const & a_info) -> Result<RasterPipelineState>
+    auto ImplPipelineManager::create_raster_pipeline(RasterPipelineCompileInfo const & a_info, VirtualFileSet const & virtual_file_set) -> Result<RasterPipelineState>
     {
         auto modified_info = a_info;
         auto const modified_shader_compile_infos = std::array<std::optional<ShaderCompileInfo> *, 6>{
@@ -560,15 +914,14 @@ namespace daxa
         auto pipe_result = RasterPipelineState{
             .pipeline_ptr = std::make_shared<RasterPipeline>(),
             .info = modified_info,
-            .last_hotload_time = std::chrono::file_clock::now(),
             .observed_hotload_files = {},
         };
-        this->current_observed_hotload_files = &pipe_result.observed_hotload_files;
         auto raster_pipeline_info = RasterPipelineInfo{
             .color_attachments = modified_info.color_attachments,
             .depth_test = modified_info.depth_test,
             .raster = modified_info.raster,
             .tesselation = modified_info.tesselation,
+            .dynamic_state = modified_info.dynamic_state,
             .push_constant_size = modified_info.push_constant_size,
             .name = modified_info.name,
         };
@@ -591,7 +944,9 @@ namespace daxa
         {
             if (pipe_result_shader_info->has_value())
             {
-                *spv_result = get_spirv(pipe_result_shader_info->value(), pipe_result.info.name, stage);
+                auto context = ShaderCompileContext{.virtual_files = &virtual_file_set};
+                *spv_result = get_spirv(context, pipe_result_shader_info->value(), pipe_result.info.name, stage);
+                pipe_result.observed_hotload_files.insert(context.observed_hotload_files.begin(), context.observed_hotload_files.end());
                 if (spv_result->is_err())
                 {
                     if (this->info.register_null_pipelines_when_first_compile_fails)
@@ -608,6 +963,7 @@ namespace daxa
                 *final_shader_info = daxa::ShaderInfo{
                     .byte_code = spv_result->value(),
                     .entry_point = pipe_result_shader_info->value().compile_options.entry_point,
+                    .specialization_constants = pipe_result_shader_info->value().specialization_constants,
                 };
             }
         }
@@ -615,15 +971,17 @@ namespace daxa
         return Result<RasterPipelineState>(std::move(pipe_result));
     }
 
-    auto ImplPipelineManager::add_compute_pipeline(ComputePipelineCompileInfo const & a_info) -> Result<std::shared_ptr<ComputePipeline>>
+    auto ImplPipelineManager::register_compute_pipeline(Result<ComputePipelineState> && pipe_result) -> Result<std::shared_ptr<ComputePipeline>>
     {
-        DAXA_DBG_ASSERT_TRUE_M(!std::holds_alternative<std::monostate>(a_info.shader_info.source), "must provide shader source");
-        auto pipe_result = create_compute_pipeline(a_info);
         if (pipe_result.is_err())
         {
             return Result<std::shared_ptr<ComputePipeline>>(pipe_result.m);
         }
-        this->compute_pipelines.push_back(pipe_result.value());
+        {
+            auto lock = std::lock_guard{this->state_mtx};
+            this->compute_pipelines.push_back(pipe_result.value());
+            this->add_pipeline_dependencies(this->compute_pipelines.back());
+        }
         if (this->info.register_null_pipelines_when_first_compile_fails)
         {
             auto result = Result<std::shared_ptr<ComputePipeline>>(std::move(pipe_result.value().pipeline_ptr));
@@ -636,14 +994,17 @@ namespace daxa
         }
     }
 
-    auto ImplPipelineManager::add_raster_pipeline(RasterPipelineCompileInfo const & a_info) -> Result<std::shared_ptr<RasterPipeline>>
+    auto ImplPipelineManager::register_raster_pipeline(Result<RasterPipelineState> && pipe_result) -> Result<std::shared_ptr<RasterPipeline>>
     {
-        auto pipe_result = create_raster_pipeline(a_info);
         if (pipe_result.is_err())
         {
             return Result<std::shared_ptr<RasterPipeline>>(pipe_result.m);
         }
-        this->raster_pipelines.push_back(pipe_result.value());
+        {
+            auto lock = std::lock_guard{this->state_mtx};
+            this->raster_pipelines.push_back(pipe_result.value());
+            this->add_pipeline_dependencies(this->raster_pipelines.back());
+        }
         if (this->info.register_null_pipelines_when_first_compile_fails)
         {
             auto result = Result<std::shared_ptr<RasterPipeline>>(std::move(pipe_result.value().pipeline_ptr));
@@ -656,8 +1017,87 @@ namespace daxa
         }
     }
 
+    auto ImplPipelineManager::add_compute_pipeline(ComputePipelineCompileInfo const & a_info) -> Result<std::shared_ptr<ComputePipeline>>
+    {
+        DAXA_DBG_ASSERT_TRUE_M(!std::holds_alternative<std::monostate>(a_info.shader_info.source), "must provide shader source");
+        return register_compute_pipeline(create_compute_pipeline(a_info, this->virtual_files));
+    }
+
+    auto ImplPipelineManager::add_raster_pipeline(RasterPipelineCompileInfo const & a_info) -> Result<std::shared_ptr<RasterPipeline>>
+    {
+        return register_raster_pipeline(create_raster_pipeline(a_info, this->virtual_files));
+    }
+
+    auto ImplPipelineManager::add_compute_pipelines(std::span<ComputePipelineCompileInfo const> infos) -> std::vector<Result<std::shared_ptr<ComputePipeline>>>
+    {
+        DAXA_TRACE_SCOPE("PipelineManager::add_compute_pipelines");
+        for (auto const & a_info : infos)
+        {
+            DAXA_DBG_ASSERT_TRUE_M(!std::holds_alternative<std::monostate>(a_info.shader_info.source), "must provide shader source");
+        }
+        auto pipe_results = std::vector<Result<ComputePipelineState>>(infos.size(), Result<ComputePipelineState>(std::string_view{"pipeline was not compiled"}));
+        run_compile_jobs(infos.size(), [&](usize index)
+                         { pipe_results[index] = create_compute_pipeline(infos[index], this->virtual_files); });
+        // Registering happens on the calling thread in the order of the infos, so the result order does not depend on the thread timing.
+        auto ret = std::vector<Result<std::shared_ptr<ComputePipeline>>>{};
+        ret.reserve(infos.size());
+        for (auto & pipe_result : pipe_results)
+        {
+            ret.push_back(register_compute_pipeline(std::move(pipe_result)));
+        }
+        return ret;
+    }
+
+    auto ImplPipelineManager::add_raster_pipelines(std::span<RasterPipelineCompileInfo const> infos) -> std::vector<Result<std::shared_ptr<RasterPipeline>>>
+    {
+        DAXA_TRACE_SCOPE("PipelineManager::add_raster_pipelines");
+        auto pipe_results = std::vector<Result<RasterPipelineState>>(infos.size(), Result<RasterPipelineState>(std::string_view{"pipeline was not compiled"}));
+        run_compile_jobs(infos.size(), [&](usize index)
+                         { pipe_results[index] = create_raster_pipeline(infos[index], this->virtual_files); });
+        auto ret = std::vector<Result<std::shared_ptr<RasterPipeline>>>{};
+        ret.reserve(infos.size());
+        for (auto & pipe_result : pipe_results)
+        {
+            ret.push_back(register_raster_pipeline(std::move(pipe_result)));
+        }
+        return ret;
+    }
+
+    void ImplPipelineManager::run_compile_jobs(usize job_count, std::function<void(usize)> const & job)
+    {
+        usize const thread_count = std::min(job_count, static_cast<usize>(this->info.compile_thread_count));
+        if (thread_count <= 1)
+        {
+            for (usize index = 0; index < job_count; ++index)
+            {
+                job(index);
+            }
+            return;
+        }
+        auto next_job = std::atomic<usize>{0};
+        auto worker = [&]()
+        {
+            for (usize index = next_job.fetch_add(1); index < job_count; index = next_job.fetch_add(1))
+            {
+                job(index);
+            }
+        };
+        auto threads = std::vector<std::thread>{};
+        threads.reserve(thread_count - 1);
+        for (usize i = 1; i < thread_count; ++i)
+        {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto & thread : threads)
+        {
+            thread.join();
+        }
+    }
+
     void ImplPipelineManager::remove_compute_pipeline(std::shared_ptr<ComputePipeline> const & pipeline)
     {
+        auto lock = std::lock_guard{this->state_mtx};
         auto pipeline_iter = std::find_if(
             this->compute_pipelines.begin(),
             this->compute_pipelines.end(),
@@ -669,11 +1109,13 @@ namespace daxa
         {
             return;
         }
+        this->remove_pipeline_dependencies(*pipeline_iter);
         this->compute_pipelines.erase(pipeline_iter);
     }
 
     void ImplPipelineManager::remove_raster_pipeline(std::shared_ptr<RasterPipeline> const & pipeline)
     {
+        auto lock = std::lock_guard{this->state_mtx};
         auto pipeline_iter = std::find_if(
             this->raster_pipelines.begin(),
             this->raster_pipelines.end(),
@@ -685,153 +1127,473 @@ namespace daxa
         {
             return;
         }
+        this->remove_pipeline_dependencies(*pipeline_iter);
         this->raster_pipelines.erase(pipeline_iter);
     }
 
-    using FileWriteTimeLookupTable = std::unordered_map<std::string, std::filesystem::file_time_type>;
+    void ImplPipelineManager::add_virtual_file(VirtualFileInfo const & virtual_info)
+    {
+        auto contents = virtual_info.contents;
+        shader_preprocess(contents, virtual_info.name);
+        auto lock = std::lock_guard{this->state_mtx};
+        virtual_files[virtual_info.name] = VirtualFileState{
+            .contents = std::move(contents),
+            .timestamp = std::chrono::file_clock::now(),
+        };
+        if (this->file_watcher != nullptr)
+        {
+            this->changed_virtual_files.insert(virtual_info.name);
+        }
+    }
 
-    static auto check_if_sources_changed(std::chrono::file_clock::time_point & last_hotload_time, ShaderFileTimeSet & observed_hotload_files, VirtualFileSet & virtual_files, FileWriteTimeLookupTable & lookup_table) -> bool
+    auto ImplPipelineManager::dependency_key(std::filesystem::path const & path) const -> std::filesystem::path
     {
-        using namespace std::chrono_literals;
-        static constexpr auto HOTRELOAD_MIN_TIME = 250ms;
+        if (this->virtual_files.contains(path.string()))
+        {
+            return path;
+        }
+        return normalized_shader_path(path);
+    }
+
+    template <typename PipeT, typename InfoT>
+    void ImplPipelineManager::add_pipeline_dependencies(PipelineState<PipeT, InfoT> const & pipeline_state)
+    {
+        for (auto const & [path, write_time] : pipeline_state.observed_hotload_files)
+        {
+            auto key = this->dependency_key(path);
+            auto [node_iter, inserted] = this->dependency_graph.try_emplace(key, DependencyNode{.path = path, .recorded_write_time = write_time});
+            auto & node = node_iter->second;
+            // The oldest observed write time is kept, so a file changed between two compilations reloads the older pipeline too.
+            node.recorded_write_time = std::min(node.recorded_write_time, write_time);
+            node.dependents<PipeT>().insert(pipeline_state.pipeline_ptr.get());
+            if (this->file_watcher != nullptr && !this->virtual_files.contains(path.string()))
+            {
+                this->file_watcher->watch_file(key);
+                // The file was read before its folder was watched, a write in between is only visible in its write time.
+                std::error_code error = {};
+                auto const latest_write_time = std::filesystem::last_write_time(path, error);
+                if (!error && latest_write_time > write_time)
+                {
+                    this->file_watcher->mark_changed(key);
+                }
+            }
+        }
+    }
+
+    template <typename PipeT, typename InfoT>
+    void ImplPipelineManager::remove_pipeline_dependencies(PipelineState<PipeT, InfoT> const & pipeline_state)
+    {
+        for (auto const & [path, write_time] : pipeline_state.observed_hotload_files)
+        {
+            auto node_iter = this->dependency_graph.find(this->dependency_key(path));
+            if (node_iter == this->dependency_graph.end())
+            {
+                continue;
+            }
+            node_iter->second.dependents<PipeT>().erase(pipeline_state.pipeline_ptr.get());
+            if (node_iter->second.compute_pipelines.empty() && node_iter->second.raster_pipelines.empty())
+            {
+                this->dependency_graph.erase(node_iter);
+            }
+        }
+    }
 
-        auto now = std::chrono::file_clock::now();
+    auto ImplPipelineManager::pipelines_depending_on(std::filesystem::path const & file) -> PipelineDependents
+    {
+        auto lock = std::lock_guard{this->state_mtx};
+        auto ret = PipelineDependents{};
+        auto key = std::filesystem::path{};
+        if (this->virtual_files.contains(file.string()))
+        {
+            key = file;
+        }
+        else
+        {
+            auto full_path = this->full_path_to_file(ShaderCompileContext{}, file);
+            key = normalized_shader_path(full_path.is_ok() ? full_path.value() : file);
+        }
+        auto node_iter = this->dependency_graph.find(key);
+        if (node_iter == this->dependency_graph.end())
+        {
+            return ret;
+        }
+        // Returned in the order the pipelines were added.
+        for (auto const & pipeline_state : this->compute_pipelines)
+        {
+            if (node_iter->second.compute_pipelines.contains(pipeline_state.pipeline_ptr.get()))
+            {
+                ret.compute_pipelines.push_back(pipeline_state.pipeline_ptr);
+            }
+        }
+        for (auto const & pipeline_state : this->raster_pipelines)
+        {
+            if (node_iter->second.raster_pipelines.contains(pipeline_state.pipeline_ptr.get()))
+            {
+                ret.raster_pipelines.push_back(pipeline_state.pipeline_ptr);
+            }
+        }
+        return ret;
+    }
+
+    auto ImplPipelineManager::take_polled_files() -> std::vector<PolledFile>
+    {
+        auto ret = std::vector<PolledFile>{};
+        if (this->file_watcher != nullptr)
+        {
+            return ret;
+        }
         using namespace std::chrono_literals;
-        if (now - last_hotload_time < HOTRELOAD_MIN_TIME)
+        static constexpr auto HOTRELOAD_MIN_TIME = 250ms;
+        auto const now = std::chrono::file_clock::now();
+        if (now - this->last_hotload_time < HOTRELOAD_MIN_TIME)
         {
-            return false;
+            return ret;
         }
-        last_hotload_time = now;
-        bool reload = false;
+        this->last_hotload_time = now;
+        // Every file is checked once, no matter how many pipelines include it.
+        ret.reserve(this->dependency_graph.size());
+        for (auto const & [key, node] : this->dependency_graph)
+        {
+            auto polled_file = PolledFile{.key = key, .path = node.path};
+            if (auto virtual_iter = this->virtual_files.find(key.string()); virtual_iter != this->virtual_files.end())
+            {
+                polled_file.is_virtual = true;
+                polled_file.latest_write_time = virtual_iter->second.timestamp;
+            }
+            ret.push_back(std::move(polled_file));
+        }
+        return ret;
+    }
 
-        auto get_last_file_write_time = [&](std::filesystem::path const & path)
+    void ImplPipelineManager::poll_write_times(std::vector<PolledFile> & polled_files)
+    {
+        for (auto & polled_file : polled_files)
         {
-            auto full_path_str = std::filesystem::absolute(path).string();
-            auto iter = lookup_table.find(full_path_str);
-            if (iter != lookup_table.end())
+            if (polled_file.is_virtual)
             {
-                return iter->second;
+                continue;
             }
-            else
+            std::error_code error = {};
+            auto const latest_write_time = std::filesystem::last_write_time(polled_file.path, error);
+            if (!error)
             {
-                auto latest_write_time = std::filesystem::last_write_time(path);
-                lookup_table[full_path_str] = latest_write_time;
-                return latest_write_time;
+                polled_file.latest_write_time = latest_write_time;
             }
-        };
+        }
+    }
 
-        for (auto & [path, recorded_write_time] : observed_hotload_files)
+    auto ImplPipelineManager::find_changed_pipelines(std::vector<PolledFile> const & polled_files) -> ChangedPipelines
+    {
+        auto changed_compute_pipelines = std::set<ComputePipeline const *>{};
+        auto changed_raster_pipelines = std::set<RasterPipeline const *>{};
+        auto collect_dependents = [&](DependencyNode const & node)
+        {
+            changed_compute_pipelines.insert(node.compute_pipelines.begin(), node.compute_pipelines.end());
+            changed_raster_pipelines.insert(node.raster_pipelines.begin(), node.raster_pipelines.end());
+        };
+        if (this->file_watcher != nullptr)
         {
-            auto path_str = path.string();
-            if (virtual_files.contains(path_str))
+            if (!this->file_watcher->has_changes.load(std::memory_order_acquire) && this->changed_virtual_files.empty())
             {
-                auto latest_write_time = virtual_files[path_str].timestamp;
-                if (latest_write_time > recorded_write_time)
+                return {};
+            }
+            for (auto const & path : this->file_watcher->take_changes())
+            {
+                if (auto node_iter = this->dependency_graph.find(path); node_iter != this->dependency_graph.end())
                 {
-                    reload = true;
+                    collect_dependents(node_iter->second);
                 }
             }
-            else if (std::ifstream(path).good())
+            for (auto const & name : this->changed_virtual_files)
             {
-                auto latest_write_time = get_last_file_write_time(path);
-                if (latest_write_time > recorded_write_time)
+                if (auto node_iter = this->dependency_graph.find(name); node_iter != this->dependency_graph.end())
                 {
-                    reload = true;
+                    collect_dependents(node_iter->second);
                 }
             }
         }
-        if (reload)
+        else
         {
-            for (auto & pair : observed_hotload_files)
+            // The graph may have changed while the write times were polled, files no longer depended on are skipped.
+            for (auto const & polled_file : polled_files)
             {
-                auto path_str = pair.first.string();
-                if (virtual_files.contains(path_str))
+                auto node_iter = this->dependency_graph.find(polled_file.key);
+                if (node_iter == this->dependency_graph.end() || !polled_file.latest_write_time.has_value())
                 {
-                    pair.second = virtual_files[path_str].timestamp;
+                    continue;
                 }
-                else if (std::ifstream(pair.first).good())
+                auto & node = node_iter->second;
+                if (polled_file.latest_write_time.value() > node.recorded_write_time)
                 {
-                    pair.second = get_last_file_write_time(pair.first);
+                    node.recorded_write_time = polled_file.latest_write_time.value();
+                    collect_dependents(node);
                 }
             }
         }
-        return reload;
-    };
+        this->changed_virtual_files.clear();
+        auto ret = ChangedPipelines{};
+        for (usize index = 0; index < this->compute_pipelines.size(); ++index)
+        {
+            if (changed_compute_pipelines.contains(this->compute_pipelines[index].pipeline_ptr.get()))
+            {
+                ret.compute_indices.push_back(index);
+            }
+        }
+        for (usize index = 0; index < this->raster_pipelines.size(); ++index)
+        {
+            if (changed_raster_pipelines.contains(this->raster_pipelines[index].pipeline_ptr.get()))
+            {
+                ret.raster_indices.push_back(index);
+            }
+        }
+        return ret;
+    }
 
-    void ImplPipelineManager::add_virtual_file(VirtualFileInfo const & virtual_info)
+    template <typename PipeT, typename InfoT>
+    auto ImplPipelineManager::apply_reloaded_pipeline(PipelineState<PipeT, InfoT> & pipeline_state, Result<PipelineState<PipeT, InfoT>> & new_pipeline) -> bool
     {
-        virtual_files[virtual_info.name] = VirtualFileState{
-            .contents = virtual_info.contents,
-            .timestamp = std::chrono::file_clock::now(),
-        };
-        auto & virtual_file = virtual_files.at(virtual_info.name);
-        shader_preprocess(virtual_file.contents, virtual_info.name);
+        // With register_null_pipelines_when_first_compile_fails, failed compilations still return a null pipeline.
+        if (new_pipeline.is_err() || !new_pipeline.value().pipeline_ptr->is_valid())
+        {
+            return false;
+        }
+        *pipeline_state.pipeline_ptr = std::move(*new_pipeline.value().pipeline_ptr);
+        // The new sources may include different files than before.
+        this->remove_pipeline_dependencies(pipeline_state);
+        pipeline_state.observed_hotload_files = std::move(new_pipeline.value().observed_hotload_files);
+        this->add_pipeline_dependencies(pipeline_state);
+        return true;
     }
 
     auto ImplPipelineManager::reload_all() -> PipelineReloadResult
     {
-        bool reloaded = false;
-
-        // Optimization for caching the write times so that multiple pipelines don't check the
-        // filesystem for the same file's write-time. Filesystem checks are really slow...
-        auto lookup_table = FileWriteTimeLookupTable{};
-
-        for (auto & [pipeline, compile_info, last_hotload_time, observed_hotload_files] : this->compute_pipelines)
-        {
-            if (check_if_sources_changed(last_hotload_time, observed_hotload_files, virtual_files, lookup_table))
+        DAXA_TRACE_SCOPE("PipelineManager::reload_all");
+        DAXA_DBG_ASSERT_TRUE_M(!this->background_reload_thread.joinable(), "reload_all must not be called with background reload enabled, call apply_background_reloads instead");
+
+        auto polled_files = this->take_polled_files();
+        poll_write_times(polled_files);
+        auto const changed = this->find_changed_pipelines(polled_files);
+        auto const & compute_reload_indices = changed.compute_indices;
+        auto const & raster_reload_indices = changed.raster_indices;
+        bool const reloaded = !compute_reload_indices.empty() || !raster_reload_indices.empty();
+
+        auto new_compute_pipelines = std::vector<Result<ComputePipelineState>>(compute_reload_indices.size(), Result<ComputePipelineState>(std::string_view{"pipeline was not compiled"}));
+        auto new_raster_pipelines = std::vector<Result<RasterPipelineState>>(raster_reload_indices.size(), Result<RasterPipelineState>(std::string_view{"pipeline was not compiled"}));
+        run_compile_jobs(
+            compute_reload_indices.size() + raster_reload_indices.size(),
+            [&](usize job_index)
             {
-                reloaded = true;
-                auto new_pipeline = create_compute_pipeline(compile_info);
-                bool is_valid = true;
-                if (this->info.register_null_pipelines_when_first_compile_fails)
-                {
-                    is_valid = new_pipeline.is_ok() && new_pipeline.value().pipeline_ptr->is_valid();
-                }
-                else
-                {
-                    is_valid = new_pipeline.is_ok();
-                }
-                if (is_valid)
+                if (job_index < compute_reload_indices.size())
                 {
-                    *pipeline = std::move(*new_pipeline.value().pipeline_ptr);
+                    new_compute_pipelines[job_index] = create_compute_pipeline(this->compute_pipelines[compute_reload_indices[job_index]].info, this->virtual_files);
                 }
                 else
                 {
-                    return PipelineReloadError{new_pipeline.m};
+                    usize const raster_index = job_index - compute_reload_indices.size();
+                    new_raster_pipelines[raster_index] = create_raster_pipeline(this->raster_pipelines[raster_reload_indices[raster_index]].info, this->virtual_files);
                 }
+            });
+
+        // Results are applied in pipeline order, so the reported errors do not depend on the thread timing.
+        std::string error_messages = {};
+        auto append_error = [&](std::string const & message)
+        {
+            if (!error_messages.empty())
+            {
+                error_messages += "\n";
+            }
+            error_messages += message;
+        };
+        for (usize job_index = 0; job_index < compute_reload_indices.size(); ++job_index)
+        {
+            auto & new_pipeline = new_compute_pipelines[job_index];
+            if (!this->apply_reloaded_pipeline(this->compute_pipelines[compute_reload_indices[job_index]], new_pipeline))
+            {
+                append_error(new_pipeline.m);
             }
         }
+        for (usize job_index = 0; job_index < raster_reload_indices.size(); ++job_index)
+        {
+            auto & new_pipeline = new_raster_pipelines[job_index];
+            if (!this->apply_reloaded_pipeline(this->raster_pipelines[raster_reload_indices[job_index]], new_pipeline))
+            {
+                append_error(new_pipeline.m);
+            }
+        }
+        if (!error_messages.empty())
+        {
+            return PipelineReloadError{error_messages};
+        }
 
-        for (auto & [pipeline, compile_info, last_hotload_time, observed_hotload_files] : this->raster_pipelines)
+        if (reloaded)
         {
-            if (check_if_sources_changed(last_hotload_time, observed_hotload_files, virtual_files, lookup_table))
+            return PipelineReloadSuccess{};
+        }
+        else
+        {
+            return NoPipelineChanged{};
+        }
+    }
+
+    void ImplPipelineManager::background_reload_loop()
+    {
+        auto lock = std::unique_lock{this->background_reload_mtx};
+        while (true)
+        {
+            this->background_reload_cv.wait_for(lock, this->info.background_reload_interval, [this]()
+                                                { return this->background_reload_stop; });
+            if (this->background_reload_stop)
             {
-                reloaded = true;
-                auto new_pipeline = create_raster_pipeline(compile_info);
-                if (new_pipeline.is_ok())
+                return;
+            }
+            lock.unlock();
+            this->background_reload();
+            lock.lock();
+        }
+    }
+
+    void ImplPipelineManager::background_reload()
+    {
+        DAXA_TRACE_SCOPE("PipelineManager::background_reload");
+        auto compute_jobs = std::vector<ComputePipelineState>{};
+        auto raster_jobs = std::vector<RasterPipelineState>{};
+        auto virtual_files_snapshot = VirtualFileSet{};
+        // Polling touches every observed file, the calling thread must not wait for that on state_mtx.
+        auto polled_files = std::vector<PolledFile>{};
+        {
+            auto lock = std::lock_guard{this->state_mtx};
+            polled_files = this->take_polled_files();
+        }
+        poll_write_times(polled_files);
+        {
+            auto lock = std::lock_guard{this->state_mtx};
+            auto const changed = this->find_changed_pipelines(polled_files);
+            if (changed.compute_indices.empty() && changed.raster_indices.empty())
+            {
+                return;
+            }
+            for (usize const index : changed.compute_indices)
+            {
+                compute_jobs.push_back(this->compute_pipelines[index]);
+            }
+            for (usize const index : changed.raster_indices)
+            {
+                raster_jobs.push_back(this->raster_pipelines[index]);
+            }
+            // The calling thread may add virtual files while the jobs compile.
+            virtual_files_snapshot = this->virtual_files;
+        }
+
+        auto new_compute_pipelines = std::vector<Result<ComputePipelineState>>(compute_jobs.size(), Result<ComputePipelineState>(std::string_view{"pipeline was not compiled"}));
+        auto new_raster_pipelines = std::vector<Result<RasterPipelineState>>(raster_jobs.size(), Result<RasterPipelineState>(std::string_view{"pipeline was not compiled"}));
+        run_compile_jobs(
+            compute_jobs.size() + raster_jobs.size(),
+            [&](usize job_index)
+            {
+                if (job_index < compute_jobs.size())
                 {
-                    *pipeline = std::move(*new_pipeline.value().pipeline_ptr);
+                    new_compute_pipelines[job_index] = create_compute_pipeline(compute_jobs[job_index].info, virtual_files_snapshot);
                 }
                 else
                 {
-                    return PipelineReloadError{new_pipeline.m};
+                    usize const raster_index = job_index - compute_jobs.size();
+                    new_raster_pipelines[raster_index] = create_raster_pipeline(raster_jobs[raster_index].info, virtual_files_snapshot);
                 }
+            });
+
+        auto lock = std::lock_guard{this->background_reload_mtx};
+        for (usize job_index = 0; job_index < compute_jobs.size(); ++job_index)
+        {
+            auto & new_pipeline = new_compute_pipelines[job_index];
+            if (new_pipeline.is_ok() && new_pipeline.value().pipeline_ptr->is_valid())
+            {
+                this->pending_compute_reloads.push_back({.target = compute_jobs[job_index].pipeline_ptr, .new_pipeline = std::move(new_pipeline)});
+            }
+            else
+            {
+                this->reload_errors.push_back(PipelineReloadError{new_pipeline.m});
+            }
+        }
+        for (usize job_index = 0; job_index < raster_jobs.size(); ++job_index)
+        {
+            auto & new_pipeline = new_raster_pipelines[job_index];
+            if (new_pipeline.is_ok() && new_pipeline.value().pipeline_ptr->is_valid())
+            {
+                this->pending_raster_reloads.push_back({.target = raster_jobs[job_index].pipeline_ptr, .new_pipeline = std::move(new_pipeline)});
+            }
+            else
+            {
+                this->reload_errors.push_back(PipelineReloadError{new_pipeline.m});
             }
         }
+    }
 
-        if (reloaded)
+    template <typename PipeT, typename InfoT>
+    auto ImplPipelineManager::apply_pending_reloads(std::vector<PipelineState<PipeT, InfoT>> & pipeline_states, std::vector<PendingReload<PipeT, InfoT>> & pending_reloads) -> bool
+    {
+        bool swapped = false;
+        for (auto & pending_reload : pending_reloads)
+        {
+            auto state_iter = std::find_if(
+                pipeline_states.begin(),
+                pipeline_states.end(),
+                [&](PipelineState<PipeT, InfoT> const & pipeline_state)
+                { return pipeline_state.pipeline_ptr == pending_reload.target; });
+            // The pipeline may have been removed while it was compiling.
+            if (state_iter == pipeline_states.end())
+            {
+                continue;
+            }
+            swapped = this->apply_reloaded_pipeline(*state_iter, pending_reload.new_pipeline) || swapped;
+        }
+        return swapped;
+    }
+
+    auto ImplPipelineManager::apply_background_reloads() -> bool
+    {
+        DAXA_TRACE_SCOPE("PipelineManager::apply_background_reloads");
+        if (!this->background_reload_thread.joinable())
         {
-            return PipelineReloadSuccess{};
+            auto result = this->reload_all();
+            if (auto * reload_error = std::get_if<PipelineReloadError>(&result))
+            {
+                auto lock = std::lock_guard{this->background_reload_mtx};
+                this->reload_errors.push_back(std::move(*reload_error));
+            }
+            return std::holds_alternative<PipelineReloadSuccess>(result);
         }
-        else
+        // Never waits for the background thread. When it is looking for changes right now, the swap happens on the next call.
+        auto state_lock = std::unique_lock{this->state_mtx, std::try_to_lock};
+        if (!state_lock.owns_lock())
         {
-            return NoPipelineChanged{};
+            return false;
+        }
+        auto pending_compute_reloads = std::vector<PendingReload<ComputePipeline, ComputePipelineCompileInfo>>{};
+        auto pending_raster_reloads = std::vector<PendingReload<RasterPipeline, RasterPipelineCompileInfo>>{};
+        {
+            auto lock = std::lock_guard{this->background_reload_mtx};
+            std::swap(pending_compute_reloads, this->pending_compute_reloads);
+            std::swap(pending_raster_reloads, this->pending_raster_reloads);
         }
+        bool const compute_swapped = this->apply_pending_reloads(this->compute_pipelines, pending_compute_reloads);
+        bool const raster_swapped = this->apply_pending_reloads(this->raster_pipelines, pending_raster_reloads);
+        return compute_swapped || raster_swapped;
     }
 
-    auto ImplPipelineManager::get_spirv(ShaderCompileInfo const & shader_info, std::string const & debug_name_opt, ShaderStage shader_stage) -> Result<std::vector<u32>>
+    auto ImplPipelineManager::pop_reload_errors() -> std::vector<PipelineReloadError>
     {
-        current_shader_info = &shader_info;
+        auto lock = std::lock_guard{this->background_reload_mtx};
+        auto ret = std::vector<PipelineReloadError>{};
+        ret.reserve(this->reload_errors.size());
+        std::move(this->reload_errors.begin(), this->reload_errors.end(), std::back_inserter(ret));
+        this->reload_errors.clear();
+        return ret;
+    }
+
+    auto ImplPipelineManager::get_spirv(ShaderCompileContext & context, ShaderCompileInfo const & shader_info, std::string const & debug_name_opt, ShaderStage shader_stage) -> Result<std::vector<u32>>
+    {
+        DAXA_TRACE_SCOPE("PipelineManager::compile_shader");
+        context.shader_info = &shader_info;
         std::vector<u32> spirv = {};
         if (std::holds_alternative<ShaderByteCode>(shader_info.source))
         {
@@ -843,15 +1605,15 @@ namespace daxa
             ShaderCode code;
             if (auto const * shader_source = std::get_if<ShaderFile>(&shader_info.source))
             {
-                auto ret = [this, &shader_source]() -> daxa::Result<std::filesystem::path>
+                auto ret = [this, &context, &shader_source]() -> daxa::Result<std::filesystem::path>
                 {
-                    if (this->virtual_files.contains(shader_source->path.string()))
+                    if (context.virtual_files->contains(shader_source->path.string()))
                     {
                         return daxa::Result<std::filesystem::path>(shader_source->path);
                     }
                     else
                     {
-                        return full_path_to_file(shader_source->path);
+                        return full_path_to_file(context, shader_source->path);
                     }
                 }();
                 if (ret.is_err())
@@ -881,12 +1643,12 @@ namespace daxa
             {
 #if DAXA_BUILT_WITH_UTILS_PIPELINE_MANAGER_GLSLANG
             case ShaderLanguage::GLSL:
-                ret = get_spirv_glslang(shader_info, debug_name_opt, shader_stage, code);
+                ret = get_spirv_glslang(context, shader_info, debug_name_opt, shader_stage, code);
                 break;
 #endif
 #if DAXA_BUILT_WITH_UTILS_PIPELINE_MANAGER_DXC
             case ShaderLanguage::HLSL:
-                ret = get_spirv_dxc(shader_info, shader_stage, code);
+                ret = get_spirv_dxc(context, shader_info, shader_stage, code);
                 break;
 #endif
             default: break;
@@ -894,12 +1656,12 @@ namespace daxa
 
             if (ret.is_err())
             {
-                current_shader_info = nullptr;
+                context.shader_info = nullptr;
                 return Result<std::vector<u32>>(ret.message());
             }
             spirv = ret.value();
         }
-        current_shader_info = nullptr;
+        context.shader_info = nullptr;
 
         std::string name = "unnamed-shader";
         if (ShaderFile const * shader_file = std::get_if<ShaderFile>(&shader_info.source))
@@ -937,6 +1699,7 @@ namespace daxa
         }
 
 #if DAXA_BUILT_WITH_UTILS_PIPELINE_MANAGER_SPIRV_VALIDATION
+        auto spirv_tools_lock = std::lock_guard{this->spirv_tools_mtx};
         spirv_tools.SetMessageConsumer(
             [&](spv_message_level_t level, [[maybe_unused]] char const * source, [[maybe_unused]] spv_position_t const & position, char const * message)
             { DAXA_DBG_ASSERT_TRUE_M(level > SPV_MSG_WARNING, fmt::format("SPIR-V Validation error after compiling {}:\n - {}", debug_name_opt, message)); });
@@ -948,16 +1711,16 @@ namespace daxa
         return Result<std::vector<u32>>(spirv);
     }
 
-    auto ImplPipelineManager::full_path_to_file(std::filesystem::path const & path) -> Result<std::filesystem::path>
+    auto ImplPipelineManager::full_path_to_file(ShaderCompileContext const & context, std::filesystem::path const & path) -> Result<std::filesystem::path>
     {
         if (std::filesystem::exists(path))
         {
             return Result<std::filesystem::path>(path);
         }
         std::filesystem::path potential_path;
-        if (this->current_shader_info != nullptr)
+        if (context.shader_info != nullptr)
         {
-            for (auto const & root : this->current_shader_info->compile_options.root_paths)
+            for (auto const & root : context.shader_info->compile_options.root_paths)
             {
                 potential_path.clear();
                 potential_path = root / path;
@@ -986,9 +1749,9 @@ namespace daxa
         return Result<std::filesystem::path>(std::string_view(error_msg));
     }
 
-    auto ImplPipelineManager::load_shader_source_from_file(std::filesystem::path const & path) -> Result<ShaderCode>
+    auto ImplPipelineManager::load_shader_source_from_file(ShaderCompileContext & context, std::filesystem::path const & path) -> Result<ShaderCode>
     {
-        auto result_path = full_path_to_file(path);
+        auto result_path = full_path_to_file(context, path);
         if (result_path.is_err())
         {
             return Result<ShaderCode>(result_path.message());
@@ -999,7 +1762,7 @@ namespace daxa
         {
             std::ifstream ifs{path};
             DAXA_DBG_ASSERT_TRUE_M(ifs.good(), "Could not open shader file");
-            current_observed_hotload_files->insert({
+            context.observed_hotload_files.insert({
                 result_path.value(),
                 std::filesystem::last_write_time(result_path.value()),
             });
@@ -1021,7 +1784,131 @@ namespace daxa
         return Result<ShaderCode>(err);
     }
 
-    auto ImplPipelineManager::get_spirv_glslang(ShaderCompileInfo const & shader_info, std::string const & debug_name_opt, ShaderStage shader_stage, ShaderCode const & code) -> Result<std::vector<u32>>
+    auto ImplPipelineManager::load_cached_spirv(std::string const & key) -> std::optional<std::vector<u32>>
+    {
+        DAXA_TRACE_SCOPE("PipelineManager::load_cached_spirv");
+        auto const path = spirv_cache_file_path(this->info.spirv_cache_path, fnv1a_64(key));
+        std::ifstream ifs{path, std::ios_base::binary};
+        if (!ifs.good())
+        {
+            return std::nullopt;
+        }
+        SpirvCacheFileHeader header = {};
+        ifs.read(reinterpret_cast<char *>(&header), sizeof(SpirvCacheFileHeader));
+        if (!ifs.good() || header.magic != SPIRV_CACHE_MAGIC || header.version != SPIRV_CACHE_VERSION || header.key_size != key.size() || header.word_count == 0)
+        {
+            return std::nullopt;
+        }
+        std::string stored_key(static_cast<usize>(header.key_size), '\0');
+        ifs.read(stored_key.data(), static_cast<std::streamsize>(stored_key.size()));
+        if (!ifs.good() || stored_key != key)
+        {
+            return std::nullopt;
+        }
+        std::vector<u32> spirv(static_cast<usize>(header.word_count));
+        ifs.read(reinterpret_cast<char *>(spirv.data()), static_cast<std::streamsize>(spirv.size() * sizeof(u32)));
+        if (!ifs.good())
+        {
+            return std::nullopt;
+        }
+        ifs.close();
+        // Hits refresh the write time, so that eviction removes the least recently used entries first.
+        std::error_code error = {};
+        std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+        this->spirv_cache_hits.fetch_add(1, std::memory_order_relaxed);
+        return spirv;
+    }
+
+    void ImplPipelineManager::store_cached_spirv(std::string const & key, std::vector<u32> const & spirv)
+    {
+        DAXA_TRACE_SCOPE("PipelineManager::store_cached_spirv");
+        std::error_code error = {};
+        std::filesystem::create_directories(this->info.spirv_cache_path, error);
+        auto const path = spirv_cache_file_path(this->info.spirv_cache_path, fnv1a_64(key));
+        // Written to a temporary file first and then renamed, so that a crash or a concurrent reader never sees a partially written entry.
+        // The temporary name is random, as multiple jobs and processes may compile the same shader at once.
+        std::random_device random_device = {};
+        u64 const temporary_id = (static_cast<u64>(random_device()) << 32) | static_cast<u64>(random_device());
+        auto temporary_path = path;
+        temporary_path += fmt::format(".{:016x}.tmp", temporary_id);
+        {
+            std::ofstream ofs{temporary_path, std::ios_base::trunc | std::ios_base::binary};
+            if (!ofs.good())
+            {
+                return;
+            }
+            SpirvCacheFileHeader const header = {.key_size = key.size(), .word_count = spirv.size()};
+            ofs.write(reinterpret_cast<char const *>(&header), sizeof(SpirvCacheFileHeader));
+            ofs.write(key.data(), static_cast<std::streamsize>(key.size()));
+            ofs.write(reinterpret_cast<char const *>(spirv.data()), static_cast<std::streamsize>(spirv.size() * sizeof(u32)));
+            if (!ofs.good())
+            {
+                ofs.close();
+                std::filesystem::remove(temporary_path, error);
+                return;
+            }
+        }
+        std::filesystem::rename(temporary_path, path, error);
+        if (error)
+        {
+            std::filesystem::remove(temporary_path, error);
+            return;
+        }
+        this->evict_spirv_cache(sizeof(SpirvCacheFileHeader) + key.size() + spirv.size() * sizeof(u32));
+    }
+
+    void ImplPipelineManager::evict_spirv_cache(u64 added_size)
+    {
+        auto lock = std::lock_guard{this->spirv_cache_mtx};
+        // The folder is only scanned for the first stored entry and when the tracked size exceeds the limit, not for every stored entry.
+        // Entries written by other processes are picked up by that scan.
+        if (this->spirv_cache_size.has_value() && this->spirv_cache_size.value() + added_size <= this->info.spirv_cache_max_size)
+        {
+            this->spirv_cache_size = this->spirv_cache_size.value() + added_size;
+            return;
+        }
+        struct Entry
+        {
+            std::filesystem::path path = {};
+            u64 size = {};
+            std::filesystem::file_time_type last_use = {};
+        };
+        std::vector<Entry> entries = {};
+        u64 total_size = 0;
+        std::error_code error = {};
+        for (auto const & dir_entry : std::filesystem::directory_iterator{this->info.spirv_cache_path, error})
+        {
+            if (!dir_entry.is_regular_file(error) || dir_entry.path().extension() != ".spv")
+            {
+                continue;
+            }
+            auto const size = static_cast<u64>(dir_entry.file_size(error));
+            auto const last_use = dir_entry.last_write_time(error);
+            total_size += size;
+            entries.push_back({.path = dir_entry.path(), .size = size, .last_use = last_use});
+        }
+        this->spirv_cache_size = total_size;
+        if (total_size <= this->info.spirv_cache_max_size)
+        {
+            return;
+        }
+        std::sort(entries.begin(), entries.end(), [](Entry const & a, Entry const & b)
+                  { return a.last_use < b.last_use; });
+        for (auto const & entry : entries)
+        {
+            if (total_size <= this->info.spirv_cache_max_size)
+            {
+                break;
+            }
+            if (std::filesystem::remove(entry.path, error))
+            {
+                total_size -= entry.size;
+            }
+        }
+        this->spirv_cache_size = total_size;
+    }
+
+    auto ImplPipelineManager::get_spirv_glslang(ShaderCompileContext & context, ShaderCompileInfo const & shader_info, std::string const & debug_name_opt, ShaderStage shader_stage, ShaderCode const & code) -> Result<std::vector<u32>>
     {
 #if DAXA_BUILT_WITH_UTILS_PIPELINE_MANAGER_GLSLANG
         auto translate_shader_stage = [](ShaderStage stage) -> EShLanguage
@@ -1122,23 +2009,47 @@ namespace daxa
 
         GlslangFileIncluder includer;
         includer.impl_pipeline_manager = this;
+        includer.context = &context;
         auto messages = static_cast<EShMessages>(EShMsgSpvRules | EShMsgVulkanRules);
         TBuiltInResource const resource = DAXA_DEFAULT_BUILTIN_RESOURCE;
 
         static constexpr int SHADER_VERSION = 450;
 
-        if (shader_info.compile_options.write_out_preprocessed_code.has_value())
+        bool const use_spirv_cache = !this->info.spirv_cache_path.empty();
+        std::optional<std::string> spirv_cache_key = {};
+        if (use_spirv_cache || shader_info.compile_options.write_out_preprocessed_code.has_value())
         {
-            std::replace(name.begin(), name.end(), '/', '_');
-            std::replace(name.begin(), name.end(), '\\', '_');
-            std::replace(name.begin(), name.end(), ':', '_');
-            std::string const file_name = std::string("preprocessed_") + name + "." + std::string(shader_stage_string(shader_stage));
-            auto filepath = shader_info.compile_options.write_out_preprocessed_code.value() / file_name;
             std::string preprocessed_result = {};
-            shader.preprocess(&DAXA_DEFAULT_BUILTIN_RESOURCE, SHADER_VERSION, EProfile::ENoProfile, false, false, messages, &preprocessed_result, includer);
-            auto ofs = std::ofstream{filepath, std::ios_base::trunc};
-            ofs.write(preprocessed_result.data(), static_cast<std::streamsize>(preprocessed_result.size()));
-            ofs.close();
+            bool const preprocessed = shader.preprocess(&DAXA_DEFAULT_BUILTIN_RESOURCE, SHADER_VERSION, EProfile::ENoProfile, false, false, messages, &preprocessed_result, includer);
+            if (shader_info.compile_options.write_out_preprocessed_code.has_value())
+            {
+                std::replace(name.begin(), name.end(), '/', '_');
+                std::replace(name.begin(), name.end(), '\\', '_');
+                std::replace(name.begin(), name.end(), ':', '_');
+                std::string const file_name = std::string("preprocessed_") + name + "." + std::string(shader_stage_string(shader_stage));
+                auto filepath = shader_info.compile_options.write_out_preprocessed_code.value() / file_name;
+                auto ofs = std::ofstream{filepath, std::ios_base::trunc};
+                ofs.write(preprocessed_result.data(), static_cast<std::streamsize>(preprocessed_result.size()));
+                ofs.close();
+            }
+            // The preprocessed source contains all included files, so any change to the source or its includes changes the key.
+            if (use_spirv_cache && preprocessed)
+            {
+                glslang::Version const glslang_version = glslang::GetVersion();
+                std::string const settings = fmt::format(
+                    "glsl;{};{};{};{}.{}.{}{};{}",
+                    SPIRV_CACHE_VERSION,
+                    shader_stage_string(shader_stage),
+                    shader_info.compile_options.entry_point.value_or("main"),
+                    glslang_version.major, glslang_version.minor, glslang_version.patch, glslang_version.flavor,
+                    use_debug_info);
+                // The preamble is length prefixed, so that text can not move between it and the preprocessed source without changing the key.
+                spirv_cache_key = fmt::format("{}\n{}\n{}{}", settings, preamble.size(), preamble, preprocessed_result);
+                if (auto cached_spirv = this->load_cached_spirv(spirv_cache_key.value()); cached_spirv.has_value())
+                {
+                    return Result<std::vector<u32>>(std::move(cached_spirv.value()));
+                }
+            }
         }
 
         auto error_message_prefix = std::string("GLSLANG [") + name + "]";
@@ -1171,13 +2082,17 @@ namespace daxa
         spv_options.stripDebugInfo = !use_debug_info;
         std::vector<u32> spv;
         glslang::GlslangToSpv(*intermediary, spv, &logger, &spv_options);
+        if (spirv_cache_key.has_value())
+        {
+            this->store_cached_spirv(spirv_cache_key.value(), spv);
+        }
         return Result<std::vector<u32>>(spv);
 #else
         return Result<std::vector<u32>>("Asked for glslang compilation without enabling glslang");
 #endif
     }
 
-    auto ImplPipelineManager::get_spirv_dxc(ShaderCompileInfo const & shader_info, ShaderStage shader_stage, ShaderCode const & code) -> Result<std::vector<u32>>
+    auto ImplPipelineManager::get_spirv_dxc(ShaderCompileContext & context, ShaderCompileInfo const & shader_info, ShaderStage shader_stage, ShaderCode const & code) -> Result<std::vector<u32>>
     {
 #if DAXA_BUILT_WITH_UTILS_PIPELINE_MANAGER_DXC
         auto u8_ascii_to_wstring = [](char const * str) -> std::wstring
@@ -1283,7 +2198,9 @@ namespace daxa
         };
 
         IDxcResult * result = nullptr;
+        auto dxc_lock = std::lock_guard{this->dxc_backend.mtx};
         dynamic_cast<DxcCustomIncluder &>(*this->dxc_backend.dxc_includer).impl_pipeline_manager = this;
+        dynamic_cast<DxcCustomIncluder &>(*this->dxc_backend.dxc_includer).context = &context;
         this->dxc_backend.dxc_compiler->Compile(
             &source_buffer, args.data(), static_cast<u32>(args.size()),
             this->dxc_backend.dxc_includer.get(), IID_PPV_ARGS(&result));
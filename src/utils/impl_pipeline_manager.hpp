@@ -2,6 +2,14 @@
 
 #include <daxa/utils/pipeline_manager.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <set>
+#include <thread>
+
 #if DAXA_BUILT_WITH_UTILS_PIPELINE_MANAGER_DXC
 #if defined(_WIN32)
 #include "Windows.h"
@@ -41,6 +49,8 @@ namespace daxa
 
     using VirtualFileSet = std::map<std::string, VirtualFileState>;
 
+    struct ShaderFileWatcher;
+
     struct ImplPipelineManager final : ManagedSharedState
     {
         enum class ShaderStage
@@ -54,19 +64,32 @@ namespace daxa
             MESH,
         };
 
-        PipelineManagerInfo info = {};
+        // State of a single shader compilation. Every compilation gets its own context,
+        // so that multiple shaders can be compiled on different threads at the same time.
+        struct ShaderCompileContext
+        {
+            ShaderCompileInfo const * shader_info = nullptr;
+            // Background compilations read a snapshot, so that virtual files can be added while they run.
+            VirtualFileSet const * virtual_files = nullptr;
+            std::vector<std::filesystem::path> seen_shader_files = {};
+            ShaderFileTimeSet observed_hotload_files = {};
+        };
 
-        std::vector<std::filesystem::path> current_seen_shader_files = {};
-        ShaderFileTimeSet * current_observed_hotload_files = nullptr;
+        PipelineManagerInfo info = {};
 
+        // Only read while compiling. Must not be modified while foreground compile jobs are running.
         VirtualFileSet virtual_files = {};
 
+        // Only set when info.enable_file_watcher is true and the watcher could be started.
+        std::unique_ptr<ShaderFileWatcher> file_watcher = {};
+        // Virtual files added since the last reload_all. Only tracked with a file watcher.
+        std::set<std::string> changed_virtual_files = {};
+
         template <typename PipeT, typename InfoT>
         struct PipelineState
         {
             std::shared_ptr<PipeT> pipeline_ptr;
             InfoT info;
-            std::chrono::file_clock::time_point last_hotload_time = {};
             ShaderFileTimeSet observed_hotload_files = {};
         };
 
@@ -76,11 +99,72 @@ namespace daxa
         std::vector<ComputePipelineState> compute_pipelines;
         std::vector<RasterPipelineState> raster_pipelines;
 
-        // TODO(grundlett): Maybe make the pipeline compiler *internally* thread-safe!
-        // This variable is accessed by the includer, which makes that not thread-safe
-        // PipelineManager is still externally thread-safe. You can create as many
-        // PipelineManagers from as many threads as you'd like!
-        ShaderCompileInfo const * current_shader_info = nullptr;
+        // Reverse include graph. Every file and virtual file any pipeline includes, directly or through other
+        // includes, maps to the pipelines that include it. Files are keyed by their normalized absolute path,
+        // virtual files by their name.
+        struct DependencyNode
+        {
+            std::filesystem::path path = {};
+            std::chrono::file_clock::time_point recorded_write_time = {};
+            std::set<ComputePipeline const *> compute_pipelines = {};
+            std::set<RasterPipeline const *> raster_pipelines = {};
+
+            template <typename PipeT>
+            auto dependents() -> std::set<PipeT const *> &
+            {
+                if constexpr (std::same_as<PipeT, ComputePipeline>)
+                {
+                    return compute_pipelines;
+                }
+                else
+                {
+                    return raster_pipelines;
+                }
+            }
+        };
+        std::map<std::filesystem::path, DependencyNode> dependency_graph = {};
+        // Time of the last polling pass of reload_all or the background reload thread.
+        std::chrono::file_clock::time_point last_hotload_time = {};
+
+        // Write time of one dependency as seen by a polling pass. Snapshotted under state_mtx, polled without it.
+        struct PolledFile
+        {
+            std::filesystem::path key = {};
+            std::filesystem::path path = {};
+            bool is_virtual = {};
+            std::optional<std::chrono::file_clock::time_point> latest_write_time = {};
+        };
+
+        struct ChangedPipelines
+        {
+            std::vector<usize> compute_indices = {};
+            std::vector<usize> raster_indices = {};
+        };
+
+        template <typename PipeT, typename InfoT>
+        struct PendingReload
+        {
+            std::shared_ptr<PipeT> target = {};
+            Result<PipelineState<PipeT, InfoT>> new_pipeline;
+        };
+
+        // Guards the pipelines, the dependency graph and the virtual files against the background reload thread.
+        // Only taken by the calling thread for modifications, reads on the calling thread need no lock.
+        std::mutex state_mtx = {};
+        // Only started when info.enable_background_reload is true and daxa is built with DAXA_THREADSAFETY.
+        std::thread background_reload_thread = {};
+        // Guards the stop flag, the pending reloads and the error queue.
+        std::mutex background_reload_mtx = {};
+        std::condition_variable background_reload_cv = {};
+        bool background_reload_stop = false;
+        // Compiled by the background thread, swapped into their pipelines by apply_background_reloads.
+        std::vector<PendingReload<ComputePipeline, ComputePipelineCompileInfo>> pending_compute_reloads = {};
+        std::vector<PendingReload<RasterPipeline, RasterPipelineCompileInfo>> pending_raster_reloads = {};
+        std::deque<PipelineReloadError> reload_errors = {};
+
+        // The pipeline compiler is internally thread-safe, the compile jobs of one call run on up to
+        // info.compile_thread_count threads. The PipelineManager itself must still be externally synchronized.
+        // You can create as many PipelineManagers from as many threads as you'd like!
 
 #if DAXA_BUILT_WITH_UTILS_PIPELINE_MANAGER_GLSLANG
         struct GlslangBackend
@@ -95,31 +179,73 @@ namespace daxa
             IDxcUtils * dxc_utils = nullptr;
             IDxcCompiler3 * dxc_compiler = nullptr;
             std::shared_ptr<IDxcIncludeHandler> dxc_includer = nullptr;
+            // The DXC compiler and the shared includer are not thread-safe, HLSL compilations are serialized.
+            std::mutex mtx = {};
         };
         DxcBackend dxc_backend = {};
 #endif
 
+        // Serializes the eviction of spirv cache entries. Reads and writes of entries are atomic and need no lock.
+        std::mutex spirv_cache_mtx = {};
+        // Size of the cache folder as of the last scan, plus the entries stored since then.
+        std::optional<u64> spirv_cache_size = {};
+        std::atomic<u64> spirv_cache_hits = {};
+
 #if DAXA_BUILT_WITH_UTILS_PIPELINE_MANAGER_SPIRV_VALIDATION
         spvtools::SpirvTools spirv_tools = spvtools::SpirvTools{SPV_ENV_VULKAN_1_3};
+        std::mutex spirv_tools_mtx = {};
 #endif
 
         ImplPipelineManager(PipelineManagerInfo && a_info);
         ~ImplPipelineManager();
 
-        auto create_compute_pipeline(ComputePipelineCompileInfo const & a_info) -> Result<ComputePipelineState>;
-        auto create_raster_pipeline(RasterPipelineCompileInfo const & a_info) -> Result<RasterPipelineState>;
+        auto create_compute_pipeline(ComputePipelineCompileInfo const & a_info, VirtualFileSet const & virtual_file_set) -> Result<ComputePipelineState>;
+        auto create_raster_pipeline(RasterPipelineCompileInfo const & a_info, VirtualFileSet const & virtual_file_set) -> Result<RasterPipelineState>;
+        auto register_compute_pipeline(Result<ComputePipelineState> && pipe_result) -> Result<std::shared_ptr<ComputePipeline>>;
+        auto register_raster_pipeline(Result<RasterPipelineState> && pipe_result) -> Result<std::shared_ptr<RasterPipeline>>;
         auto add_compute_pipeline(ComputePipelineCompileInfo const & a_info) -> Result<std::shared_ptr<ComputePipeline>>;
         auto add_raster_pipeline(RasterPipelineCompileInfo const & a_info) -> Result<std::shared_ptr<RasterPipeline>>;
+        auto add_compute_pipelines(std::span<ComputePipelineCompileInfo const> infos) -> std::vector<Result<std::shared_ptr<ComputePipeline>>>;
+        auto add_raster_pipelines(std::span<RasterPipelineCompileInfo const> infos) -> std::vector<Result<std::shared_ptr<RasterPipeline>>>;
         void remove_compute_pipeline(std::shared_ptr<ComputePipeline> const & pipeline);
         void remove_raster_pipeline(std::shared_ptr<RasterPipeline> const & pipeline);
         void add_virtual_file(VirtualFileInfo const & virtual_info);
         auto reload_all() -> PipelineReloadResult;
+        auto apply_background_reloads() -> bool;
+        auto pop_reload_errors() -> std::vector<PipelineReloadError>;
+        auto pipelines_depending_on(std::filesystem::path const & file) -> PipelineDependents;
+
+        auto dependency_key(std::filesystem::path const & path) const -> std::filesystem::path;
+        template <typename PipeT, typename InfoT>
+        void add_pipeline_dependencies(PipelineState<PipeT, InfoT> const & pipeline_state);
+        template <typename PipeT, typename InfoT>
+        void remove_pipeline_dependencies(PipelineState<PipeT, InfoT> const & pipeline_state);
+
+        // Returns the dependencies a polling pass must check, empty with a file watcher or when the last pass was too recent.
+        auto take_polled_files() -> std::vector<PolledFile>;
+        // Touches the file system only, so it runs without holding state_mtx.
+        static void poll_write_times(std::vector<PolledFile> & polled_files);
+        auto find_changed_pipelines(std::vector<PolledFile> const & polled_files) -> ChangedPipelines;
+        // Moves a successfully compiled pipeline into the existing pipeline object. Returns false if the compilation failed.
+        template <typename PipeT, typename InfoT>
+        auto apply_reloaded_pipeline(PipelineState<PipeT, InfoT> & pipeline_state, Result<PipelineState<PipeT, InfoT>> & new_pipeline) -> bool;
+        template <typename PipeT, typename InfoT>
+        auto apply_pending_reloads(std::vector<PipelineState<PipeT, InfoT>> & pipeline_states, std::vector<PendingReload<PipeT, InfoT>> & pending_reloads) -> bool;
+        void background_reload_loop();
+        void background_reload();
+
+        // Calls job(i) for every i in [0, job_count) on up to info.compile_thread_count threads, including the calling thread.
+        void run_compile_jobs(usize job_count, std::function<void(usize)> const & job);
+
+        auto full_path_to_file(ShaderCompileContext const & context, std::filesystem::path const & path) -> Result<std::filesystem::path>;
+        auto load_shader_source_from_file(ShaderCompileContext & context, std::filesystem::path const & path) -> Result<ShaderCode>;
 
-        auto full_path_to_file(std::filesystem::path const & path) -> Result<std::filesystem::path>;
-        auto load_shader_source_from_file(std::filesystem::path const & path) -> Result<ShaderCode>;
+        auto load_cached_spirv(std::string const & key) -> std::optional<std::vector<u32>>;
+        void store_cached_spirv(std::string const & key, std::vector<u32> const & spirv);
+        void evict_spirv_cache(u64 added_size);
 
-        auto get_spirv(ShaderCompileInfo const & shader_info, std::string const & debug_name_opt, ShaderStage shader_stage) -> Result<std::vector<u32>>;
-        auto get_spirv_glslang(ShaderCompileInfo const & shader_info, std::string const & debug_name_opt, ShaderStage shader_stage, ShaderCode const & code) -> Result<std::vector<u32>>;
-        auto get_spirv_dxc(ShaderCompileInfo const & shader_info, ShaderStage shader_stage, ShaderCode const & code) -> Result<std::vector<u32>>;
+        auto get_spirv(ShaderCompileContext & context, ShaderCompileInfo const & shader_info, std::string const & debug_name_opt, ShaderStage shader_stage) -> Result<std::vector<u32>>;
+        auto get_spirv_glslang(ShaderCompileContext & context, ShaderCompileInfo const & shader_info, std::string const & debug_name_opt, ShaderStage shader_stage, ShaderCode const & code) -> Result<std::vector<u32>>;
+        auto get_spirv_dxc(ShaderCompileContext & context, ShaderCompileInfo const & shader_info, ShaderStage shader_stage, ShaderCode const & code) -> Result<std::vector<u32>>;
     };
 } // namespace daxa
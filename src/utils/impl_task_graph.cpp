@@ -916,6 +916,7 @@ namespace daxa
         // When the get command list function is called in a task this is set to false.
         impl_runtime.reuse_last_command_list = true;
         ImplTask & task = tasks[task_id];
+        DAXA_TRACE_SCOPE(task.base_task->get_name());
         update_image_view_cache(task, permutation);
         for_each(
             task.base_task->get_generic_uses(),
@@ -933,7 +934,14 @@ namespace daxa
         {
             DAXA_DBG_ASSERT_TRUE_M(staging_memory.has_value(), "transient memory pool must have a size > 0 when shader integration is used");
             u32 const alignment = static_cast<u32>(info.device.properties().limits.min_uniform_buffer_offset_alignment);
-            auto constant_buffer_alloc = staging_memory->allocate(task.constant_buffer_size, alignment).value();
+            auto constant_buffer_alloc_opt = staging_memory->allocate(task.constant_buffer_size, alignment);
+            // Only a pool that may not grow runs out, a growing pool only fails when the device is out of memory.
+            DAXA_DBG_ASSERT_TRUE_M(
+                constant_buffer_alloc_opt.has_value(),
+                info.staging_memory_pool_allow_growth
+                    ? "failed to grow the staging memory pool for the task constant buffer"
+                    : "staging pool exhausted, enable staging_memory_pool_allow_growth or increase staging_memory_pool_size");
+            auto constant_buffer_alloc = constant_buffer_alloc_opt.value();
             u8 * host_constant_buffer_ptr = reinterpret_cast<u8 *>(constant_buffer_alloc.host_address);
             for_each(
                 task.base_task->get_generic_uses(),
@@ -951,7 +959,7 @@ namespace daxa
             impl_runtime.device_address = constant_buffer_alloc.device_address;
             impl_runtime.set_uniform_buffer_info = SetConstantBufferInfo{
                 .slot = static_cast<u32>(task.base_task->get_uses_constant_buffer_slot()),
-                .buffer = staging_memory->get_buffer(),
+                .buffer = constant_buffer_alloc.buffer,
                 .size = constant_buffer_alloc.size,
                 .offset = constant_buffer_alloc.buffer_offset,
             };
@@ -2007,7 +2015,14 @@ namespace daxa
                 bool is_image = {};
                 u32 owning_resource_idx = {};
                 u32 memory_type_bits = {};
-                ImageMipArraySlice intersection_object = {};
+
+                // Two allocations intersect when they overlap both in memory and in batch lifetime.
+                auto intersects(Allocation const & other) const -> bool
+                {
+                    bool const batch_disjoint = (this->end_batch < other.start_batch) || (other.end_batch < this->start_batch);
+                    bool const memory_disjoint = (this->offset + this->size <= other.offset) || (other.offset + other.size <= this->offset);
+                    return !batch_disjoint && !memory_disjoint;
+                }
             };
             // Sort allocations in the set in the following way
             //      1) sort by offsets into the memory block
@@ -2059,7 +2074,6 @@ namespace daxa
                                            .memory_requirements;
                 }
                 // Go through all memory block states in which this resource is alive and try to find a spot for it
-                const u8 resource_lifetime_duration = static_cast<u8>(resource_lifetime.end_batch - resource_lifetime.start_batch + 1);
                 Allocation new_allocation = Allocation{
                     .offset = 0,
                     .size = mem_requirements.size,
@@ -2068,28 +2082,20 @@ namespace daxa
                     .is_image = resource_lifetime.is_image,
                     .owning_resource_idx = resource_lifetime.resource_idx,
                     .memory_type_bits = mem_requirements.memory_type_bits,
-                    .intersection_object = {
-                        .base_mip_level = static_cast<u8>(resource_lifetime.start_batch),
-                        .level_count = resource_lifetime_duration,
-                        .base_array_layer = static_cast<u16>(0),
-                        .layer_count = static_cast<u32>(mem_requirements.size),
-                    }};
+                };
                 usize const align = std::max(mem_requirements.alignment, static_cast<size_t>(1ull));
 
                 if (info.alias_transients)
                 {
-                    // TODO(msakmary) Fix the intersect functionality so that it is general and does not do hacky stuff like constructing
-                    // a mip array slice
                     // Find space in memory and time the new allocation fits into.
                     for (auto const & allocation : allocations)
                     {
-                        if (new_allocation.intersection_object.intersects(allocation.intersection_object))
+                        if (new_allocation.intersects(allocation))
                         {
                             // assign new offset into the memory block - we need to guarantee correct allignment
                             usize curr_offset = allocation.offset + allocation.size;
                             usize const aligned_curr_offset = (curr_offset + align - 1) / align * align;
                             new_allocation.offset = aligned_curr_offset;
-                            new_allocation.intersection_object.base_array_layer = static_cast<u32>(new_allocation.offset);
                         }
                     }
                 }
@@ -2130,6 +2136,7 @@ namespace daxa
 
     void TaskGraph::complete(TaskCompleteInfo const &)
     {
+        DAXA_TRACE_SCOPE("TaskGraph::complete");
         auto & impl = *as<ImplTaskGraph>();
         DAXA_DBG_ASSERT_TRUE_M(!impl.compiled, "task graphs can only be completed once");
         impl.compiled = true;
@@ -2218,6 +2225,16 @@ namespace daxa
         return impl.memory_block_size;
     }
 
+    auto TaskGraph::get_staging_memory_statistics() -> std::optional<TransferMemoryPoolStatistics>
+    {
+        auto & impl = *as<ImplTaskGraph>();
+        if (!impl.staging_memory.has_value())
+        {
+            return std::nullopt;
+        }
+        return impl.staging_memory->statistics();
+    }
+
     thread_local std::vector<SplitBarrierWaitInfo> tl_split_barrier_wait_infos = {};
     thread_local std::vector<ImageBarrierInfo> tl_image_barrier_infos = {};
     thread_local std::vector<MemoryBarrierInfo> tl_memory_barrier_infos = {};
@@ -2468,6 +2485,7 @@ namespace daxa
     ///     2.3 check if submit scope presents, present if true.
     void TaskGraph::execute(ExecutionInfo const & info)
     {
+        DAXA_TRACE_SCOPE("TaskGraph::execute");
         auto & impl = *as<ImplTaskGraph>();
         DAXA_DBG_ASSERT_TRUE_M(info.permutation_condition_values.size() >= impl.info.permutation_condition_count, "detected invalid permutation condition count");
         DAXA_DBG_ASSERT_TRUE_M(impl.compiled, "task graphs must be completed before execution");
@@ -2504,6 +2522,7 @@ namespace daxa
             usize batch_index = 0;
             for (auto & task_batch : submit_scope.task_batches)
             {
+                DAXA_TRACE_SCOPE("TaskGraph batch");
                 if (impl.info.enable_command_labels)
                 {
                     impl_runtime.command_lists.back().begin_label({
@@ -2800,7 +2819,7 @@ namespace daxa
     {
         if (a_info.staging_memory_pool_size != 0)
         {
-            this->staging_memory = TransferMemoryPool{TransferMemoryPoolInfo{.device = info.device, .capacity = info.staging_memory_pool_size, .use_bar_memory = true, .name = info.name}};
+            this->staging_memory = TransferMemoryPool{TransferMemoryPoolInfo{.device = info.device, .capacity = info.staging_memory_pool_size, .use_bar_memory = true, .allow_growth = info.staging_memory_pool_allow_growth, .name = info.name}};
         }
     }
 
@@ -3050,6 +3069,12 @@ namespace daxa
                        info.task_label_color[3]);
         fmt::format_to(std::back_inserter(out), "record_debug_information: {}\n", info.record_debug_information);
         fmt::format_to(std::back_inserter(out), "staging_memory_pool_size: {}\n", info.staging_memory_pool_size);
+        fmt::format_to(std::back_inserter(out), "staging_memory_pool_allow_growth: {}\n", info.staging_memory_pool_allow_growth);
+        if (this->staging_memory.has_value())
+        {
+            auto const staging_statistics = this->staging_memory->statistics();
+            fmt::format_to(std::back_inserter(out), "staging memory capacity: {}, high water mark: {}, grow count: {}\n", staging_statistics.capacity, staging_statistics.high_water_mark, staging_statistics.grow_count);
+        }
         fmt::format_to(std::back_inserter(out), "executed permutation: {}\n", chosen_permutation_last_execution);
         usize permutation_index = this->chosen_permutation_last_execution;
         auto & permutation = this->permutations[permutation_index];
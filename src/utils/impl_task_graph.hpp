@@ -2,6 +2,7 @@
 
 #include <stack>
 #include <daxa/utils/task_graph.hpp>
+#include <daxa/trace.hpp>
 
 #define DAXA_TASK_GRAPH_MAX_CONDITIONALS 31
 
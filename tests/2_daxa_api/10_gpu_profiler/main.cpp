@@ -0,0 +1,109 @@
+#include <daxa/daxa.hpp>
+using namespace daxa::types;
+
+#include <daxa/utils/gpu_profiler.hpp>
+
+#include <iostream>
+
+static inline constexpr usize FRAME_COUNT = {64};
+static inline constexpr usize FRAMES_IN_FLIGHT = {2};
+static inline constexpr usize BUFFER_SIZE = {1 << 20};
+
+auto main() -> int
+{
+    daxa::Instance daxa_ctx = daxa::create_instance({});
+    daxa::Device device = daxa_ctx.create_device({
+        .name = "device",
+    });
+    daxa::GpuProfiler profiler{daxa::GpuProfilerInfo{
+        .device = device,
+        .frames_in_flight = FRAMES_IN_FLIGHT,
+        .name = "gpu profiler",
+    }};
+    daxa::TimelineSemaphore gpu_timeline = device.create_timeline_semaphore({
+        .name = "timeline semaphpore",
+    });
+    usize cpu_timeline = 1;
+    daxa::BufferId src_buffer = device.create_buffer({
+        .size = BUFFER_SIZE,
+        .name = "src",
+    });
+    daxa::BufferId dst_buffer = device.create_buffer({
+        .size = BUFFER_SIZE,
+        .name = "dst",
+    });
+
+    for (u32 frame = 0; frame < FRAME_COUNT; ++frame)
+    {
+        if (cpu_timeline > FRAMES_IN_FLIGHT)
+        {
+            gpu_timeline.wait_for_value(cpu_timeline - FRAMES_IN_FLIGHT);
+        }
+        daxa::CommandList cmd = device.create_command_list({});
+
+        // Reads back all frames that the gpu finished, never waits for the gpu.
+        profiler.begin_frame(cmd);
+
+        // Scopes can be nested, each scope also begins a debug label with the same name.
+        profiler.begin_scope(cmd, "frame");
+        {
+            profiler.begin_scope(cmd, "clear");
+            cmd.clear_buffer({.buffer = src_buffer, .offset = 0, .size = BUFFER_SIZE, .clear_value = frame});
+            profiler.end_scope(cmd);
+
+            cmd.pipeline_barrier({
+                .src_access = daxa::AccessConsts::TRANSFER_WRITE,
+                .dst_access = daxa::AccessConsts::TRANSFER_READ,
+            });
+
+            profiler.begin_scope(cmd, "copy");
+            cmd.copy_buffer_to_buffer({
+                .src_buffer = src_buffer,
+                .dst_buffer = dst_buffer,
+                .size = BUFFER_SIZE,
+            });
+            profiler.end_scope(cmd);
+        }
+        profiler.end_scope(cmd);
+
+        profiler.end_frame();
+        cmd.complete();
+
+        // The profilers timeline semaphore must be signaled with its timeline value by the last submit of the frame.
+        device.submit_commands({
+            .command_lists{std::move(cmd)},
+            .signal_timeline_semaphores = {
+                {gpu_timeline, cpu_timeline},
+                {profiler.get_timeline_semaphore(), profiler.timeline_value()},
+            },
+        });
+        cpu_timeline += 1;
+    }
+
+    device.wait_idle();
+
+    // One more frame to read back the last submitted frames.
+    {
+        daxa::CommandList cmd = device.create_command_list({});
+        profiler.begin_frame(cmd);
+        profiler.end_frame();
+        cmd.complete();
+    }
+
+    daxa::GpuProfilerFrame const & last_frame = profiler.last_frame();
+    DAXA_DBG_ASSERT_TRUE_M(last_frame.frame_index == FRAME_COUNT, "last resolved frame must be the last submitted frame");
+    DAXA_DBG_ASSERT_TRUE_M(last_frame.scopes.size() == 3, "expected three recorded scopes");
+    DAXA_DBG_ASSERT_TRUE_M(last_frame.scopes[1].parent_index == 0 && last_frame.scopes[2].parent_index == 0, "nested scopes must point to their parent");
+    for (auto const & scope : last_frame.scopes)
+    {
+        std::cout << std::string(scope.depth * 2, ' ') << scope.name << ": " << scope.duration_ms << " ms"
+                  << " (avg " << scope.statistics.average_ms << " ms, p95 " << scope.statistics.p95_ms << " ms)\n";
+    }
+    auto copy_statistics = profiler.scope_statistics("frame/copy");
+    DAXA_DBG_ASSERT_TRUE_M(copy_statistics.has_value() && copy_statistics->sample_count + profiler.dropped_frame_count() == FRAME_COUNT, "every frame must either be profiled or dropped");
+
+    device.destroy_buffer(src_buffer);
+    device.destroy_buffer(dst_buffer);
+    device.collect_garbage();
+    std::cout << std::flush;
+}
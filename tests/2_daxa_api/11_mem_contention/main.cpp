@@ -0,0 +1,218 @@
+#include <daxa/daxa.hpp>
+using namespace daxa::types;
+
+#include <daxa/utils/mem.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+static inline constexpr usize FRAME_COUNT = {64};
+static inline constexpr usize FRAMES_IN_FLIGHT = {2};
+static inline constexpr usize ALLOCATIONS_PER_THREAD = {1024};
+static inline constexpr usize ALLOCATION_SIZE = {64};
+static inline constexpr usize ALLOCATION_ALIGNMENT = {16};
+static inline constexpr usize POOL_CAPACITY = {1 << 25};
+
+struct BenchmarkResult
+{
+    f64 milliseconds = {};
+    usize failed_allocations = {};
+};
+
+// Runs FRAME_COUNT frames, in each frame every thread allocates and writes ALLOCATIONS_PER_THREAD allocations.
+// After all threads finished recording, one submit signals the pools timeline semaphore.
+// The worker threads are started once and synchronized per frame, so only the allocations are timed and not the thread start up.
+template <typename AllocateFn, typename EndFrameFn>
+auto run_benchmark(daxa::Device & device, u32 thread_count, AllocateFn && allocate_fn, EndFrameFn && end_frame_fn) -> BenchmarkResult
+{
+    daxa::TimelineSemaphore gpu_timeline = device.create_timeline_semaphore({
+        .name = "timeline semaphpore",
+    });
+    usize cpu_timeline = 1;
+    std::atomic_uint64_t failed_allocations = {};
+    // The main thread takes part in both barriers, it releases the workers into a frame and waits for all of them to finish it.
+    std::barrier frame_begin{static_cast<std::ptrdiff_t>(thread_count + 1)};
+    std::barrier frame_end{static_cast<std::ptrdiff_t>(thread_count + 1)};
+    std::atomic_bool stop = {};
+    std::vector<std::thread> threads = {};
+    for (u32 thread_index = 0; thread_index < thread_count; ++thread_index)
+    {
+        threads.emplace_back([&, thread_index]()
+                             {
+            while (true)
+            {
+                frame_begin.arrive_and_wait();
+                if (stop.load())
+                {
+                    return;
+                }
+                for (usize i = 0; i < ALLOCATIONS_PER_THREAD; ++i)
+                {
+                    void * host_address = allocate_fn();
+                    if (host_address == nullptr)
+                    {
+                        failed_allocations.fetch_add(1);
+                        continue;
+                    }
+                    std::fill_n(reinterpret_cast<u32 *>(host_address), ALLOCATION_SIZE / sizeof(u32), thread_index);
+                }
+                frame_end.arrive_and_wait();
+            } });
+    }
+    auto const start = std::chrono::steady_clock::now();
+    for (usize frame = 0; frame < FRAME_COUNT; ++frame)
+    {
+        if (cpu_timeline > FRAMES_IN_FLIGHT)
+        {
+            gpu_timeline.wait_for_value(cpu_timeline - FRAMES_IN_FLIGHT);
+        }
+        frame_begin.arrive_and_wait();
+        frame_end.arrive_and_wait();
+        daxa::CommandList cmd = device.create_command_list({});
+        cmd.complete();
+        end_frame_fn(std::move(cmd), gpu_timeline, cpu_timeline);
+        cpu_timeline += 1;
+    }
+    device.wait_idle();
+    auto const end = std::chrono::steady_clock::now();
+    stop.store(true);
+    frame_begin.arrive_and_wait();
+    for (auto & thread : threads)
+    {
+        thread.join();
+    }
+    return BenchmarkResult{
+        .milliseconds = std::chrono::duration<f64, std::milli>(end - start).count(),
+        .failed_allocations = static_cast<usize>(failed_allocations.load()),
+    };
+}
+
+namespace tests
+{
+    // One TransferMemoryPool shared by all threads, every allocation takes a lock.
+    auto locked_transfer_memory_pool(daxa::Device & device, u32 thread_count) -> BenchmarkResult
+    {
+        daxa::TransferMemoryPool tmem{daxa::TransferMemoryPoolInfo{
+            .device = device,
+            .capacity = POOL_CAPACITY,
+            .name = "locked transfer memory pool",
+        }};
+        std::mutex tmem_mtx = {};
+        return run_benchmark(
+            device, thread_count,
+            [&]() -> void *
+            {
+                std::lock_guard const lock{tmem_mtx};
+                auto alloc = tmem.allocate(ALLOCATION_SIZE, ALLOCATION_ALIGNMENT);
+                return alloc.has_value() ? alloc->host_address : nullptr;
+            },
+            [&](daxa::CommandList && cmd, daxa::TimelineSemaphore & gpu_timeline, usize cpu_timeline)
+            {
+                device.submit_commands({
+                    .command_lists{std::move(cmd)},
+                    .signal_timeline_semaphores = {
+                        {gpu_timeline, cpu_timeline},
+                        {tmem.get_timeline_semaphore(), tmem.timeline_value()},
+                    },
+                });
+            });
+    }
+
+    // One ConcurrentTransferMemoryPool shared by all threads, allocations never lock.
+    auto concurrent_transfer_memory_pool(daxa::Device & device, u32 thread_count) -> BenchmarkResult
+    {
+        daxa::ConcurrentTransferMemoryPool tmem{daxa::ConcurrentTransferMemoryPoolInfo{
+            .device = device,
+            .capacity = POOL_CAPACITY,
+            .name = "concurrent transfer memory pool",
+        }};
+        return run_benchmark(
+            device, thread_count,
+            [&]() -> void *
+            {
+                auto alloc = tmem.allocate(ALLOCATION_SIZE, ALLOCATION_ALIGNMENT);
+                return alloc.has_value() ? alloc->host_address : nullptr;
+            },
+            [&](daxa::CommandList && cmd, daxa::TimelineSemaphore & gpu_timeline, usize cpu_timeline)
+            {
+                device.submit_commands({
+                    .command_lists{std::move(cmd)},
+                    .signal_timeline_semaphores = {
+                        {gpu_timeline, cpu_timeline},
+                        {tmem.get_timeline_semaphore(), tmem.end_batch()},
+                    },
+                });
+            });
+    }
+
+    // Allocations of concurrent threads must never overlap.
+    void concurrent_allocations_are_disjoint(daxa::Device & device)
+    {
+        daxa::ConcurrentTransferMemoryPool tmem{daxa::ConcurrentTransferMemoryPoolInfo{
+            .device = device,
+            .capacity = POOL_CAPACITY,
+            .name = "concurrent transfer memory pool",
+        }};
+        u32 const thread_count = std::max(2u, std::thread::hardware_concurrency());
+        std::vector<std::vector<usize>> offsets(thread_count);
+        std::vector<std::thread> threads = {};
+        for (u32 thread_index = 0; thread_index < thread_count; ++thread_index)
+        {
+            threads.emplace_back([&, thread_index]()
+                                 {
+                for (usize i = 0; i < ALLOCATIONS_PER_THREAD; ++i)
+                {
+                    auto alloc = tmem.allocate(ALLOCATION_SIZE, ALLOCATION_ALIGNMENT).value();
+                    DAXA_DBG_ASSERT_TRUE_M(alloc.buffer_offset % ALLOCATION_ALIGNMENT == 0, "allocation is not aligned");
+                    offsets[thread_index].push_back(alloc.buffer_offset);
+                } });
+        }
+        for (auto & thread : threads)
+        {
+            thread.join();
+        }
+        std::vector<usize> all_offsets = {};
+        for (auto const & thread_offsets : offsets)
+        {
+            all_offsets.insert(all_offsets.end(), thread_offsets.begin(), thread_offsets.end());
+        }
+        std::sort(all_offsets.begin(), all_offsets.end());
+        for (usize i = 1; i < all_offsets.size(); ++i)
+        {
+            DAXA_DBG_ASSERT_TRUE_M(all_offsets[i] - all_offsets[i - 1] >= ALLOCATION_SIZE, "concurrent allocations overlap");
+        }
+        device.submit_commands({
+            .signal_timeline_semaphores = {{tmem.get_timeline_semaphore(), tmem.end_batch()}},
+        });
+        device.wait_idle();
+    }
+} // namespace tests
+
+auto main() -> int
+{
+    daxa::Instance daxa_ctx = daxa::create_instance({});
+    daxa::Device device = daxa_ctx.create_device({
+        .name = "device",
+    });
+    tests::concurrent_allocations_are_disjoint(device);
+
+    u32 const max_thread_count = std::max(1u, std::thread::hardware_concurrency());
+    for (u32 thread_count = 1; thread_count <= max_thread_count; thread_count *= 2)
+    {
+        auto const locked = tests::locked_transfer_memory_pool(device, thread_count);
+        auto const concurrent = tests::concurrent_transfer_memory_pool(device, thread_count);
+        DAXA_DBG_ASSERT_TRUE_M(concurrent.failed_allocations == 0, "concurrent pool ran out of memory although batches were reclaimable");
+        f64 const allocation_count = static_cast<f64>(FRAME_COUNT * ALLOCATIONS_PER_THREAD * thread_count);
+        std::cout << "threads: " << thread_count
+                  << ", locked: " << locked.milliseconds << " ms (" << allocation_count / locked.milliseconds / 1000.0 << " M allocs/s)"
+                  << ", concurrent: " << concurrent.milliseconds << " ms (" << allocation_count / concurrent.milliseconds / 1000.0 << " M allocs/s)\n";
+    }
+    device.collect_garbage();
+    std::cout << std::flush;
+}
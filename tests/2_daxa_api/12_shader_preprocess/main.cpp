@@ -0,0 +1,184 @@
+#include <daxa/daxa.hpp>
+using namespace daxa::types;
+
+#include <daxa/utils/pipeline_manager.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <regex>
+#include <sstream>
+#include <vector>
+
+static inline constexpr usize ITERATION_COUNT = {1000};
+
+// The include tree of the glsl side of daxa.
+static auto const INCLUDE_TREE = std::array{
+    "daxa/daxa.inl",
+    "daxa/daxa.glsl",
+    "daxa/utils/mem.inl",
+    "daxa/utils/task_graph.inl",
+};
+
+struct ShaderFileContents
+{
+    std::filesystem::path path = {};
+    std::string contents = {};
+};
+
+// The previous std::regex based preprocessor, kept as the baseline of the benchmark and the output comparison.
+static const std::regex PRAGMA_ONCE_REGEX = std::regex(R"regex(\s*#\s*pragma\s+once\s*)regex");
+static const std::regex REPLACE_REGEX = std::regex(R"regex(\W)regex");
+static void regex_shader_preprocess(std::string & file_str, std::filesystem::path const & path)
+{
+    std::smatch matches = {};
+    std::string line = {};
+    std::stringstream file_ss{file_str};
+    std::stringstream result_ss = {};
+    bool has_pragma_once = false;
+    auto abs_path_str = path.string();
+    if (std::filesystem::exists(path))
+    {
+        abs_path_str = std::filesystem::absolute(path).string();
+    }
+    while (std::getline(file_ss, line))
+    {
+        if (std::regex_match(line, matches, PRAGMA_ONCE_REGEX))
+        {
+            result_ss << "#if !defined(";
+            std::regex_replace(std::ostreambuf_iterator<char>(result_ss), abs_path_str.begin(), abs_path_str.end(), REPLACE_REGEX, "");
+            result_ss << ")\n";
+            has_pragma_once = true;
+        }
+        else
+        {
+            result_ss << line << "\n";
+        }
+    }
+    if (has_pragma_once)
+    {
+        result_ss << "\n#define ";
+        std::regex_replace(std::ostreambuf_iterator<char>(result_ss), abs_path_str.begin(), abs_path_str.end(), REPLACE_REGEX, "");
+        result_ss << "\n#endif\n";
+    }
+    file_str = result_ss.str();
+}
+
+struct GoldenCase
+{
+    char const * name = {};
+    // Virtual file names do not exist on disk, the guard is named after the path as written.
+    char const * path = {};
+    char const * source = {};
+    char const * expected = {};
+};
+
+static auto const GOLDEN_CASES = std::array{
+    GoldenCase{
+        .name = "includes are left to the compiler",
+        .path = "golden/includes.glsl",
+        .source = "#include <daxa/daxa.inl>\n#include \"local.glsl\"\nvoid main() {}",
+        .expected = "#include <daxa/daxa.inl>\n#include \"local.glsl\"\nvoid main() {}\n",
+    },
+    GoldenCase{
+        .name = "pragma once becomes an include guard",
+        .path = "golden/pragma_once.glsl",
+        .source = "#pragma once\n#include \"other.glsl\"\nint a;\n",
+        .expected = "#if !defined(goldenpragma_onceglsl)\n#include \"other.glsl\"\nint a;\n\n#define goldenpragma_onceglsl\n#endif\n",
+    },
+    GoldenCase{
+        .name = "pragma once with whitespace and crlf",
+        .path = "golden/spaced.glsl",
+        .source = "  #  pragma\tonce  \r\nint b;\r\n",
+        .expected = "#if !defined(goldenspacedglsl)\nint b;\r\n\n#define goldenspacedglsl\n#endif\n",
+    },
+    GoldenCase{
+        .name = "comments and strings are not directives",
+        .path = "golden/comments.glsl",
+        .source = "// #pragma once\n/* #include <missing.glsl> */\n#define TEXT \"#pragma once\"\n#pragma onceX\n// #include \"missing.glsl\"\n",
+        .expected = "// #pragma once\n/* #include <missing.glsl> */\n#define TEXT \"#pragma once\"\n#pragma onceX\n// #include \"missing.glsl\"\n",
+    },
+};
+
+template <typename PreprocessFn>
+auto run_benchmark(std::vector<ShaderFileContents> const & files, PreprocessFn && preprocess_fn) -> f64
+{
+    auto const start = std::chrono::steady_clock::now();
+    for (usize i = 0; i < ITERATION_COUNT; ++i)
+    {
+        for (auto const & file : files)
+        {
+            preprocess_fn(file);
+        }
+    }
+    auto const end = std::chrono::steady_clock::now();
+    return std::chrono::duration<f64, std::milli>(end - start).count();
+}
+
+auto main() -> int
+{
+    std::vector<ShaderFileContents> files = {};
+    usize total_size = 0;
+    for (auto const * relative_path : INCLUDE_TREE)
+    {
+        auto path = std::filesystem::path{DAXA_SHADER_INCLUDE_DIR} / relative_path;
+        std::ifstream ifs{path};
+        if (!ifs.good())
+        {
+            std::cerr << "Failed to open " << path << "\n";
+            return -1;
+        }
+        std::string contents{std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
+        total_size += contents.size();
+        files.push_back({.path = path, .contents = std::move(contents)});
+    }
+
+    for (auto const & golden_case : GOLDEN_CASES)
+    {
+        std::string result = golden_case.source;
+        daxa::preprocess_shader_source(result, golden_case.path);
+        if (result != golden_case.expected)
+        {
+            std::cerr << "golden case \"" << golden_case.name << "\" does not match:\n"
+                      << result << "\nexpected:\n"
+                      << golden_case.expected << "\n";
+            return -1;
+        }
+    }
+    // The include tree must preprocess exactly like the previous implementation did.
+    for (auto const & file : files)
+    {
+        std::string regex_result = file.contents;
+        regex_shader_preprocess(regex_result, file.path);
+        std::string result = file.contents;
+        daxa::preprocess_shader_source(result, file.path);
+        if (result != regex_result)
+        {
+            std::cerr << "preprocessing " << file.path << " does not match the std::regex baseline\n";
+            return -1;
+        }
+    }
+
+    // Both sides copy the source and preprocess it in place, nothing else is timed.
+    f64 const regex_ms = run_benchmark(
+        files,
+        [](ShaderFileContents const & file)
+        {
+            auto contents = file.contents;
+            regex_shader_preprocess(contents, file.path);
+        });
+    f64 const single_pass_ms = run_benchmark(
+        files,
+        [](ShaderFileContents const & file)
+        {
+            auto contents = file.contents;
+            daxa::preprocess_shader_source(contents, file.path);
+        });
+
+    f64 const total_mb = static_cast<f64>(total_size * ITERATION_COUNT) / static_cast<f64>(1 << 20);
+    std::cout << "preprocessed " << files.size() << " files (" << total_size << " bytes) " << ITERATION_COUNT << " times\n";
+    std::cout << "  std::regex:  " << regex_ms << " ms (" << total_mb / (regex_ms / 1000.0) << " MiB/s)\n";
+    std::cout << "  single pass: " << single_pass_ms << " ms (" << total_mb / (single_pass_ms / 1000.0) << " MiB/s)\n";
+    std::cout << std::flush;
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include <daxa/daxa.hpp>
+using namespace daxa::types;
+
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#define APPNAME "Daxa API Sample Tracing"
+#define APPNAME_PREFIX(x) ("[" APPNAME "] " x)
+
+namespace tests
+{
+    // Counts the complete events with exactly this name in a chrome trace.
+    auto count_events(std::string const & trace, std::string const & name) -> usize
+    {
+        std::string const pattern = "{\"name\":\"" + name + "\"";
+        usize count = 0;
+        for (usize pos = trace.find(pattern); pos != std::string::npos; pos = trace.find(pattern, pos + pattern.size()))
+        {
+            count += 1;
+        }
+        return count;
+    }
+
+    auto scopes() -> i32
+    {
+        static constexpr u32 THREAD_COUNT = 4;
+        static constexpr u32 SCOPES_PER_THREAD = 5'000;
+        daxa::clear_trace();
+        {
+            DAXA_TRACE_SCOPE("tracing test scope");
+        }
+        // Each thread records into its own buffer, more scopes than fit into one chunk are recorded per thread.
+        std::vector<std::thread> threads = {};
+        for (u32 thread_index = 0; thread_index < THREAD_COUNT; ++thread_index)
+        {
+            threads.emplace_back([]()
+                                 {
+                for (u32 i = 0; i < SCOPES_PER_THREAD; ++i)
+                {
+                    DAXA_TRACE_SCOPE("tracing test thread scope");
+                } });
+        }
+        for (auto & thread : threads)
+        {
+            thread.join();
+        }
+        [[maybe_unused]] std::string const long_name(100, 'x');
+        {
+            DAXA_TRACE_SCOPE(long_name);
+        }
+
+        std::string const trace = daxa::get_chrome_trace();
+#if DAXA_TRACING
+        if (count_events(trace, "tracing test scope") != 1)
+        {
+            std::cerr << "expected one event of the main thread scope\n";
+            return -1;
+        }
+        if (count_events(trace, "tracing test thread scope") != THREAD_COUNT * SCOPES_PER_THREAD)
+        {
+            std::cerr << "expected " << THREAD_COUNT * SCOPES_PER_THREAD << " thread scope events, got " << count_events(trace, "tracing test thread scope") << "\n";
+            return -1;
+        }
+        if (count_events(trace, long_name.substr(0, daxa::TRACE_EVENT_NAME_SIZE - 1)) != 1)
+        {
+            std::cerr << "expected long scope names to be truncated\n";
+            return -1;
+        }
+#else
+        if (trace != "{\"traceEvents\":[\n]}\n")
+        {
+            std::cerr << "expected an empty trace without DAXA_TRACING\n";
+            return -1;
+        }
+#endif
+
+        daxa::clear_trace();
+        if (count_events(daxa::get_chrome_trace(), "tracing test thread scope") != 0)
+        {
+            std::cerr << "expected clear_trace to discard all events\n";
+            return -1;
+        }
+        return 0;
+    }
+
+    auto instrumented_device(daxa::Instance & daxa_ctx) -> i32
+    {
+        daxa::clear_trace();
+        {
+            daxa::Device device = daxa_ctx.create_device({.name = APPNAME_PREFIX("device")});
+            daxa::BufferId const buffer = device.create_buffer({.size = 64, .name = APPNAME_PREFIX("buffer")});
+            auto cmd_list = device.create_command_list({.name = APPNAME_PREFIX("command list")});
+            cmd_list.clear_buffer({.buffer = buffer, .size = 64, .clear_value = 0});
+            cmd_list.destroy_buffer_deferred(buffer);
+            cmd_list.complete();
+            device.submit_commands({.command_lists = {std::move(cmd_list)}});
+            device.wait_idle();
+            device.collect_garbage();
+        }
+        std::string const trace = daxa::get_chrome_trace();
+#if DAXA_TRACING
+        for (auto const * name : {"ImplDevice::new_buffer", "Device::submit_commands", "ImplDevice::main_queue_collect_garbage"})
+        {
+            if (count_events(trace, name) == 0)
+            {
+                std::cerr << "expected the trace to contain " << name << "\n";
+                return -1;
+            }
+        }
+#endif
+
+        auto const trace_path = std::filesystem::temp_directory_path() / "daxa_tracing_test.json";
+        if (!daxa::write_chrome_trace(trace_path))
+        {
+            std::cerr << "failed to write the chrome trace\n";
+            return -1;
+        }
+        std::ifstream ifs{trace_path, std::ios_base::binary};
+        std::string const written_trace{std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
+        ifs.close();
+        std::filesystem::remove(trace_path);
+        if (written_trace != trace)
+        {
+            std::cerr << "the written chrome trace does not match get_chrome_trace\n";
+            return -1;
+        }
+        return 0;
+    }
+} // namespace tests
+
+auto main() -> int
+{
+    std::cout << "tracing enabled: " << DAXA_TRACING << std::endl;
+    if (tests::scopes() != 0)
+    {
+        return -1;
+    }
+    daxa::Instance daxa_ctx = daxa::create_instance({});
+    if (tests::instrumented_device(daxa_ctx) != 0)
+    {
+        return -1;
+    }
+    std::cout << "Success!" << std::endl;
+    return 0;
+}
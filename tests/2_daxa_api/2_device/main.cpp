@@ -1,4 +1,5 @@
 #include <daxa/daxa.hpp>
+#include <fstream>
 #include <iostream>
 
 namespace tests
@@ -34,6 +35,286 @@ namespace tests
         // to discriminate in the GPU selection.
         std::cout << device.properties().device_name << std::endl;
     }
+    void memory_statistics(daxa::Instance & daxa_ctx)
+    {
+        auto device = daxa_ctx.create_device({});
+        auto const before = device.memory_statistics();
+
+        auto buffer = device.create_buffer({.size = 1 << 20, .name = "device local buffer"});
+        auto staging_buffer = device.create_buffer({
+            .size = 1 << 20,
+            .allocate_info = daxa::AutoAllocInfo{daxa::MemoryFlagBits::HOST_ACCESS_SEQUENTIAL_WRITE},
+            .name = "staging buffer",
+        });
+
+        auto const during = device.memory_statistics();
+        DAXA_DBG_ASSERT_TRUE_M(during.buffers.count == before.buffers.count + 1, "device local buffer must be counted");
+        DAXA_DBG_ASSERT_TRUE_M(during.host_accessible_buffers.count == before.host_accessible_buffers.count + 1, "staging buffer must be counted");
+        DAXA_DBG_ASSERT_TRUE_M(during.buffers.bytes >= before.buffers.bytes + (1 << 20), "buffer bytes must at least grow by the buffer size");
+        for (auto const & heap : during.heaps)
+        {
+            std::cout << (heap.device_local ? "device local" : "host") << " heap: " << heap.usage << " / " << heap.budget << " bytes used\n";
+        }
+        std::cout << "fragmentation: " << during.fragmentation << std::endl;
+        DAXA_DBG_ASSERT_TRUE_M(!device.memory_statistics_json().empty(), "json dump must not be empty");
+
+        device.destroy_buffer(buffer);
+        device.destroy_buffer(staging_buffer);
+        device.collect_garbage();
+
+        auto const after = device.memory_statistics();
+        DAXA_DBG_ASSERT_TRUE_M(after.buffers.count == before.buffers.count && after.buffers.bytes == before.buffers.bytes, "destroyed buffers must no longer be counted");
+        DAXA_DBG_ASSERT_TRUE_M(after.host_accessible_buffers.count == before.host_accessible_buffers.count, "destroyed buffers must no longer be counted");
+    }
+    void large_buffer_sizes(daxa::Instance & daxa_ctx)
+    {
+        auto device = daxa_ctx.create_device({});
+        // Querying the requirements does not allocate, so this does not need the memory to be available.
+        usize const size = usize{6} << 30;
+        auto const requirements = device.get_memory_requirements(daxa::BufferInfo{.size = size, .name = "large buffer"});
+        DAXA_DBG_ASSERT_TRUE_M(requirements.size >= size, "buffer sizes above 4 GiB must not be truncated");
+    }
+    void sparse_resources(daxa::Instance & daxa_ctx)
+    {
+        if (!daxa_ctx.create_device({}).sparse_resources_supported())
+        {
+            std::cout << "sparse resources are not supported, skipping the sparse resource test" << std::endl;
+            return;
+        }
+        auto device = daxa_ctx.create_device({.enable_sparse_resources = true});
+        // Sparse buffers only reserve address space, so this does not need 16 GiB of memory.
+        auto sparse_buffer = device.create_buffer({
+            .size = usize{16} << 30,
+            .allocate_info = daxa::SparseAllocInfo{},
+            .name = "sparse buffer",
+        });
+        auto residency = device.sparse_residency(sparse_buffer);
+        DAXA_DBG_ASSERT_TRUE_M(residency.resident_page_count == 0, "sparse buffers must start without memory");
+        std::cout << "sparse buffer pages: " << residency.page_count << " of " << residency.page_size << " bytes" << std::endl;
+
+        // Binds the first and last page, the last page lies above 4 GiB.
+        usize const last_page = residency.page_count - 1;
+        device.bind_sparse_memory({
+            .buffer_binds = {
+                {.buffer = sparse_buffer, .first_page = 0, .page_count = 1},
+                {.buffer = sparse_buffer, .first_page = last_page, .page_count = 1},
+            },
+        });
+        DAXA_DBG_ASSERT_TRUE_M(device.sparse_residency(sparse_buffer).resident_page_count == 2, "bound pages must be resident");
+
+        auto readback_buffer = device.create_buffer({
+            .size = sizeof(u32) * 2,
+            .allocate_info = daxa::AutoAllocInfo{daxa::MemoryFlagBits::HOST_ACCESS_RANDOM},
+            .name = "readback buffer",
+        });
+        {
+            // Submissions after a bind are ordered after it.
+            auto cmd = device.create_command_list({});
+            cmd.clear_buffer({.buffer = sparse_buffer, .offset = 0, .size = residency.page_size, .clear_value = 1});
+            cmd.clear_buffer({.buffer = sparse_buffer, .offset = last_page * residency.page_size, .size = residency.page_size, .clear_value = 2});
+            cmd.pipeline_barrier({
+                .src_access = daxa::AccessConsts::TRANSFER_WRITE,
+                .dst_access = daxa::AccessConsts::TRANSFER_READ,
+            });
+            cmd.copy_buffer_to_buffer({.src_buffer = sparse_buffer, .dst_buffer = readback_buffer, .size = sizeof(u32)});
+            cmd.copy_buffer_to_buffer({.src_buffer = sparse_buffer, .src_offset = last_page * residency.page_size, .dst_buffer = readback_buffer, .dst_offset = sizeof(u32), .size = sizeof(u32)});
+            cmd.pipeline_barrier({
+                .src_access = daxa::AccessConsts::TRANSFER_WRITE,
+                .dst_access = daxa::AccessConsts::HOST_READ,
+            });
+            cmd.complete();
+            device.submit_commands({.command_lists = {std::move(cmd)}});
+        }
+        device.wait_idle();
+        auto const * readback = device.get_host_address_as<u32>(readback_buffer);
+        DAXA_DBG_ASSERT_TRUE_M(readback[0] == 1 && readback[1] == 2, "resident pages must hold their contents");
+
+        device.bind_sparse_memory({
+            .buffer_binds = {{.buffer = sparse_buffer, .first_page = 0, .page_count = residency.page_count, .resident = false}},
+        });
+        DAXA_DBG_ASSERT_TRUE_M(device.sparse_residency(sparse_buffer).resident_page_count == 0, "unbound pages must not be resident");
+
+        device.wait_idle();
+        device.destroy_buffer(readback_buffer);
+        device.destroy_buffer(sparse_buffer);
+        device.collect_garbage();
+    }
+    void defragmentation(daxa::Instance & daxa_ctx)
+    {
+        static constexpr u32 BUFFER_COUNT = 64;
+        static constexpr u32 BUFFER_SIZE = 1 << 16;
+        auto device = daxa_ctx.create_device({});
+
+        // Destroying every other buffer leaves holes between the remaining ones.
+        std::vector<daxa::BufferId> buffers = {};
+        for (u32 i = 0; i < BUFFER_COUNT; ++i)
+        {
+            buffers.push_back(device.create_buffer({.size = BUFFER_SIZE, .name = "buffer " + std::to_string(i)}));
+        }
+        {
+            auto cmd = device.create_command_list({});
+            for (u32 i = 0; i < BUFFER_COUNT; ++i)
+            {
+                cmd.clear_buffer({.buffer = buffers[i], .offset = 0, .size = BUFFER_SIZE, .clear_value = i});
+            }
+            cmd.complete();
+            device.submit_commands({.command_lists = {std::move(cmd)}});
+        }
+        for (u32 i = 0; i < BUFFER_COUNT; i += 2)
+        {
+            device.destroy_buffer(buffers[i]);
+        }
+
+        std::vector<daxa::BufferDeviceAddress> addresses_before = {};
+        for (u32 i = 1; i < BUFFER_COUNT; i += 2)
+        {
+            addresses_before.push_back(device.get_device_address(buffers[i]));
+        }
+
+        // Runs a small pass per iteration, as an application would do once per frame.
+        u32 moved_buffers = 0;
+        for (u32 iteration = 0; iteration < 1000; ++iteration)
+        {
+            auto const result = device.defragment({.max_bytes_per_pass = BUFFER_SIZE * 4, .max_moves_per_pass = 4});
+            moved_buffers += result.moved_buffers;
+            if (result.complete)
+            {
+                break;
+            }
+        }
+        std::cout << "defragmentation moved " << moved_buffers << " buffers" << std::endl;
+        u32 relocated_buffers = 0;
+        for (u32 i = 1; i < BUFFER_COUNT; i += 2)
+        {
+            relocated_buffers += device.get_device_address(buffers[i]) != addresses_before[i / 2] ? 1 : 0;
+        }
+        DAXA_DBG_ASSERT_TRUE_M(moved_buffers > 0 && relocated_buffers > 0, "defragmentation must move buffers out of the holes");
+
+        // Moved buffers keep their ids and contents.
+        auto readback_buffer = device.create_buffer({
+            .size = BUFFER_SIZE * BUFFER_COUNT / 2,
+            .allocate_info = daxa::AutoAllocInfo{daxa::MemoryFlagBits::HOST_ACCESS_RANDOM},
+            .name = "readback buffer",
+        });
+        {
+            auto cmd = device.create_command_list({});
+            for (u32 i = 1; i < BUFFER_COUNT; i += 2)
+            {
+                cmd.copy_buffer_to_buffer({
+                    .src_buffer = buffers[i],
+                    .dst_buffer = readback_buffer,
+                    .dst_offset = (i / 2) * BUFFER_SIZE,
+                    .size = BUFFER_SIZE,
+                });
+            }
+            cmd.complete();
+            device.submit_commands({.command_lists = {std::move(cmd)}});
+        }
+        device.wait_idle();
+        auto const * readback = device.get_host_address_as<u32>(readback_buffer);
+        for (u32 i = 1; i < BUFFER_COUNT; i += 2)
+        {
+            u32 const first_value = readback[(i / 2) * (BUFFER_SIZE / sizeof(u32))];
+            u32 const last_value = readback[(i / 2 + 1) * (BUFFER_SIZE / sizeof(u32)) - 1];
+            DAXA_DBG_ASSERT_TRUE_M(first_value == i && last_value == i, "defragmentation must preserve buffer contents");
+        }
+
+        device.destroy_buffer(readback_buffer);
+        for (u32 i = 1; i < BUFFER_COUNT; i += 2)
+        {
+            device.destroy_buffer(buffers[i]);
+        }
+        device.collect_garbage();
+    }
+    void pipeline_cache(daxa::Instance & daxa_ctx)
+    {
+        auto const cache_path = std::filesystem::temp_directory_path() / "daxa_test_pipeline_cache.bin";
+        std::filesystem::remove(cache_path);
+        {
+            auto device = daxa_ctx.create_device({.pipeline_cache_path = cache_path, .name = "pipeline cache writer"});
+            [[maybe_unused]] bool const written = device.write_pipeline_cache();
+            DAXA_DBG_ASSERT_TRUE_M(written && std::filesystem::exists(cache_path), "pipeline cache file must be written");
+        }
+        // A file with a foreign header is ignored instead of passed to the driver.
+        {
+            std::ofstream ofs{cache_path, std::ios_base::trunc | std::ios_base::binary};
+            std::array<u32, 8> const foreign_header = {32, 1, 0xFFFF'FFFF, 0xFFFF'FFFF, 0, 0, 0, 0};
+            ofs.write(reinterpret_cast<char const *>(foreign_header.data()), sizeof(foreign_header));
+        }
+        {
+            auto device = daxa_ctx.create_device({.pipeline_cache_path = cache_path, .name = "pipeline cache reader"});
+        }
+        DAXA_DBG_ASSERT_TRUE_M(std::filesystem::file_size(cache_path) >= 32, "device destruction must write a valid pipeline cache");
+        std::filesystem::remove(cache_path);
+    }
+    // An empty compute shader, `void main() {}` with a local size of 1.
+    static constexpr auto EMPTY_COMPUTE_SPIRV = std::array<u32, 35>{
+        0x07230203, 0x00010000, 0x00000000, 0x00000005, 0x00000000, // header, id bound 5
+        0x00020011, 0x00000001,                                     // OpCapability Shader
+        0x0003000e, 0x00000000, 0x00000001,                         // OpMemoryModel Logical GLSL450
+        0x0005000f, 0x00000005, 0x00000003, 0x6e69616d, 0x00000000, // OpEntryPoint GLCompute %3 "main"
+        0x00060010, 0x00000003, 0x00000011, 0x00000001, 0x00000001, 0x00000001, // OpExecutionMode %3 LocalSize 1 1 1
+        0x00020013, 0x00000001,                                     // %1 = OpTypeVoid
+        0x00030021, 0x00000002, 0x00000001,                         // %2 = OpTypeFunction %1
+        0x00050036, 0x00000001, 0x00000003, 0x00000000, 0x00000002, // %3 = OpFunction %1 None %2
+        0x000200f8, 0x00000004,                                     // %4 = OpLabel
+        0x000100fd,                                                 // OpReturn
+        0x00010038,                                                 // OpFunctionEnd
+    };
+    void dispatch_once(daxa::Device & device, daxa::ComputePipeline const & pipeline)
+    {
+        auto cmd_list = device.create_command_list({.name = "async pipeline dispatch"});
+        cmd_list.set_pipeline(pipeline);
+        cmd_list.dispatch(1);
+        cmd_list.complete();
+        device.submit_commands({.command_lists = {std::move(cmd_list)}});
+        device.wait_idle();
+        device.collect_garbage();
+    }
+    void async_pipeline_worker_pool(daxa::Instance & daxa_ctx)
+    {
+        // Without an executor, the creations run on the worker threads of the device.
+        auto device = daxa_ctx.create_device({
+            .pipeline_compile_thread_count = 2,
+            .name = "async pipeline worker pool",
+        });
+        std::array<daxa::AsyncComputePipeline, 4> pipelines = {};
+        for (auto & pipeline : pipelines)
+        {
+            pipeline = device.create_compute_pipeline_async({.shader_info = {.byte_code = EMPTY_COMPUTE_SPIRV}, .name = "worker pool pipeline"});
+        }
+        for (auto const & pipeline : pipelines)
+        {
+            daxa::ComputePipeline const & compute_pipeline = pipeline.get();
+            DAXA_DBG_ASSERT_TRUE_M(pipeline.is_ready() && pipeline.try_get() == &compute_pipeline, "pipeline must be ready once get returned");
+            DAXA_DBG_ASSERT_TRUE_M(compute_pipeline.is_valid() && compute_pipeline.info().name == "worker pool pipeline", "async creation must return the requested pipeline");
+            // Async created pipelines are used like any other pipeline.
+            dispatch_once(device, compute_pipeline);
+        }
+    }
+    void async_pipeline_executor(daxa::Instance & daxa_ctx)
+    {
+        // The creations are handed to the user executor and are only run when it decides to.
+        std::vector<std::function<void()>> pending_creations = {};
+        auto device = daxa_ctx.create_device({
+            .pipeline_compile_executor = [&](std::function<void()> creation)
+            { pending_creations.push_back(std::move(creation)); },
+            .name = "async pipeline executor",
+        });
+        daxa::AsyncComputePipeline const empty = {};
+        DAXA_DBG_ASSERT_TRUE_M(!empty.is_ready() && empty.try_get() == nullptr, "default constructed async pipelines are never ready");
+        daxa::AsyncComputePipeline const pipeline = device.create_compute_pipeline_async({.name = "never created"});
+        DAXA_DBG_ASSERT_TRUE_M(pending_creations.size() == 1, "creation must be passed to the executor");
+        DAXA_DBG_ASSERT_TRUE_M(!pipeline.is_ready() && pipeline.try_get() == nullptr, "pipeline must not be ready before the executor runs the creation");
+        // Creations the executor runs produce usable pipelines.
+        daxa::AsyncComputePipeline const executed_pipeline = device.create_compute_pipeline_async({.shader_info = {.byte_code = EMPTY_COMPUTE_SPIRV}, .name = "executed"});
+        DAXA_DBG_ASSERT_TRUE_M(pending_creations.size() == 2 && !executed_pipeline.is_ready(), "creation must be passed to the executor");
+        pending_creations.back()();
+        DAXA_DBG_ASSERT_TRUE_M(executed_pipeline.is_ready() && executed_pipeline.try_get() != nullptr, "pipeline must be ready after the executor ran the creation");
+        dispatch_once(device, executed_pipeline.get());
+        // The device waits for jobs it handed to the executor, the ones never run must be dropped before it is destroyed.
+        pending_creations.clear();
+    }
 } // namespace tests
 
 auto main() -> int
@@ -42,4 +323,11 @@ auto main() -> int
 
     tests::simplest(daxa_ctx);
     tests::device_selection(daxa_ctx);
+    tests::memory_statistics(daxa_ctx);
+    tests::large_buffer_sizes(daxa_ctx);
+    tests::defragmentation(daxa_ctx);
+    tests::sparse_resources(daxa_ctx);
+    tests::pipeline_cache(daxa_ctx);
+    tests::async_pipeline_worker_pool(daxa_ctx);
+    tests::async_pipeline_executor(daxa_ctx);
 }
@@ -323,6 +323,74 @@ namespace tests
         // Collect_garbage loops over all zombie resources and destroys them when they are no longer used on the gpu/ their associated command list finished executing.
         app.device.collect_garbage();
     }
+
+    void queries(App & app)
+    {
+        auto cmd_list = app.device.create_command_list({.name = "queries command list"});
+
+        // Precise occlusion and pipeline statistics queries are optional device features.
+        bool const precise = app.device.precise_occlusion_queries_enabled();
+        bool const statistics = app.device.pipeline_statistics_queries_enabled();
+
+        daxa::QueryPool occlusion_query_pool = app.device.create_query_pool({
+            .query_type = daxa::QueryType::OCCLUSION,
+            .query_count = 1,
+            .name = "occlusion_query",
+        });
+        daxa::QueryPool statistics_query_pool = {};
+        if (statistics)
+        {
+            statistics_query_pool = app.device.create_query_pool({
+                .query_type = daxa::QueryType::PIPELINE_STATISTICS,
+                .pipeline_statistics = daxa::PipelineStatisticFlagBits::COMPUTE_SHADER_INVOCATIONS | daxa::PipelineStatisticFlagBits::FRAGMENT_SHADER_INVOCATIONS,
+                .query_count = 1,
+                .name = "statistics_query",
+            });
+        }
+
+        // Queries must be reset before they can be begun.
+        cmd_list.reset_queries({.query_pool = occlusion_query_pool, .start_index = 0, .count = 1});
+        if (statistics)
+        {
+            cmd_list.reset_queries({.query_pool = statistics_query_pool, .start_index = 0, .count = 1});
+        }
+
+        // All draws and dispatches recorded between begin and end query are counted.
+        cmd_list.begin_query({.query_pool = occlusion_query_pool, .query_index = 0, .precise = precise});
+        cmd_list.end_query({.query_pool = occlusion_query_pool, .query_index = 0});
+        if (statistics)
+        {
+            cmd_list.begin_query({.query_pool = statistics_query_pool, .query_index = 0});
+            cmd_list.end_query({.query_pool = statistics_query_pool, .query_index = 0});
+        }
+
+        cmd_list.complete();
+
+        app.device.submit_commands({
+            .command_lists = {cmd_list},
+        });
+
+        // Querying results never blocks, queries that are not done yet simply report as unavailable.
+        [[maybe_unused]] bool const maybe_available = occlusion_query_pool.is_query_available(0);
+
+        app.device.wait_idle();
+
+        if (statistics)
+        {
+            // Each query writes result_stride() values: the results followed by an availability value.
+            std::array<u64, 3> statistics_results = {};
+            DAXA_DBG_ASSERT_TRUE_M(statistics_query_pool.result_stride() == statistics_results.size(), "expected two statistics and one availability value");
+            bool const statistics_available = statistics_query_pool.get_query_results(0, 1, statistics_results);
+            DAXA_DBG_ASSERT_TRUE_M(statistics_available && statistics_results[2] != 0, "statistics query must be available after wait idle");
+            DAXA_DBG_ASSERT_TRUE_M(statistics_results[0] == 0 && statistics_results[1] == 0, "no shader invocations were recorded");
+        }
+
+        std::array<u64, 2> occlusion_results = {};
+        bool const occlusion_available = occlusion_query_pool.get_query_results(0, 1, occlusion_results);
+        DAXA_DBG_ASSERT_TRUE_M(occlusion_available && occlusion_results[0] == 0, "no samples were drawn");
+
+        app.device.collect_garbage();
+    }
 } // namespace tests
 
 auto main() -> int
@@ -331,4 +399,5 @@ auto main() -> int
     tests::simplest(app);
     tests::copy(app);
     tests::deferred_destruction(app);
+    tests::queries(app);
 }
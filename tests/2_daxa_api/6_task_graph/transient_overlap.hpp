@@ -23,7 +23,7 @@ namespace tests
             reinterpret_cast<u32 *>(staging.host_address)[x] = value;
         }
         cmd.copy_buffer_to_buffer({
-            .src_buffer = ti.get_allocator().get_buffer(),
+            .src_buffer = staging.buffer,
             .src_offset = staging.buffer_offset,
             .dst_buffer = ti.uses[buffer].buffer(),
             .size = size * sizeof(u32),
@@ -68,7 +68,7 @@ namespace tests
             }
         }
         cmd.copy_buffer_to_image({
-            .buffer = ti.get_allocator().get_buffer(),
+            .buffer = staging.buffer,
             .buffer_offset = staging.buffer_offset,
             .image = ti.uses[image].image(),
             .image_extent = {size.x, size.y, size.z},
@@ -4,6 +4,7 @@ using namespace daxa::types;
 #include <daxa/utils/pipeline_manager.hpp>
 
 #include <iostream>
+#include <fstream>
 #include <thread>
 
 #define APPNAME "Daxa API Sample Pipeline Compiler"
@@ -176,6 +177,41 @@ namespace tests
         return 0;
     }
 
+    // Records a draw with the pipeline into a small color target and waits for it, so that binding the pipeline is tested too.
+    void draw_once(daxa::Device & device, daxa::RasterPipeline const & pipeline, std::function<void(daxa::CommandList &)> const & record_state = {})
+    {
+        static constexpr u32 TARGET_SIZE = 64;
+        daxa::ImageId const color_target = device.create_image({
+            .format = daxa::Format::R8G8B8A8_UNORM,
+            .size = {TARGET_SIZE, TARGET_SIZE, 1},
+            .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT,
+            .name = APPNAME_PREFIX("color_target"),
+        });
+        auto cmd_list = device.create_command_list({.name = APPNAME_PREFIX("draw_once")});
+        cmd_list.pipeline_barrier_image_transition({
+            .dst_access = daxa::AccessConsts::COLOR_ATTACHMENT_OUTPUT_WRITE,
+            .src_layout = daxa::ImageLayout::UNDEFINED,
+            .dst_layout = daxa::ImageLayout::ATTACHMENT_OPTIMAL,
+            .image_id = color_target,
+        });
+        cmd_list.begin_renderpass({
+            .color_attachments = {{.image_view = color_target.default_view(), .load_op = daxa::AttachmentLoadOp::CLEAR}},
+            .render_area = {.x = 0, .y = 0, .width = TARGET_SIZE, .height = TARGET_SIZE},
+        });
+        cmd_list.set_pipeline(pipeline);
+        if (record_state)
+        {
+            record_state(cmd_list);
+        }
+        cmd_list.draw({.vertex_count = 3});
+        cmd_list.end_renderpass();
+        cmd_list.destroy_image_deferred(color_target);
+        cmd_list.complete();
+        device.submit_commands({.command_lists = {std::move(cmd_list)}});
+        device.wait_idle();
+        device.collect_garbage();
+    }
+
     auto tesselation_shaders(daxa::Device & device) -> i32
     {
         daxa::PipelineManager pipeline_manager = daxa::PipelineManager({
@@ -211,6 +247,675 @@ namespace tests
         return 0;
     }
 
+    auto raster_draw(daxa::Device & device) -> i32
+    {
+        daxa::PipelineManager pipeline_manager = daxa::PipelineManager({
+            .device = device,
+            .shader_compile_options = {
+                .root_paths = {
+                    DAXA_SHADER_INCLUDE_DIR,
+                    DAXA_SAMPLE_PATH "/shaders/test",
+                },
+                .language = daxa::ShaderLanguage::GLSL,
+            },
+            .name = APPNAME_PREFIX("pipeline_manager"),
+        });
+
+        auto compilation_result = pipeline_manager.add_raster_pipeline({
+            .vertex_shader_info = daxa::ShaderCompileInfo{.source = daxa::ShaderFile{"tesselation_test.glsl"}},
+            .tesselation_control_shader_info = daxa::ShaderCompileInfo{.source = daxa::ShaderFile{"tesselation_test.glsl"}},
+            .tesselation_evaluation_shader_info = daxa::ShaderCompileInfo{.source = daxa::ShaderFile{"tesselation_test.glsl"}},
+            .fragment_shader_info = daxa::ShaderCompileInfo{.source = daxa::ShaderFile{"tesselation_test.glsl"}},
+            .color_attachments = {{.format = daxa::Format::R8G8B8A8_UNORM}},
+            .raster = {.primitive_topology = daxa::PrimitiveTopology::PATCH_LIST},
+            .tesselation = {.control_points = 3},
+            .name = APPNAME_PREFIX("raster_draw_pipeline"),
+        });
+
+        if (compilation_result.is_err())
+        {
+            std::cerr << "Failed to compile the raster_draw_pipeline!\n";
+            std::cerr << compilation_result.message() << std::endl;
+            return -1;
+        }
+
+        // Shader object pipelines set all of their state when they are bound.
+        draw_once(device, *compilation_result.value());
+
+        return 0;
+    }
+
+    auto pipeline_library_reuse(daxa::Device & device) -> i32
+    {
+        if (!device.graphics_pipeline_library_enabled())
+        {
+            return 0;
+        }
+        daxa::PipelineManager pipeline_manager = daxa::PipelineManager({
+            .device = device,
+            .shader_compile_options = {
+                .root_paths = {
+                    DAXA_SHADER_INCLUDE_DIR,
+                    DAXA_SAMPLE_PATH "/shaders/test",
+                },
+                .language = daxa::ShaderLanguage::GLSL,
+            },
+            .name = APPNAME_PREFIX("pipeline_manager"),
+        });
+        auto const pipeline_info = [](char const * name)
+        {
+            return daxa::RasterPipelineCompileInfo{
+                .vertex_shader_info = daxa::ShaderCompileInfo{.source = daxa::ShaderFile{"tesselation_test.glsl"}},
+                .tesselation_control_shader_info = daxa::ShaderCompileInfo{.source = daxa::ShaderFile{"tesselation_test.glsl"}},
+                .tesselation_evaluation_shader_info = daxa::ShaderCompileInfo{.source = daxa::ShaderFile{"tesselation_test.glsl"}},
+                .fragment_shader_info = daxa::ShaderCompileInfo{.source = daxa::ShaderFile{"tesselation_test.glsl"}},
+                .color_attachments = {{.format = daxa::Format::R8G8B8A8_UNORM}},
+                .raster = {.primitive_topology = daxa::PrimitiveTopology::PATCH_LIST},
+                .tesselation = {.control_points = 3},
+                .name = name,
+            };
+        };
+
+        u32 const library_count_before = device.pipeline_library_count();
+        auto first_result = pipeline_manager.add_raster_pipeline(pipeline_info(APPNAME_PREFIX("first_library_pipeline")));
+        u32 const library_count_first = device.pipeline_library_count();
+        auto second_result = pipeline_manager.add_raster_pipeline(pipeline_info(APPNAME_PREFIX("second_library_pipeline")));
+        u32 const library_count_second = device.pipeline_library_count();
+        if (first_result.is_err() || second_result.is_err())
+        {
+            std::cerr << "Failed to compile the library pipelines!\n";
+            return -1;
+        }
+        if (library_count_first <= library_count_before)
+        {
+            std::cerr << "the first pipeline did not create any pipeline library part\n";
+            return -1;
+        }
+        if (library_count_second != library_count_first)
+        {
+            std::cerr << "a pipeline with the same state created " << library_count_second - library_count_first << " new pipeline library parts instead of reusing the cached ones\n";
+            return -1;
+        }
+
+        // The parts are evicted once the last pipeline linked from them is gone.
+        std::shared_ptr<daxa::RasterPipeline> first = first_result.value();
+        std::shared_ptr<daxa::RasterPipeline> second = second_result.value();
+        pipeline_manager.remove_raster_pipeline(first);
+        first.reset();
+        if (device.pipeline_library_count() != library_count_first)
+        {
+            std::cerr << "pipeline library parts were evicted while a pipeline still uses them\n";
+            return -1;
+        }
+        pipeline_manager.remove_raster_pipeline(second);
+        second.reset();
+        if (device.pipeline_library_count() != library_count_before)
+        {
+            std::cerr << "pipeline library parts were not evicted after their last pipeline was destroyed\n";
+            return -1;
+        }
+        device.collect_garbage();
+
+        return 0;
+    }
+
+    auto specialization_constants(daxa::Device & device) -> i32
+    {
+        daxa::PipelineManager pipeline_manager = daxa::PipelineManager({
+            .device = device,
+            .shader_compile_options = {
+                .language = daxa::ShaderLanguage::GLSL,
+            },
+            .name = APPNAME_PREFIX("pipeline_manager"),
+        });
+
+        pipeline_manager.add_virtual_file({
+            .name = "specialized",
+            .contents = R"glsl(
+                layout(constant_id = 0) const uint WORKGROUP_SIZE = 64;
+                layout(constant_id = 1) const bool ENABLE_FEATURE = false;
+                layout(constant_id = 2) const float SCALE = 1.0;
+
+                layout(local_size_x_id = 0, local_size_y = 1, local_size_z = 1) in;
+                void main() {
+                    float value = SCALE;
+                    if (ENABLE_FEATURE) {
+                        value *= 2.0;
+                    }
+                }
+            )glsl",
+        });
+
+        // Both variants are created from the same shader source, only the constants differ.
+        for (u32 const workgroup_size : {32u, 256u})
+        {
+            auto compilation_result = pipeline_manager.add_compute_pipeline({
+                .shader_info = {
+                    .source = daxa::ShaderFile{"specialized"},
+                    .specialization_constants = {
+                        {.constant_id = 0, .value = workgroup_size},
+                        {.constant_id = 1, .value = true},
+                        {.constant_id = 2, .value = 0.5f},
+                    },
+                },
+                .name = APPNAME_PREFIX("specialized_compute_pipeline"),
+            });
+
+            if (compilation_result.is_err())
+            {
+                std::cerr << "Failed to compile the specialized_compute_pipeline!\n";
+                std::cerr << compilation_result.message() << std::endl;
+                return -1;
+            }
+            if (compilation_result.value()->info().shader_info.specialization_constants.size() != 3)
+            {
+                std::cerr << "Specialization constants were not passed to the pipeline!\n";
+                return -1;
+            }
+        }
+
+        return 0;
+    }
+
+    auto dynamic_state(daxa::Device & device) -> i32
+    {
+        daxa::PipelineManager pipeline_manager = daxa::PipelineManager({
+            .device = device,
+            .shader_compile_options = {
+                .root_paths = {
+                    DAXA_SHADER_INCLUDE_DIR,
+                    DAXA_SAMPLE_PATH "/shaders/test",
+                },
+                .language = daxa::ShaderLanguage::GLSL,
+            },
+            .name = APPNAME_PREFIX("pipeline_manager"),
+        });
+
+        // One pipeline serves all depth test, culling and winding combinations, they are set with the command list setters.
+        auto compilation_result = pipeline_manager.add_raster_pipeline({
+            .vertex_shader_info = daxa::ShaderCompileInfo{.source = daxa::ShaderFile{"tesselation_test.glsl"}},
+            .tesselation_control_shader_info = daxa::ShaderCompileInfo{.source = daxa::ShaderFile{"tesselation_test.glsl"}},
+            .tesselation_evaluation_shader_info = daxa::ShaderCompileInfo{.source = daxa::ShaderFile{"tesselation_test.glsl"}},
+            .fragment_shader_info = daxa::ShaderCompileInfo{.source = daxa::ShaderFile{"tesselation_test.glsl"}},
+            .color_attachments = {{.format = daxa::Format::R8G8B8A8_UNORM}},
+            .raster = {.primitive_topology = daxa::PrimitiveTopology::PATCH_LIST},
+            .tesselation = {.control_points = 3},
+            .dynamic_state =
+                daxa::RasterDynamicStateFlagBits::DEPTH_TEST |
+                daxa::RasterDynamicStateFlagBits::CULL_MODE |
+                daxa::RasterDynamicStateFlagBits::FRONT_FACE |
+                daxa::RasterDynamicStateFlagBits::PRIMITIVE_TOPOLOGY |
+                daxa::RasterDynamicStateFlagBits::PRIMITIVE_RESTART_ENABLE |
+                daxa::RasterDynamicStateFlagBits::DEPTH_BIAS_ENABLE,
+            .name = APPNAME_PREFIX("dynamic_state_pipeline"),
+        });
+
+        if (compilation_result.is_err())
+        {
+            std::cerr << "Failed to compile the dynamic_state_pipeline!\n";
+            std::cerr << compilation_result.message() << std::endl;
+            return -1;
+        }
+
+        // The dynamic state must be set after every set_pipeline, each draw uses a different combination.
+        for (u32 variant = 0; variant < 2; ++variant)
+        {
+            bool const flip = variant == 1;
+            draw_once(
+                device, *compilation_result.value(),
+                [&](daxa::CommandList & cmd_list)
+                {
+                    cmd_list.set_depth_test_enable(flip);
+                    cmd_list.set_depth_write_enable(flip);
+                    cmd_list.set_depth_compare_op(flip ? daxa::CompareOp::GREATER : daxa::CompareOp::LESS_OR_EQUAL);
+                    cmd_list.set_cull_mode(flip ? daxa::FaceCullFlagBits::BACK_BIT : daxa::FaceCullFlagBits::NONE);
+                    cmd_list.set_front_face(flip ? daxa::FrontFaceWinding::CLOCKWISE : daxa::FrontFaceWinding::COUNTER_CLOCKWISE);
+                    // Patch lists can only be switched to other patch lists, and never use primitive restart.
+                    cmd_list.set_primitive_topology(daxa::PrimitiveTopology::PATCH_LIST);
+                    cmd_list.set_primitive_restart_enable(false);
+                    cmd_list.set_depth_bias_enable(flip);
+                });
+        }
+
+        if (!device.extended_dynamic_state_3_enabled())
+        {
+            return 0;
+        }
+        auto extended_compilation_result = pipeline_manager.add_raster_pipeline({
+            .vertex_shader_info = daxa::ShaderCompileInfo{.source = daxa::ShaderFile{"tesselation_test.glsl"}},
+            .tesselation_control_shader_info = daxa::ShaderCompileInfo{.source = daxa::ShaderFile{"tesselation_test.glsl"}},
+            .tesselation_evaluation_shader_info = daxa::ShaderCompileInfo{.source = daxa::ShaderFile{"tesselation_test.glsl"}},
+            .fragment_shader_info = daxa::ShaderCompileInfo{.source = daxa::ShaderFile{"tesselation_test.glsl"}},
+            .color_attachments = {{.format = daxa::Format::R8G8B8A8_UNORM}},
+            .raster = {.primitive_topology = daxa::PrimitiveTopology::PATCH_LIST},
+            .tesselation = {.control_points = 3},
+            .dynamic_state =
+                daxa::RasterDynamicStateFlagBits::POLYGON_MODE |
+                daxa::RasterDynamicStateFlagBits::COLOR_BLEND |
+                daxa::RasterDynamicStateFlagBits::DEPTH_CLAMP_ENABLE,
+            .name = APPNAME_PREFIX("extended_dynamic_state_pipeline"),
+        });
+
+        if (extended_compilation_result.is_err())
+        {
+            std::cerr << "Failed to compile the extended_dynamic_state_pipeline!\n";
+            std::cerr << extended_compilation_result.message() << std::endl;
+            return -1;
+        }
+
+        draw_once(
+            device, *extended_compilation_result.value(),
+            [](daxa::CommandList & cmd_list)
+            {
+                cmd_list.set_polygon_mode(daxa::PolygonMode::LINE);
+                auto const blends = std::array{
+                    daxa::BlendInfo{
+                        .blend_enable = true,
+                        .src_color_blend_factor = daxa::BlendFactor::SRC_ALPHA,
+                        .dst_color_blend_factor = daxa::BlendFactor::ONE_MINUS_SRC_ALPHA,
+                    },
+                };
+                cmd_list.set_color_blend(0, blends);
+                cmd_list.set_depth_clamp_enable(true);
+            });
+
+        return 0;
+    }
+
+    auto batch_compile(daxa::Device & device) -> i32
+    {
+        daxa::PipelineManager pipeline_manager = daxa::PipelineManager({
+            .device = device,
+            .shader_compile_options = {
+                .language = daxa::ShaderLanguage::GLSL,
+            },
+            .compile_thread_count = 4,
+            .name = APPNAME_PREFIX("pipeline_manager"),
+        });
+
+        pipeline_manager.add_virtual_file({
+            .name = "batch_include",
+            .contents = R"glsl(
+                #pragma once
+                #if defined(BATCH_FAIL)
+                #error This pipeline is meant to fail
+                #endif
+            )glsl",
+        });
+
+        pipeline_manager.add_virtual_file({
+            .name = "batch_file",
+            .contents = R"glsl(
+                #include <batch_include>
+                layout(local_size_x = 1, local_size_y = 1, local_size_z = 1) in;
+                void main() {
+                }
+            )glsl",
+        });
+
+        static constexpr usize PIPELINE_COUNT = 8;
+        static constexpr usize FAILING_PIPELINE_INDEX = 5;
+        auto infos = std::vector<daxa::ComputePipelineCompileInfo>{};
+        for (usize i = 0; i < PIPELINE_COUNT; ++i)
+        {
+            auto defines = std::vector<daxa::ShaderDefine>{{.name = "BATCH_INDEX", .value = std::to_string(i)}};
+            if (i == FAILING_PIPELINE_INDEX)
+            {
+                defines.push_back({.name = "BATCH_FAIL"});
+            }
+            infos.push_back({
+                .shader_info = {.source = daxa::ShaderFile{"batch_file"}, .compile_options = {.defines = defines}},
+                .name = std::string("batch_pipeline_") + std::to_string(i),
+            });
+        }
+
+        // The results are in the order of the infos, no matter which thread compiled which pipeline.
+        auto compilation_results = pipeline_manager.add_compute_pipelines(infos);
+        if (compilation_results.size() != PIPELINE_COUNT)
+        {
+            std::cerr << "Expected one result per pipeline!\n";
+            return -1;
+        }
+        for (usize i = 0; i < PIPELINE_COUNT; ++i)
+        {
+            if (compilation_results[i].is_ok() == (i == FAILING_PIPELINE_INDEX))
+            {
+                std::cerr << "Unexpected compile result for batch_pipeline_" << i << "\n";
+                std::cerr << compilation_results[i].message() << std::endl;
+                return -1;
+            }
+            if (compilation_results[i].is_ok() && compilation_results[i].value()->info().name != infos[i].name)
+            {
+                std::cerr << "Batch results are out of order!\n";
+                return -1;
+            }
+        }
+
+        // Touching the common include recompiles all registered pipelines in parallel.
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        pipeline_manager.add_virtual_file({
+            .name = "batch_include",
+            .contents = R"glsl(
+                #pragma once
+                #define BATCH_RELOADED
+            )glsl",
+        });
+        auto reload_result = pipeline_manager.reload_all();
+        if (!std::holds_alternative<daxa::PipelineReloadSuccess>(reload_result))
+        {
+            std::cerr << "Failed to reload the batch pipelines!\n";
+            if (auto const * reload_err = std::get_if<daxa::PipelineReloadError>(&reload_result))
+            {
+                std::cerr << reload_err->message << std::endl;
+            }
+            return -1;
+        }
+
+        return 0;
+    }
+
+    auto spirv_cache(daxa::Device & device) -> i32
+    {
+        auto const cache_path = std::filesystem::temp_directory_path() / "daxa_spirv_cache_test";
+        std::filesystem::remove_all(cache_path);
+
+        auto count_cache_entries = [&]()
+        {
+            usize count = 0;
+            for (auto const & entry : std::filesystem::directory_iterator{cache_path})
+            {
+                count += entry.path().extension() == ".spv" ? 1 : 0;
+            }
+            return count;
+        };
+
+        // Returns the number of cache hits, or nothing when the compilation failed.
+        auto compile = [&](std::string const & include_contents) -> std::optional<u64>
+        {
+            // Each manager starts without in memory state, so hits can only come from the disk cache.
+            daxa::PipelineManager pipeline_manager = daxa::PipelineManager({
+                .device = device,
+                .shader_compile_options = {
+                    .language = daxa::ShaderLanguage::GLSL,
+                },
+                .spirv_cache_path = cache_path,
+                .name = APPNAME_PREFIX("pipeline_manager"),
+            });
+            pipeline_manager.add_virtual_file({.name = "cached_include", .contents = include_contents});
+            pipeline_manager.add_virtual_file({
+                .name = "cached_file",
+                .contents = R"glsl(
+                    #include <cached_include>
+                    layout(local_size_x = WORKGROUP_SIZE, local_size_y = 1, local_size_z = 1) in;
+                    void main() {
+                    }
+                )glsl",
+            });
+            auto compilation_result = pipeline_manager.add_compute_pipeline({
+                .shader_info = {.source = daxa::ShaderFile{"cached_file"}},
+                .name = APPNAME_PREFIX("cached_compute_pipeline"),
+            });
+            if (compilation_result.is_err())
+            {
+                std::cerr << "Failed to compile the cached_compute_pipeline!\n";
+                std::cerr << compilation_result.message() << std::endl;
+                return std::nullopt;
+            }
+            return pipeline_manager.spirv_cache_hit_count();
+        };
+
+        if (compile("#define WORKGROUP_SIZE 32\n") != 0u || count_cache_entries() != 1)
+        {
+            std::cerr << "Expected the first compilation to store one cache entry!\n";
+            return -1;
+        }
+        if (compile("#define WORKGROUP_SIZE 32\n") != 1u || count_cache_entries() != 1)
+        {
+            std::cerr << "Expected the second compilation to hit the cache!\n";
+            return -1;
+        }
+        // The file name is only a hash, entries whose stored key does not match must be recompiled.
+        for (auto const & entry : std::filesystem::directory_iterator{cache_path})
+        {
+            if (entry.path().extension() == ".spv")
+            {
+                // The stored key precedes the spirv words, so the first "main" in the file is part of the key.
+                std::fstream fs{entry.path(), std::ios_base::in | std::ios_base::out | std::ios_base::binary};
+                std::string const contents{std::istreambuf_iterator<char>(fs), std::istreambuf_iterator<char>()};
+                auto const key_offset = contents.find("main");
+                if (key_offset == std::string::npos)
+                {
+                    std::cerr << "Expected the cache entry to store its key!\n";
+                    return -1;
+                }
+                fs.clear();
+                fs.seekp(static_cast<std::streamoff>(key_offset));
+                fs.put('X');
+            }
+        }
+        if (compile("#define WORKGROUP_SIZE 32\n") != 0u || count_cache_entries() != 1)
+        {
+            std::cerr << "Expected an entry with a different stored key to be recompiled!\n";
+            return -1;
+        }
+        // A changed include changes the preprocessed source and with it the cache key.
+        if (compile("#define WORKGROUP_SIZE 64\n") != 0u || count_cache_entries() != 2)
+        {
+            std::cerr << "Expected a changed include to store a new cache entry!\n";
+            return -1;
+        }
+
+        std::filesystem::remove_all(cache_path);
+        return 0;
+    }
+
+    auto file_watcher(daxa::Device & device) -> i32
+    {
+        auto const shader_folder = std::filesystem::temp_directory_path() / "daxa_file_watcher_test";
+        std::filesystem::create_directories(shader_folder);
+        auto write_shader = [&](u32 workgroup_size)
+        {
+            auto ofs = std::ofstream{shader_folder / "watched.glsl", std::ios_base::trunc};
+            ofs << "layout(local_size_x = " << workgroup_size << ", local_size_y = 1, local_size_z = 1) in;\nvoid main() {}\n";
+        };
+        write_shader(32);
+
+        daxa::PipelineManager pipeline_manager = daxa::PipelineManager({
+            .device = device,
+            .shader_compile_options = {
+                .root_paths = {shader_folder},
+                .language = daxa::ShaderLanguage::GLSL,
+            },
+            .enable_file_watcher = true,
+            .name = APPNAME_PREFIX("pipeline_manager"),
+        });
+
+        auto compilation_result = pipeline_manager.add_compute_pipeline({
+            .shader_info = {.source = daxa::ShaderFile{"watched.glsl"}},
+            .name = APPNAME_PREFIX("watched_compute_pipeline"),
+        });
+        if (compilation_result.is_err())
+        {
+            std::cerr << "Failed to compile the watched_compute_pipeline!\n";
+            std::cerr << compilation_result.message() << std::endl;
+            return -1;
+        }
+        if (!std::holds_alternative<daxa::NoPipelineChanged>(pipeline_manager.reload_all()))
+        {
+            std::cerr << "Expected no reload without file changes!\n";
+            return -1;
+        }
+
+        // File events arrive asynchronously, on platforms without a watcher the write times are polled instead.
+        using namespace std::literals;
+        std::this_thread::sleep_for(300ms);
+        write_shader(64);
+        auto const start = std::chrono::steady_clock::now();
+        while (true)
+        {
+            auto reload_result = pipeline_manager.reload_all();
+            if (std::holds_alternative<daxa::PipelineReloadSuccess>(reload_result))
+            {
+                break;
+            }
+            if (auto const * reload_err = std::get_if<daxa::PipelineReloadError>(&reload_result))
+            {
+                std::cerr << reload_err->message << std::endl;
+                return -1;
+            }
+            if (std::chrono::steady_clock::now() - start > 5s)
+            {
+                std::cerr << "The changed file was never reloaded!\n";
+                return -1;
+            }
+            std::this_thread::sleep_for(1ms);
+        }
+
+        std::filesystem::remove_all(shader_folder);
+        return 0;
+    }
+
+    auto dependency_graph(daxa::Device & device) -> i32
+    {
+        daxa::PipelineManager pipeline_manager = daxa::PipelineManager({
+            .device = device,
+            .shader_compile_options = {
+                .language = daxa::ShaderLanguage::GLSL,
+            },
+            .name = APPNAME_PREFIX("pipeline_manager"),
+        });
+
+        pipeline_manager.add_virtual_file({.name = "common_header", .contents = "#pragma once\n#define COMMON_VALUE 1\n"});
+        pipeline_manager.add_virtual_file({.name = "middle_header", .contents = "#pragma once\n#include <common_header>\n"});
+        pipeline_manager.add_virtual_file({.name = "unused_header", .contents = "#pragma once\n"});
+        pipeline_manager.add_virtual_file({
+            .name = "direct_file",
+            .contents = "#include <common_header>\nlayout(local_size_x = 1) in;\nvoid main() {}\n",
+        });
+        pipeline_manager.add_virtual_file({
+            .name = "transitive_file",
+            .contents = "#include <middle_header>\nlayout(local_size_x = 1) in;\nvoid main() {}\n",
+        });
+
+        auto direct_result = pipeline_manager.add_compute_pipeline({
+            .shader_info = {.source = daxa::ShaderFile{"direct_file"}},
+            .name = APPNAME_PREFIX("direct_pipeline"),
+        });
+        auto transitive_result = pipeline_manager.add_compute_pipeline({
+            .shader_info = {.source = daxa::ShaderFile{"transitive_file"}},
+            .name = APPNAME_PREFIX("transitive_pipeline"),
+        });
+        if (direct_result.is_err() || transitive_result.is_err())
+        {
+            std::cerr << "Failed to compile the dependency graph pipelines!\n";
+            std::cerr << direct_result.message() << transitive_result.message() << std::endl;
+            return -1;
+        }
+
+        auto common_dependents = pipeline_manager.pipelines_depending_on("common_header");
+        auto middle_dependents = pipeline_manager.pipelines_depending_on("middle_header");
+        bool const graph_valid =
+            common_dependents.compute_pipelines.size() == 2 &&
+            common_dependents.compute_pipelines[0] == direct_result.value() &&
+            common_dependents.compute_pipelines[1] == transitive_result.value() &&
+            middle_dependents.compute_pipelines.size() == 1 &&
+            middle_dependents.compute_pipelines[0] == transitive_result.value() &&
+            pipeline_manager.pipelines_depending_on("unused_header").compute_pipelines.empty();
+        if (!graph_valid)
+        {
+            std::cerr << "The dependency graph does not match the includes!\n";
+            return -1;
+        }
+
+        pipeline_manager.remove_compute_pipeline(transitive_result.value());
+        if (!pipeline_manager.pipelines_depending_on("middle_header").compute_pipelines.empty())
+        {
+            std::cerr << "Removed pipelines must leave the dependency graph!\n";
+            return -1;
+        }
+
+        return 0;
+    }
+
+    auto background_reload(daxa::Device & device) -> i32
+    {
+        daxa::PipelineManager pipeline_manager = daxa::PipelineManager({
+            .device = device,
+            .shader_compile_options = {
+                .language = daxa::ShaderLanguage::GLSL,
+            },
+            .enable_background_reload = true,
+            .background_reload_interval = std::chrono::milliseconds{10},
+            .name = APPNAME_PREFIX("pipeline_manager"),
+        });
+        auto write_shader = [&](std::string const & body)
+        {
+            pipeline_manager.add_virtual_file({.name = "background_file", .contents = body});
+        };
+        write_shader("layout(local_size_x = 32) in;\nvoid main() {}\n");
+
+        auto compilation_result = pipeline_manager.add_compute_pipeline({
+            .shader_info = {.source = daxa::ShaderFile{"background_file"}},
+            .name = APPNAME_PREFIX("background_compute_pipeline"),
+        });
+        if (compilation_result.is_err())
+        {
+            std::cerr << "Failed to compile the background_compute_pipeline!\n";
+            std::cerr << compilation_result.message() << std::endl;
+            return -1;
+        }
+        auto const & pipeline = compilation_result.value();
+        // Holding a reference keeps the old pipeline alive, so a swapped in pipeline can never reuse its address.
+        daxa::ComputePipeline const first_pipeline = *pipeline;
+
+        // The new pipeline is swapped into the existing pipeline object once it finished compiling in the background.
+        // The reload interval and throttling only delay the swap, so the test waits for it instead of sleeping.
+        using namespace std::literals;
+        write_shader("layout(local_size_x = 64) in;\nvoid main() {}\n");
+        auto start = std::chrono::steady_clock::now();
+        while (!pipeline_manager.apply_background_reloads())
+        {
+            if (std::chrono::steady_clock::now() - start > 5s)
+            {
+                std::cerr << "The changed virtual file was never reloaded in the background!\n";
+                return -1;
+            }
+            std::this_thread::sleep_for(1ms);
+        }
+        if (auto reload_errors = pipeline_manager.pop_reload_errors(); !reload_errors.empty())
+        {
+            std::cerr << reload_errors.front().message << std::endl;
+            return -1;
+        }
+        if (!pipeline->is_valid() || pipeline->object == first_pipeline.object)
+        {
+            std::cerr << "The background reload did not swap in the recompiled pipeline!\n";
+            return -1;
+        }
+        daxa::ComputePipeline const reloaded_pipeline = *pipeline;
+
+        // Failed compilations are queued and keep the old pipeline.
+        write_shader("#error background reload error\nlayout(local_size_x = 64) in;\nvoid main() {}\n");
+        start = std::chrono::steady_clock::now();
+        while (pipeline_manager.pop_reload_errors().empty())
+        {
+            if (std::chrono::steady_clock::now() - start > 5s)
+            {
+                std::cerr << "The failed background reload was never reported!\n";
+                return -1;
+            }
+            pipeline_manager.apply_background_reloads();
+            std::this_thread::sleep_for(1ms);
+        }
+        if (!pipeline->is_valid() || pipeline->object != reloaded_pipeline.object)
+        {
+            std::cerr << "A failed background reload must keep the old pipeline!\n";
+            return -1;
+        }
+
+        return 0;
+    }
+
     auto multi_thread(daxa::Device & device) -> i32
     {
         auto test_wrapper_0 = [](daxa::Device & a_device, i32 & ret)
@@ -277,14 +982,92 @@ auto main() -> int
     {
         return ret;
     }
+    if (ret = tests::dynamic_state(device); ret != 0)
+    {
+        return ret;
+    }
+    if (ret = tests::specialization_constants(device); ret != 0)
+    {
+        return ret;
+    }
     if (ret = tests::perf(device); ret != 0)
     {
         return ret;
     }
+    if (ret = tests::batch_compile(device); ret != 0)
+    {
+        return ret;
+    }
+
+    if (ret = tests::spirv_cache(device); ret != 0)
+    {
+        return ret;
+    }
+
+    if (ret = tests::file_watcher(device); ret != 0)
+    {
+        return ret;
+    }
+
+    if (ret = tests::dependency_graph(device); ret != 0)
+    {
+        return ret;
+    }
+
+    if (ret = tests::background_reload(device); ret != 0)
+    {
+        return ret;
+    }
+
     if (ret = tests::multi_thread(device); ret != 0)
     {
         return ret;
     }
+    // Raster pipelines are created as shader objects when the device supports them, regular pipelines otherwise.
+    {
+        daxa::Device shader_object_device = daxa_ctx.create_device({
+            .enable_shader_object = true,
+            .name = APPNAME_PREFIX("shader object device"),
+        });
+        std::cout << "shader objects enabled: " << shader_object_device.shader_object_enabled() << std::endl;
+        if (ret = tests::tesselation_shaders(shader_object_device); ret != 0)
+        {
+            return ret;
+        }
+        if (ret = tests::raster_draw(shader_object_device); ret != 0)
+        {
+            return ret;
+        }
+    }
+    // Raster pipelines sharing shaders and state share their pipeline library parts.
+    {
+        daxa::Device pipeline_library_device = daxa_ctx.create_device({
+            .enable_graphics_pipeline_library = true,
+            .name = APPNAME_PREFIX("pipeline library device"),
+        });
+        std::cout << "graphics pipeline library enabled: " << pipeline_library_device.graphics_pipeline_library_enabled() << std::endl;
+        if (ret = tests::tesselation_shaders(pipeline_library_device); ret != 0)
+        {
+            return ret;
+        }
+        if (ret = tests::dynamic_state(pipeline_library_device); ret != 0)
+        {
+            return ret;
+        }
+    }
+    // Optimized links run inline, so that their references to the pipeline library parts are released right away.
+    {
+        daxa::Device inline_link_device = daxa_ctx.create_device({
+            .enable_graphics_pipeline_library = true,
+            .pipeline_compile_executor = [](std::function<void()> job)
+            { job(); },
+            .name = APPNAME_PREFIX("inline link device"),
+        });
+        if (ret = tests::pipeline_library_reuse(inline_link_device); ret != 0)
+        {
+            return ret;
+        }
+    }
 
     std::cout << "Success!" << std::endl;
     return ret;
@@ -2,7 +2,9 @@
 using namespace daxa::types;
 
 #include <daxa/utils/mem.hpp>
+#include <daxa/utils/pipeline_manager.hpp>
 
+#include <deque>
 #include <iostream>
 
 static inline constexpr usize ITERATION_COUNT = {1000};
@@ -90,6 +92,328 @@ auto main() -> int
             std::cout << "value: " << elements[iteration * ELEMENT_COUNT + element] / 100 << " " << elements[iteration * ELEMENT_COUNT + element] % 100 << "\n";
         }
     }
+
+    // A growable pool chains larger blocks instead of failing, the first block is destroyed once the gpu finished with it.
+    {
+        daxa::TransferMemoryPool growable_tmem{daxa::TransferMemoryPoolInfo{
+            .device = device,
+            .capacity = 256,
+            .allow_growth = true,
+            .name = "growable transient memory pool",
+        }};
+        for (u32 i = 0; i < 64; ++i)
+        {
+            daxa::TransferMemoryPool::Allocation alloc = growable_tmem.allocate(sizeof(u32) * ELEMENT_COUNT, 8).value();
+            reinterpret_cast<u32*>(alloc.host_address)[0] = i;
+        }
+        daxa::TransferMemoryPoolStatistics statistics = growable_tmem.statistics();
+        DAXA_DBG_ASSERT_TRUE_M(statistics.grow_count > 0 && statistics.capacity > 256, "pool must have grown");
+        DAXA_DBG_ASSERT_TRUE_M(statistics.high_water_mark >= 64 * sizeof(u32) * ELEMENT_COUNT, "high water mark must cover all live allocations");
+        device.submit_commands({
+            .signal_timeline_semaphores = {{growable_tmem.get_timeline_semaphore(), growable_tmem.timeline_value()}},
+        });
+        device.wait_idle();
+        // Fill the current block, so that the next allocation reclaims the finished blocks.
+        while (growable_tmem.statistics().grow_count == statistics.grow_count)
+        {
+            [[maybe_unused]] auto alloc = growable_tmem.allocate(sizeof(u32) * ELEMENT_COUNT, 8).value();
+            if (growable_tmem.statistics().block_count == 1)
+            {
+                break;
+            }
+        }
+        DAXA_DBG_ASSERT_TRUE_M(growable_tmem.statistics().block_count == 1, "finished blocks must be destroyed");
+        std::cout << "growable pool capacity: " << growable_tmem.statistics().capacity << ", high water mark: " << statistics.high_water_mark << "\n";
+    }
+
+    // The frame linear allocator resets a whole region per frame, once the gpu retired the frame that last used it.
+    {
+        static constexpr u32 FRAME_COUNT = 16;
+        daxa::FrameLinearAllocator frame_allocator{daxa::FrameLinearAllocatorInfo{
+            .device = device,
+            .frames_in_flight = 2,
+            .frame_capacity = 1024,
+            .name = "frame linear allocator",
+        }};
+        daxa::BufferId frame_result_buffer = device.create_buffer({
+            .size = sizeof(u32) * ELEMENT_COUNT * FRAME_COUNT,
+            .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
+            .name = "frame result",
+        });
+        for (u32 frame = 0; frame < FRAME_COUNT; ++frame)
+        {
+            frame_allocator.begin_frame();
+            DAXA_DBG_ASSERT_TRUE_M(frame_allocator.used_size() == 0, "region must be reset at the start of a frame");
+            daxa::CommandList cmd = device.create_command_list({});
+            daxa::FrameLinearAllocator::Allocation alloc = frame_allocator.allocate(sizeof(u32) * ELEMENT_COUNT, 16).value();
+            DAXA_DBG_ASSERT_TRUE_M(alloc.buffer_offset % 16 == 0, "allocation is not aligned");
+            for (u32 i = 0; i < ELEMENT_COUNT; ++i)
+            {
+                reinterpret_cast<u32*>(alloc.host_address)[i] = frame * 100 + i;
+            }
+            cmd.copy_buffer_to_buffer({
+                .src_buffer = frame_allocator.get_buffer(),
+                .src_offset = alloc.buffer_offset,
+                .dst_buffer = frame_result_buffer,
+                .dst_offset = sizeof(u32) * ELEMENT_COUNT * frame,
+                .size = sizeof(u32) * ELEMENT_COUNT,
+            });
+            cmd.pipeline_barrier({
+                .src_access = daxa::AccessConsts::TRANSFER_WRITE,
+                .dst_access = daxa::AccessConsts::HOST_READ,
+            });
+            cmd.complete();
+            device.submit_commands({
+                .command_lists{std::move(cmd)},
+                .signal_timeline_semaphores = {{frame_allocator.get_timeline_semaphore(), frame_allocator.timeline_value()}},
+            });
+        }
+        device.wait_idle();
+        u32 const * frame_results = device.get_host_address_as<u32>(frame_result_buffer);
+        for (u32 frame = 0; frame < FRAME_COUNT; ++frame)
+        {
+            DAXA_DBG_ASSERT_TRUE_M(frame_results[frame * ELEMENT_COUNT + ELEMENT_COUNT - 1] == frame * 100 + ELEMENT_COUNT - 1, "frame data was overwritten before the gpu consumed it");
+        }
+        device.destroy_buffer(frame_result_buffer);
+    }
+
+    // The upload batcher merges many small writes into one copy per buffer, or into one scatter dispatch.
+    {
+        static constexpr u32 UPLOAD_COUNT = 128;
+        daxa::TransferMemoryPool staging_memory{daxa::TransferMemoryPoolInfo{
+            .device = device,
+            .name = "upload staging memory",
+        }};
+        daxa::PipelineManager pipeline_manager = daxa::PipelineManager{{
+            .device = device,
+            .shader_compile_options = {
+                .root_paths = {DAXA_SHADER_INCLUDE_DIR},
+                .language = daxa::ShaderLanguage::GLSL,
+            },
+            .name = "pipeline manager",
+        }};
+        std::shared_ptr<daxa::ComputePipeline> scatter_pipeline = pipeline_manager.add_compute_pipeline({
+            .shader_info = {
+                .source = daxa::ShaderFile{"daxa/utils/mem.inl"},
+                .compile_options = {.defines = std::vector{daxa::ShaderDefine{"DAXA_UPLOAD_SCATTER_SHADER", "1"}}},
+            },
+            .push_constant_size = sizeof(daxa::UploadScatterPush),
+            .name = "upload scatter",
+        }).value();
+        for (bool const use_scatter : {false, true})
+        {
+            daxa::UploadBatcher batcher{daxa::UploadBatcherInfo{
+                .device = device,
+                .scatter_pipeline = use_scatter ? scatter_pipeline : nullptr,
+                .scatter_min_count = 1,
+                .name = "upload batcher",
+            }};
+            daxa::BufferId upload_buffer = device.create_buffer({
+                .size = sizeof(u32) * 2 * UPLOAD_COUNT,
+                .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
+                .name = "upload destination",
+            });
+            // Every second word is written in reverse order, so that the writes must be sorted and can not be merged.
+            for (u32 i = 0; i < UPLOAD_COUNT; ++i)
+            {
+                u32 const index = UPLOAD_COUNT - 1 - i;
+                batcher.write_as<u32>(upload_buffer, sizeof(u32) * 2 * index, index);
+            }
+            // Overlapping writes are applied in order.
+            batcher.write_as<u32>(upload_buffer, 0, 1234);
+            daxa::CommandList cmd = device.create_command_list({});
+            bool const recorded = batcher.record(cmd, staging_memory, daxa::AccessConsts::HOST_READ);
+            if (!recorded)
+            {
+                std::cerr << "staging memory must fit all writes" << std::endl;
+                return -1;
+            }
+            cmd.complete();
+            device.submit_commands({
+                .command_lists{std::move(cmd)},
+                .signal_timeline_semaphores = {{staging_memory.get_timeline_semaphore(), staging_memory.timeline_value()}},
+            });
+            device.wait_idle();
+            u32 const * uploaded = device.get_host_address_as<u32>(upload_buffer);
+            DAXA_DBG_ASSERT_TRUE_M(uploaded[0] == 1234, "later overlapping write must win");
+            for (u32 i = 1; i < UPLOAD_COUNT; ++i)
+            {
+                DAXA_DBG_ASSERT_TRUE_M(uploaded[i * 2] == i, "uploaded value does not match the written value");
+            }
+            device.destroy_buffer(upload_buffer);
+        }
+    }
+
+    // The mirror buffer only uploads the chunks that changed since the last update.
+    {
+        static constexpr u32 MIRROR_ELEMENT_COUNT = 1 << 14;
+        daxa::TransferMemoryPool staging_memory{daxa::TransferMemoryPoolInfo{
+            .device = device,
+            .name = "mirror staging memory",
+        }};
+        daxa::GpuMirrorBuffer mirror{daxa::GpuMirrorBufferInfo{
+            .device = device,
+            .size = sizeof(u32) * MIRROR_ELEMENT_COUNT,
+            .dirty_granularity = 256,
+            .name = "mirror",
+        }};
+        daxa::BufferId mirror_readback_buffer = device.create_buffer({
+            .size = sizeof(u32) * MIRROR_ELEMENT_COUNT,
+            .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
+            .name = "mirror readback",
+        });
+        auto update_mirror = [&]() -> bool
+        {
+            daxa::CommandList cmd = device.create_command_list({});
+            bool const up_to_date = mirror.record_updates(cmd, staging_memory, daxa::AccessConsts::TRANSFER_READ);
+            if (!up_to_date)
+            {
+                std::cerr << "staging memory must fit all dirty chunks" << std::endl;
+                return false;
+            }
+            cmd.copy_buffer_to_buffer({
+                .src_buffer = mirror.get_buffer(),
+                .dst_buffer = mirror_readback_buffer,
+                .size = sizeof(u32) * MIRROR_ELEMENT_COUNT,
+            });
+            cmd.pipeline_barrier({
+                .src_access = daxa::AccessConsts::TRANSFER_WRITE,
+                .dst_access = daxa::AccessConsts::HOST_READ,
+            });
+            cmd.complete();
+            device.submit_commands({
+                .command_lists{std::move(cmd)},
+                .signal_timeline_semaphores = {{staging_memory.get_timeline_semaphore(), staging_memory.timeline_value()}},
+            });
+            device.wait_idle();
+            return true;
+        };
+        // The first update uploads the whole shadow copy.
+        u32 * elements = mirror.write_ptr_as<u32>(0, MIRROR_ELEMENT_COUNT);
+        for (u32 i = 0; i < MIRROR_ELEMENT_COUNT; ++i)
+        {
+            elements[i] = i;
+        }
+        DAXA_DBG_ASSERT_TRUE_M(mirror.dirty_size() == sizeof(u32) * MIRROR_ELEMENT_COUNT, "all chunks must be dirty");
+        if (!update_mirror())
+        {
+            return -1;
+        }
+        DAXA_DBG_ASSERT_TRUE_M(mirror.dirty_size() == 0, "no chunk must be dirty after an update");
+        // Afterwards only the touched chunks are uploaded.
+        mirror.write_as<u32>(sizeof(u32) * 5, 1'000'005);
+        mirror.write_as<u32>(sizeof(u32) * 6, 1'000'006);
+        mirror.write_as<u32>(sizeof(u32) * 9'000, 1'009'000);
+        DAXA_DBG_ASSERT_TRUE_M(mirror.dirty_size() == 2 * 256, "only two chunks must be dirty");
+        if (!update_mirror())
+        {
+            return -1;
+        }
+        u32 const * mirrored = device.get_host_address_as<u32>(mirror_readback_buffer);
+        for (u32 i = 0; i < MIRROR_ELEMENT_COUNT; ++i)
+        {
+            u32 const expected = (i == 5 || i == 6 || i == 9'000) ? 1'000'000 + i : i;
+            DAXA_DBG_ASSERT_TRUE_M(mirrored[i] == expected, "gpu copy does not match the shadow copy");
+        }
+        device.destroy_buffer(mirror_readback_buffer);
+    }
+
+    daxa::ReadbackMemoryPool rmem{daxa::ReadbackMemoryPoolInfo{
+        .device = device,
+        .capacity = 256,
+        .name = "readback memory pool",
+    }};
+    std::deque<std::pair<u32, daxa::ReadbackMemoryPool::Allocation>> pending_readbacks = {};
+    u32 readback_count = 0;
+    for (u32 iteration = 0; iteration < ITERATION_COUNT || !pending_readbacks.empty(); ++iteration)
+    {
+        // Finished readbacks are consumed before the next allocation, as mapped pointers are only valid until then.
+        while (!pending_readbacks.empty())
+        {
+            u32 const* values = rmem.try_map_as<u32>(pending_readbacks.front().second);
+            if (values == nullptr)
+            {
+                break;
+            }
+            for (u32 i = 0; i < ELEMENT_COUNT; ++i)
+            {
+                DAXA_DBG_ASSERT_TRUE_M(values[i] == pending_readbacks.front().first, "read back value does not match the written value");
+            }
+            pending_readbacks.pop_front();
+            readback_count += 1;
+        }
+        if (iteration >= ITERATION_COUNT)
+        {
+            gpu_timeline.wait_for_value(cpu_timeline - 1);
+            continue;
+        }
+        // The allocation fails when all memory is still in use by the gpu or waiting to be mapped.
+        std::optional<daxa::ReadbackMemoryPool::Allocation> alloc = rmem.allocate(sizeof(u32) * ELEMENT_COUNT, 4);
+        if (!alloc.has_value())
+        {
+            gpu_timeline.wait_for_value(cpu_timeline - 1);
+            continue;
+        }
+        daxa::CommandList cmd = device.create_command_list({});
+        cmd.clear_buffer({
+            .buffer = rmem.get_buffer(),
+            .offset = alloc->buffer_offset,
+            .size = alloc->size,
+            .clear_value = iteration,
+        });
+        cmd.pipeline_barrier({
+            .src_access = daxa::AccessConsts::TRANSFER_WRITE,
+            .dst_access = daxa::AccessConsts::HOST_READ,
+        });
+        cmd.complete();
+        device.submit_commands({
+            .command_lists{std::move(cmd)},
+            .signal_timeline_semaphores = {
+                {gpu_timeline, cpu_timeline},
+                {rmem.get_timeline_semaphore(), rmem.timeline_value()},
+            },
+        });
+        cpu_timeline += 1;
+        pending_readbacks.push_back({iteration, alloc.value()});
+    }
+    std::cout << "read back " << readback_count << " allocations\n";
+
+    // Discarded allocations are reclaimed without ever being mapped.
+    {
+        std::array<daxa::ReadbackMemoryPool::Allocation, 3> discarded = {};
+        daxa::CommandList cmd = device.create_command_list({});
+        for (auto & allocation : discarded)
+        {
+            std::optional<daxa::ReadbackMemoryPool::Allocation> alloc = rmem.allocate(64, 4);
+            DAXA_DBG_ASSERT_TRUE_M(alloc.has_value(), "the readback pool must be empty after all readbacks were mapped");
+            allocation = alloc.value();
+            cmd.clear_buffer({
+                .buffer = rmem.get_buffer(),
+                .offset = allocation.buffer_offset,
+                .size = allocation.size,
+                .clear_value = 0,
+            });
+        }
+        cmd.complete();
+        device.submit_commands({
+            .command_lists{std::move(cmd)},
+            .signal_timeline_semaphores = {
+                {gpu_timeline, cpu_timeline},
+                {rmem.get_timeline_semaphore(), rmem.timeline_value()},
+            },
+        });
+        gpu_timeline.wait_for_value(cpu_timeline);
+        cpu_timeline += 1;
+        for (auto const & allocation : discarded)
+        {
+            rmem.discard(allocation);
+        }
+        // Only fits when the discarded allocations were reclaimed.
+        std::optional<daxa::ReadbackMemoryPool::Allocation> const alloc = rmem.allocate(rmem.get_info().capacity / 2, 4);
+        DAXA_DBG_ASSERT_TRUE_M(alloc.has_value(), "discarded allocations must be reclaimed once the gpu finished them");
+        rmem.discard(alloc.value());
+    }
+
     device.destroy_buffer(result_buffer);
     device.collect_garbage();
     std::cout << std::flush;